@@ -0,0 +1,238 @@
+#include "bench/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+
+// 运行参数
+#define BENCH_MAX 64
+#define BENCH_MIN_TIME_NS 200000000ULL  // 每个基准至少运行200ms
+#define BENCH_MAX_ITERATIONS 1000000000ULL
+#define BENCH_DEFAULT_THRESHOLD 10.0    // 比基线慢超过10%算退化
+
+struct BenchEntry {
+  const char* name;
+  BenchFn fn;
+};
+
+static BenchEntry benches[BENCH_MAX];
+static size_t benchCount = 0;
+
+// 分配计数，链接时用 --wrap 包装 malloc/calloc/realloc
+static uint64_t allocCount = 0;
+static uint64_t allocBytes = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  allocCount++;
+  allocBytes += size;
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  allocCount++;
+  allocBytes += count * size;
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  allocCount++;
+  allocBytes += size;
+  return __real_realloc(ptr, size);
+}
+}
+
+// new/delete走malloc，这样也能被统计 (libstdc++内部的malloc调用不经过--wrap)
+void* operator new(size_t size) {
+  void* ptr = malloc(size ? size : 1);
+  if (ptr == NULL) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+static uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+BenchRegistration::BenchRegistration(const char* name, BenchFn fn) {
+  if (benchCount < BENCH_MAX) {
+    benches[benchCount].name = name;
+    benches[benchCount].fn = fn;
+    benchCount++;
+  }
+}
+
+// 进入for循环时开始计时
+BenchState::Iterator BenchState::begin() {
+  startAllocs = allocCount;
+  startBytes = allocBytes;
+  startNs = nowNs();
+  return Iterator{this, iterations};
+}
+
+// 循环结束时停止计时
+bool BenchState::Iterator::operator!=(const Iterator&) {
+  if (remaining != 0) {
+    return true;
+  }
+  state->elapsedNs = nowNs() - state->startNs;
+  state->allocs = allocCount - state->startAllocs;
+  state->bytes = allocBytes - state->startBytes;
+  return false;
+}
+
+// 单个基准的结果
+struct BenchResult {
+  char name[64];
+  double nsPerOp;
+  double allocsPerOp;
+  double bytesPerOp;
+};
+
+// 逐步增加次数直到耗时足够长
+static void runBench(const BenchEntry& entry, BenchResult& result) {
+  BenchState state;
+  memset(&state, 0, sizeof(state));
+  uint64_t iterations = 1;
+  for (;;) {
+    state.iterations = iterations;
+    state.elapsedNs = 0;
+    entry.fn(state);
+    if (state.elapsedNs >= BENCH_MIN_TIME_NS || iterations >= BENCH_MAX_ITERATIONS) {
+      break;
+    }
+    // 按已有耗时估计需要的次数，最多放大10倍
+    uint64_t next = iterations * 10;
+    if (state.elapsedNs > 0) {
+      uint64_t estimate = (uint64_t)(iterations * 1.4 * BENCH_MIN_TIME_NS / state.elapsedNs);
+      if (estimate < next) {
+        next = estimate;
+      }
+    }
+    iterations = next > iterations ? next : iterations + 1;
+  }
+  snprintf(result.name, sizeof(result.name), "%s", entry.name);
+  result.nsPerOp = (double)state.elapsedNs / state.iterations;
+  result.allocsPerOp = (double)state.allocs / state.iterations;
+  result.bytesPerOp = (double)state.bytes / state.iterations;
+}
+
+// 在基线文件中查找同名结果，格式与 --csv 输出相同
+static bool findBaseline(FILE* file, const char* name, double& nsPerOp) {
+  char line[256];
+  rewind(file);
+  while (fgets(line, sizeof(line), file)) {
+    char* comma = strchr(line, ',');
+    if (comma == NULL) {
+      continue;
+    }
+    *comma = '\0';
+    if (strcmp(line, name) == 0) {
+      nsPerOp = atof(comma + 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void printUsage(const char* program) {
+  printf("用法: %s [--filter 名称片段] [--csv 输出文件] [--baseline 基线文件] [--threshold 百分比]\n", program);
+}
+
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char** argv) {
+  const char* filter = NULL;
+  const char* csvPath = NULL;
+  const char* baselinePath = NULL;
+  double threshold = BENCH_DEFAULT_THRESHOLD;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+      csvPath = argv[++i];
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baselinePath = argv[++i];
+    } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+      threshold = atof(argv[++i]);
+    } else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  FILE* csv = csvPath ? fopen(csvPath, "w") : NULL;
+  FILE* baseline = baselinePath ? fopen(baselinePath, "r") : NULL;
+  if ((csvPath && csv == NULL) || (baselinePath && baseline == NULL)) {
+    printf("无法打开文件: %s\n", csvPath && csv == NULL ? csvPath : baselinePath);
+    return 2;
+  }
+  if (csv) {
+    fprintf(csv, "name,ns_per_op,allocs_per_op,bytes_per_op\n");
+  }
+
+  printf("%-32s %12s %12s %12s %10s\n", "benchmark", "ns/op", "allocs/op", "bytes/op", "vs base");
+  int regressions = 0;
+  for (size_t i = 0; i < benchCount; i++) {
+    if (filter && strstr(benches[i].name, filter) == NULL) {
+      continue;
+    }
+    BenchResult result;
+    runBench(benches[i], result);
+
+    char delta[16] = "";
+    double baseNs;
+    if (baseline && findBaseline(baseline, result.name, baseNs) && baseNs > 0) {
+      double percent = (result.nsPerOp - baseNs) * 100.0 / baseNs;
+      snprintf(delta, sizeof(delta), "%+.1f%%%s", percent, percent > threshold ? "!" : "");
+      if (percent > threshold) {
+        regressions++;
+      }
+    }
+    printf("%-32s %12.1f %12.2f %12.1f %10s\n", result.name, result.nsPerOp, result.allocsPerOp, result.bytesPerOp, delta);
+    if (csv) {
+      fprintf(csv, "%s,%.1f,%.2f,%.1f\n", result.name, result.nsPerOp, result.allocsPerOp, result.bytesPerOp);
+    }
+  }
+
+  if (csv) {
+    fclose(csv);
+  }
+  if (baseline) {
+    fclose(baseline);
+    if (regressions > 0) {
+      printf("%d 项比基线慢超过 %.0f%%\n", regressions, threshold);
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif
@@ -0,0 +1,62 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 主机基准测试 (env:native) - 测量固件逻辑每次调用的耗时和内存分配
+//
+// 用法:
+//   BENCH(name) {
+//     准备数据...
+//     for (auto _ : state) {
+//       被测代码
+//     }
+//   }
+// 只有for循环内计时和统计分配，运行器自动增加次数直到耗时足够长
+
+// for循环变量的类型，有析构函数所以不会产生未使用变量的警告
+struct BenchValue {
+  ~BenchValue() {}
+};
+
+struct BenchState {
+  uint64_t iterations;  // 本轮执行次数
+  uint64_t startNs;
+  uint64_t elapsedNs;
+  uint64_t startAllocs;
+  uint64_t allocs;
+  uint64_t startBytes;
+  uint64_t bytes;
+
+  struct Iterator {
+    BenchState* state;
+    uint64_t remaining;
+    bool operator!=(const Iterator&);
+    void operator++() { remaining--; }
+    BenchValue operator*() const { return BenchValue(); }
+  };
+
+  Iterator begin();
+  Iterator end() { return Iterator{this, 0}; }
+};
+
+typedef void (*BenchFn)(BenchState& state);
+
+// 注册基准测试 (静态对象构造时调用)
+struct BenchRegistration {
+  BenchRegistration(const char* name, BenchFn fn);
+};
+
+#define BENCH(name) \
+  static void bench_##name(BenchState& state); \
+  static BenchRegistration benchRegistration_##name(#name, bench_##name); \
+  static void bench_##name(BenchState& state)
+
+// 防止编译器把结果优化掉
+template <class T>
+inline void benchKeep(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif
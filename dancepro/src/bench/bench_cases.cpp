@@ -0,0 +1,203 @@
+#include "bench/bench.h"
+#include <Arduino.h>
+#include "imu/imu_fusion.h"
+#include "gesture/gesture.h"
+#include "tempo/tempo.h"
+#include "synth/synth.h"
+#include "metrics/latency.h"
+#include "note/note.h"
+#include "note/note_codec.h"
+
+// 合成的IMU数据: 手腕缓慢摆动加上周期性的甩动，每5ms一个样本 (200Hz)
+#define SAMPLE_COUNT  1024
+#define SAMPLE_PERIOD_US 5000
+
+static IMUSample samples[SAMPLE_COUNT];
+static bool samplesReady = false;
+
+static void makeSamples() {
+  if (samplesReady) {
+    return;
+  }
+  memset(samples, 0, sizeof(samples));
+  for (int i = 0; i < SAMPLE_COUNT; i++) {
+    float t = i * (SAMPLE_PERIOD_US * 1e-6f);
+    IMUData& d = samples[i].data;
+    samples[i].timestamp = i * SAMPLE_PERIOD_US;
+    d.roll = 40.0f * sinf(t * 1.3f);
+    d.pitch = 25.0f * sinf(t * 0.7f + 1.0f);
+    d.yaw = fmodf(t * 10.0f, 360.0f);
+    d.gyroX = 52.0f * cosf(t * 1.3f);
+    d.gyroY = 17.5f * cosf(t * 0.7f + 1.0f);
+    d.gyroZ = 10.0f;
+    float shake = (fmodf(t, 2.0f) < 0.3f) ? 1.5f * sinf(t * 60.0f) : 0.0f;
+    d.accX = 0.3f * sinf(t * 1.3f) + shake;
+    d.accY = 0.2f * sinf(t * 0.7f);
+    d.accZ = 0.9f;
+    d.magX = 30.0f;
+    d.magY = 5.0f;
+    d.magZ = -40.0f;
+  }
+  samplesReady = true;
+}
+
+// 音符映射: 每次调用都距离上一个音符足够久，走完整的生成路径
+BENCH(note_map_generate) {
+  makeSamples();
+  resetNoteComposer(1);
+  NoteEvent event;
+  uint32_t i = 0;
+  for (auto _ : state) {
+    nativeAdvanceMicros(300000);
+    benchKeep(mapIMUToNote(samples[i++ & (SAMPLE_COUNT - 1)].data, event));
+  }
+  benchKeep(event);
+}
+
+// 音符映射: 节流路径 (采样频率远高于音符频率，大部分调用走这里)
+BENCH(note_map_throttled) {
+  makeSamples();
+  resetNoteComposer(1);
+  NoteEvent event;
+  nativeAdvanceMicros(1000000);
+  mapIMUToNote(samples[0].data, event);
+  uint32_t i = 0;
+  for (auto _ : state) {
+    benchKeep(mapIMUToNote(samples[i++ & (SAMPLE_COUNT - 1)].data, event));
+  }
+}
+
+// 姿态融合: 对应 updateIMUData 中每个样本的计算
+static void benchFusion(BenchState& state, FusionAlgorithm algorithm, float gain, bool useMag) {
+  makeSamples();
+  FusionState fusion;
+  fusionInit(fusion, algorithm, gain);
+  uint32_t i = 0;
+  float roll, pitch, yaw;
+  for (auto _ : state) {
+    const IMUData& d = samples[i++ & (SAMPLE_COUNT - 1)].data;
+    fusionUpdate(fusion, d.gyroX, d.gyroY, d.gyroZ, d.accX, d.accY, d.accZ,
+                 useMag ? d.magX : 0.0f, useMag ? d.magY : 0.0f, useMag ? d.magZ : 0.0f,
+                 SAMPLE_PERIOD_US * 1e-6f);
+    fusionGetEuler(fusion, roll, pitch, yaw);
+    benchKeep(roll);
+  }
+}
+
+BENCH(fusion_madgwick_imu) {
+  benchFusion(state, FUSION_MADGWICK, FUSION_DEFAULT_GAIN_MADGWICK, false);
+}
+
+BENCH(fusion_madgwick_marg) {
+  benchFusion(state, FUSION_MADGWICK, FUSION_DEFAULT_GAIN_MADGWICK, true);
+}
+
+BENCH(fusion_mahony_imu) {
+  benchFusion(state, FUSION_MAHONY, FUSION_DEFAULT_GAIN_MAHONY, false);
+}
+
+BENCH(fusion_mahony_marg) {
+  benchFusion(state, FUSION_MAHONY, FUSION_DEFAULT_GAIN_MAHONY, true);
+}
+
+// 手势检测: 每个样本一次
+BENCH(gesture_update) {
+  makeSamples();
+  GestureDetector detector;
+  gestureInit(detector);
+  GestureEvent events[4];
+  IMUSample sample;
+  uint32_t i = 0;
+  for (auto _ : state) {
+    sample = samples[i & (SAMPLE_COUNT - 1)];
+    sample.timestamp = i * SAMPLE_PERIOD_US;
+    i++;
+    benchKeep(gestureUpdate(detector, sample, events, 4));
+  }
+}
+
+// 速度检测: 每个样本一次，每两个样本完成一帧 (包括自相关和找峰值)
+BENCH(tempo_update) {
+  makeSamples();
+  static TempoTracker tracker;
+  tempoInit(tracker);
+  IMUSample sample;
+  uint32_t i = 0;
+  for (auto _ : state) {
+    sample = samples[i & (SAMPLE_COUNT - 1)];
+    sample.timestamp = i * SAMPLE_PERIOD_US;
+    i++;
+    benchKeep(tempoUpdate(tracker, sample));
+  }
+  benchKeep(tracker.bpm);
+}
+
+// 音色合成: 每次操作渲染一个合成块，所有的音都在发声
+BENCH(synth_render_block) {
+  static Synth synth;
+  static int16_t block[SYNTH_BLOCK_FRAMES];
+  synthInit(synth);
+  uint32_t i = 0;
+  for (auto _ : state) {
+    if (!synthActive(synth) || (i & 15) == 0) {
+      synthNoteOn(synth, noteIndexToFreq(24 + (i % 12)), 300);
+    }
+    i++;
+    synthRender(synth, block, SYNTH_BLOCK_FRAMES);
+    benchKeep(block[0]);
+  }
+}
+
+// 延迟直方图: 每次记录一个延迟 (各任务循环结束时的开销)
+BENCH(latency_record) {
+  static LatencyHistogram histogram;
+  latencyReset(histogram);
+  uint32_t i = 0;
+  for (auto _ : state) {
+    latencyRecord(histogram, (i++ * 2654435761u) >> 18);
+  }
+  benchKeep(latencyPercentile(histogram, 99));
+}
+
+// 录制缓冲区: 整个缓冲区的编码/解码/JSON输出，每次操作是一个满缓冲区
+static NoteLog benchLog;
+static uint8_t codecBuffer[NOTE_CODEC_SIZE(NOTE_LOG_CAPACITY)];
+
+static void fillLog() {
+  noteLogReset(benchLog);
+  randomSeed(2);
+  while (!noteLogFull(benchLog)) {
+    NoteEvent event;
+    event.note = (random(8) == 0) ? 0 : noteIndexToFreq(random(NOTE_INDEX_COUNT));
+    event.duration = 150 * (1 + random(8));
+    noteLogAppend(benchLog, event);
+  }
+}
+
+BENCH(note_codec_encode_full_log) {
+  fillLog();
+  for (auto _ : state) {
+    benchKeep(noteEncodeAll(benchLog.events, benchLog.count, codecBuffer, sizeof(codecBuffer)));
+  }
+}
+
+BENCH(note_codec_decode_full_log) {
+  fillLog();
+  size_t size = noteEncodeAll(benchLog.events, benchLog.count, codecBuffer, sizeof(codecBuffer));
+  static NoteEvent decoded[NOTE_LOG_CAPACITY];
+  for (auto _ : state) {
+    benchKeep(noteDecodeAll(codecBuffer, size, decoded, NOTE_LOG_CAPACITY));
+  }
+}
+
+BENCH(note_json_full_log) {
+  fillLog();
+  char buf[32];
+  for (auto _ : state) {
+    size_t total = 0;
+    for (size_t i = 0; i < benchLog.count; i++) {
+      total += noteEventToJSON(benchLog.events[i], buf, sizeof(buf));
+    }
+    benchKeep(total);
+  }
+}
@@ -0,0 +1,88 @@
+#include "event/event_bus.h"
+
+// 订阅者
+struct EventSubscriber
+{
+  TaskHandle_t task;
+  uint32_t mask;
+};
+
+static EventSubscriber subscribers[EVENT_BUS_MAX_SUBSCRIBERS];
+static volatile int subscriberCount = 0;
+static portMUX_TYPE subscriberMux = portMUX_INITIALIZER_UNLOCKED;
+
+// 订阅事件
+bool subscribeEvents(uint32_t mask, TaskHandle_t task)
+{
+  if (task == NULL)
+  {
+    task = xTaskGetCurrentTaskHandle();
+  }
+
+  bool ok = true;
+  portENTER_CRITICAL(&subscriberMux);
+  int i = 0;
+  for (; i < subscriberCount; i++)
+  {
+    if (subscribers[i].task == task)
+    {
+      subscribers[i].mask |= mask;
+      break;
+    }
+  }
+  if (i == subscriberCount)
+  {
+    if (subscriberCount < EVENT_BUS_MAX_SUBSCRIBERS)
+    {
+      // 先写入条目再增加计数，发布者不加锁也能读到完整条目
+      subscribers[i].task = task;
+      subscribers[i].mask = mask;
+      subscriberCount = i + 1;
+    }
+    else
+    {
+      ok = false;
+    }
+  }
+  portEXIT_CRITICAL(&subscriberMux);
+  return ok;
+}
+
+// 发布事件
+void postEvent(uint32_t events)
+{
+  int count = subscriberCount;
+  for (int i = 0; i < count; i++)
+  {
+    uint32_t matched = subscribers[i].mask & events;
+    if (matched)
+    {
+      xTaskNotify(subscribers[i].task, matched, eSetBits);
+    }
+  }
+}
+
+// 在中断中发布事件
+void postEventFromISR(uint32_t events, BaseType_t *higherPriorityTaskWoken)
+{
+  int count = subscriberCount;
+  for (int i = 0; i < count; i++)
+  {
+    uint32_t matched = subscribers[i].mask & events;
+    if (matched)
+    {
+      xTaskNotifyFromISR(subscribers[i].task, matched, eSetBits, higherPriorityTaskWoken);
+    }
+  }
+}
+
+// 阻塞等待事件
+uint32_t waitEvents(TickType_t timeout)
+{
+  uint32_t events = 0;
+  if (xTaskNotifyWait(0, 0xFFFFFFFFUL, &events, timeout) != pdTRUE)
+  {
+    return 0;
+  }
+  return events;
+}
@@ -0,0 +1,33 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+
+// 事件总线 - 基于任务通知，事件以位掩码表示，可以一次发布多个
+// 任务订阅关心的事件后阻塞等待，不再定时轮询全局变量
+
+// 事件类型
+#define EVENT_PAGE_CHANGED  (1UL << 0) // 页面切换
+#define EVENT_RECORD_START  (1UL << 1) // 开始录制
+#define EVENT_RECORD_STOP   (1UL << 2) // 停止录制
+#define EVENT_WIFI_CHANGED  (1UL << 3) // WiFi状态变化 (getWiFiStatus)
+#define EVENT_WIFI_LINK     (1UL << 4) // WiFi驱动层连接/断开
+#define EVENT_NOTE_ADDED    (1UL << 5) // 录制了新音符
+#define EVENT_BUTTON        (1UL << 6) // 按键电平变化
+
+// 最多订阅者数量
+#define EVENT_BUS_MAX_SUBSCRIBERS 8
+
+// 订阅事件，task为NULL时订阅当前任务，重复订阅会合并掩码
+bool subscribeEvents(uint32_t mask, TaskHandle_t task = NULL);
+
+// 发布事件，通知所有订阅了其中任一事件的任务
+void postEvent(uint32_t events);
+
+// 在中断中发布事件
+void postEventFromISR(uint32_t events, BaseType_t *higherPriorityTaskWoken);
+
+// 阻塞等待当前任务订阅的事件，返回收到的事件位，超时返回0
+uint32_t waitEvents(TickType_t timeout);
+
+#endif
@@ -0,0 +1,178 @@
+#include "gesture/gesture.h"
+#include <math.h>
+#include <string.h>
+
+// 角度差归一化到 [-180, 180)
+static float wrapAngle(float angle) {
+  while (angle >= 180.0f) angle -= 360.0f;
+  while (angle < -180.0f) angle += 360.0f;
+  return angle;
+}
+
+// 写入一个事件
+static void emit(GestureType type, uint32_t timestamp, GestureEvent* events, size_t maxEvents, size_t& count) {
+  if (count < maxEvents) {
+    events[count].type = type;
+    events[count].timestamp = timestamp;
+    count++;
+  }
+}
+
+// 初始化检测器
+void gestureInit(GestureDetector& detector) {
+  memset(&detector, 0, sizeof(detector));
+  detector.flipState = FLIP_NEUTRAL;
+}
+
+// 翻转检测
+static void updateFlip(GestureDetector& d, uint32_t ts, float roll, float dt,
+                       GestureEvent* events, size_t maxEvents, size_t& count) {
+  float rollRate = (dt > 0) ? fabsf(wrapAngle(roll - d.lastRoll)) / dt : 0;
+  d.lastRoll = roll;
+
+  if (d.flipState == FLIP_NEUTRAL) {
+    float delta = wrapAngle(roll - d.baseRoll);
+    bool debounced = (ts - d.flipTime) >= GESTURE_FLIP_DEBOUNCE_US;
+    if (debounced && delta > GESTURE_FLIP_THRESHOLD) {
+      emit(GESTURE_FLIP_UP, ts, events, maxEvents, count);
+      d.flipState = FLIP_UP;
+      d.flipTime = ts;
+      d.flipSettling = false;
+    } else if (debounced && delta < -GESTURE_FLIP_THRESHOLD) {
+      emit(GESTURE_FLIP_DOWN, ts, events, maxEvents, count);
+      d.flipState = FLIP_DOWN;
+      d.flipTime = ts;
+      d.flipSettling = false;
+    } else {
+      // 基准缓慢跟随，慢慢转动手腕不会触发
+      float alpha = dt / GESTURE_FLIP_BASE_TAU;
+      if (alpha > 1.0f) alpha = 1.0f;
+      d.baseRoll = wrapAngle(d.baseRoll + delta * alpha);
+    }
+    return;
+  }
+
+  // 已翻转: 等待手腕稳定后回到中立，并以当前角度为新基准
+  if (rollRate < GESTURE_FLIP_SETTLE_RATE) {
+    if (!d.flipSettling) {
+      d.flipSettling = true;
+      d.flipSettleSince = ts;
+    } else if (ts - d.flipSettleSince >= GESTURE_FLIP_SETTLE_US) {
+      d.flipState = FLIP_NEUTRAL;
+      d.baseRoll = roll;
+    }
+  } else {
+    d.flipSettling = false;
+  }
+}
+
+// 甩动检测
+static void updateShake(GestureDetector& d, uint32_t ts, float accDev,
+                        GestureEvent* events, size_t maxEvents, size_t& count) {
+  if (accDev > GESTURE_SHAKE_ACC) {
+    if (!d.shakeAbove) {
+      // 新的峰值
+      d.shakeAbove = true;
+      if (d.shakePeaks == 0 || ts - d.shakeFirstPeak > GESTURE_SHAKE_WINDOW_US) {
+        d.shakePeaks = 1;
+        d.shakeFirstPeak = ts;
+      } else {
+        d.shakePeaks++;
+      }
+      if (d.shakePeaks >= GESTURE_SHAKE_PEAKS && ts - d.shakeTime >= GESTURE_SHAKE_COOLDOWN_US) {
+        emit(GESTURE_SHAKE, ts, events, maxEvents, count);
+        d.shakeTime = ts;
+        d.shakePeaks = 0;
+      }
+    }
+  } else if (accDev < GESTURE_SHAKE_ACC * 0.5f) {
+    // 回落到一半以下才算峰值结束，避免抖动重复计数
+    d.shakeAbove = false;
+  }
+}
+
+// 轻敲检测
+static void updateTap(GestureDetector& d, uint32_t ts, float accDev,
+                      GestureEvent* events, size_t maxEvents, size_t& count) {
+  if (accDev > GESTURE_TAP_ACC) {
+    if (!d.tapInSpike) {
+      d.tapInSpike = true;
+      d.tapSpikeStart = ts;
+      // 离上一个尖峰太近 (甩动或连续碰撞)，两个都不算
+      d.tapRejected = d.tapPending || (ts - d.tapSpikeEnd < GESTURE_TAP_QUIET_US);
+      d.tapPending = false;
+    }
+  } else if (d.tapInSpike && accDev < GESTURE_TAP_ACC * 0.25f) {
+    d.tapInSpike = false;
+    d.tapSpikeEnd = ts;
+    d.tapPending = !d.tapRejected && (ts - d.tapSpikeStart <= GESTURE_TAP_MAX_US);
+  }
+
+  // 尖峰之后保持安静才确认
+  if (d.tapPending && ts - d.tapSpikeEnd >= GESTURE_TAP_QUIET_US) {
+    d.tapPending = false;
+    emit(GESTURE_TAP, ts, events, maxEvents, count);
+  }
+}
+
+// 静止检测
+static void updateHold(GestureDetector& d, uint32_t ts, float gyroMag, float accDev,
+                       GestureEvent* events, size_t maxEvents, size_t& count) {
+  if (gyroMag < GESTURE_HOLD_GYRO && accDev < GESTURE_HOLD_ACC) {
+    if (!d.holdStill) {
+      d.holdStill = true;
+      d.holdSince = ts;
+    } else if (!d.holdFired && ts - d.holdSince >= GESTURE_HOLD_US) {
+      // 每次静止只触发一次
+      d.holdFired = true;
+      emit(GESTURE_HOLD, ts, events, maxEvents, count);
+    }
+  } else {
+    d.holdStill = false;
+    d.holdFired = false;
+  }
+}
+
+// 输入一个样本
+size_t gestureUpdate(GestureDetector& detector, const IMUSample& sample, GestureEvent* events, size_t maxEvents) {
+  const IMUData& imu = sample.data;
+  uint32_t ts = sample.timestamp;
+
+  if (!detector.started) {
+    // 第一个样本只建立基准
+    detector.started = true;
+    detector.lastTimestamp = ts;
+    detector.baseRoll = imu.roll;
+    detector.lastRoll = imu.roll;
+    detector.flipTime = ts - GESTURE_FLIP_DEBOUNCE_US;
+    detector.shakeTime = ts - GESTURE_SHAKE_COOLDOWN_US;
+    detector.tapSpikeEnd = ts - GESTURE_TAP_QUIET_US;
+    return 0;
+  }
+
+  float dt = (ts - detector.lastTimestamp) * 1e-6f;
+  detector.lastTimestamp = ts;
+
+  float accMag = sqrtf(imu.accX * imu.accX + imu.accY * imu.accY + imu.accZ * imu.accZ);
+  float accDev = fabsf(accMag - 1.0f);
+  float gyroMag = sqrtf(imu.gyroX * imu.gyroX + imu.gyroY * imu.gyroY + imu.gyroZ * imu.gyroZ);
+
+  size_t count = 0;
+  updateFlip(detector, ts, imu.roll, dt, events, maxEvents, count);
+  updateShake(detector, ts, accDev, events, maxEvents, count);
+  updateTap(detector, ts, accDev, events, maxEvents, count);
+  updateHold(detector, ts, gyroMag, accDev, events, maxEvents, count);
+  return count;
+}
+
+// 手势名称
+const char* gestureName(GestureType type) {
+  switch (type) {
+    case GESTURE_FLIP_UP:   return "flip_up";
+    case GESTURE_FLIP_DOWN: return "flip_down";
+    case GESTURE_SHAKE:     return "shake";
+    case GESTURE_TAP:       return "tap";
+    case GESTURE_HOLD:      return "hold";
+    default:                return "unknown";
+  }
+}
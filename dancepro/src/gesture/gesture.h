@@ -0,0 +1,94 @@
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "imu/imu_sampler.h"
+
+// 手势检测 - 每种手势一个小状态机，逐个样本驱动
+// 只依赖样本数据和时间戳，不依赖硬件，可以用录制的IMU数据回放
+
+// 手势类型
+enum GestureType {
+  GESTURE_FLIP_UP,    // 手腕向上翻转
+  GESTURE_FLIP_DOWN,  // 手腕向下翻转
+  GESTURE_SHAKE,      // 快速甩动
+  GESTURE_TAP,        // 轻敲
+  GESTURE_HOLD        // 保持静止
+};
+
+// 手势事件
+struct GestureEvent {
+  GestureType type;
+  uint32_t timestamp;  // 触发时的样本时间戳 (us)
+};
+
+// 翻转检测状态
+enum FlipState {
+  FLIP_NEUTRAL,  // 中立
+  FLIP_UP,       // 已向上翻转
+  FLIP_DOWN      // 已向下翻转
+};
+
+// 检测器状态
+struct GestureDetector {
+  bool started;
+  uint32_t lastTimestamp;
+
+  // 翻转: 中立时roll基准缓慢跟随，快速偏离基准超过阈值即触发
+  FlipState flipState;
+  float baseRoll;
+  float lastRoll;
+  uint32_t flipTime;         // 上次翻转时间
+  bool flipSettling;         // 翻转后是否已开始稳定
+  uint32_t flipSettleSince;  // 开始稳定的时间
+
+  // 甩动: 短时间内多次加速度峰值
+  uint8_t shakePeaks;
+  bool shakeAbove;           // 当前是否处于峰值中
+  uint32_t shakeFirstPeak;
+  uint32_t shakeTime;        // 上次甩动时间
+
+  // 轻敲: 短促的加速度尖峰，前后一段时间没有其它尖峰
+  bool tapInSpike;
+  bool tapRejected;          // 当前尖峰离上一个太近，不算轻敲
+  bool tapPending;           // 等待安静期结束后确认
+  uint32_t tapSpikeStart;
+  uint32_t tapSpikeEnd;
+
+  // 静止
+  bool holdStill;
+  bool holdFired;
+  uint32_t holdSince;
+};
+
+// 检测参数
+#define GESTURE_FLIP_THRESHOLD     20.0f     // 翻转角度阈值 (度)
+#define GESTURE_FLIP_SETTLE_RATE   30.0f     // 翻转后回到稳定的角速度 (dps)
+#define GESTURE_FLIP_SETTLE_US     100000UL  // 稳定持续时间
+#define GESTURE_FLIP_DEBOUNCE_US   300000UL  // 两次翻转的最小间隔
+#define GESTURE_FLIP_BASE_TAU      0.5f      // 中立时基准跟随的时间常数 (s)
+
+#define GESTURE_SHAKE_ACC          1.0f      // 甩动峰值 (偏离1g的幅度, g)
+#define GESTURE_SHAKE_PEAKS        3         // 触发需要的峰值数
+#define GESTURE_SHAKE_WINDOW_US    600000UL  // 峰值需要落在的时间窗
+#define GESTURE_SHAKE_COOLDOWN_US  1000000UL
+
+#define GESTURE_TAP_ACC            2.0f      // 轻敲尖峰 (偏离1g的幅度, g)
+#define GESTURE_TAP_MAX_US         50000UL   // 尖峰最长持续时间
+#define GESTURE_TAP_QUIET_US       150000UL  // 尖峰后需要安静的时间
+
+#define GESTURE_HOLD_GYRO          10.0f     // 静止的角速度上限 (dps)
+#define GESTURE_HOLD_ACC           0.1f      // 静止的加速度偏差上限 (g)
+#define GESTURE_HOLD_US            1500000UL // 静止持续时间
+
+// 初始化检测器
+void gestureInit(GestureDetector& detector);
+
+// 输入一个样本，返回产生的事件数 (写入events，最多maxEvents个)
+size_t gestureUpdate(GestureDetector& detector, const IMUSample& sample, GestureEvent* events, size_t maxEvents);
+
+// 手势名称，用于日志
+const char* gestureName(GestureType type);
+
+#endif
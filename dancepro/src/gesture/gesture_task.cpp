@@ -0,0 +1,75 @@
+#include "gesture/gesture_task.h"
+#include <M5Unified.h>
+#include "tasks/task_plan.h"
+
+// 手势事件队列
+static QueueHandle_t gestureQueue = NULL;
+static TaskHandle_t gestureTaskHandle = NULL;
+
+// 手势检测任务，按固定周期批量处理新样本
+static void gestureTask(void *pvParameters)
+{
+  static IMUSample samples[32];
+  GestureDetector detector;
+  GestureEvent events[4];
+  gestureInit(detector);
+
+  uint32_t cursor = getIMUSampleCursor();
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;)
+  {
+    size_t count;
+    while ((count = readIMUSamples(cursor, samples, 32)) > 0)
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        size_t eventCount = gestureUpdate(detector, samples[i], events, 4);
+        for (size_t j = 0; j < eventCount; j++)
+        {
+          // 队列满时丢弃，不阻塞检测
+          if (xQueueSend(gestureQueue, &events[j], 0) != pdPASS)
+          {
+            M5.Log.printf("[Gesture] 事件队列已满，丢弃: %s\n", gestureName(events[j].type));
+          }
+        }
+      }
+    }
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(GESTURE_POLL_MS));
+  }
+}
+
+// 启动手势检测任务
+bool startGestureTask()
+{
+  if (gestureTaskHandle != NULL)
+  {
+    return true;
+  }
+  if (gestureQueue == NULL)
+  {
+    gestureQueue = xQueueCreate(GESTURE_QUEUE_LENGTH, sizeof(GestureEvent));
+    if (gestureQueue == NULL)
+    {
+      M5.Log.println("[Gesture] 事件队列创建失败");
+      return false;
+    }
+  }
+  if (!createPlannedTask(TASK_GESTURE, gestureTask, NULL, &gestureTaskHandle))
+  {
+    M5.Log.println("[Gesture] 检测任务创建失败");
+    gestureTaskHandle = NULL;
+    return false;
+  }
+  return true;
+}
+
+// 阻塞等待手势事件
+bool waitGestureEvent(GestureEvent &event, TickType_t timeout)
+{
+  if (gestureQueue == NULL)
+  {
+    vTaskDelay(timeout == portMAX_DELAY ? pdMS_TO_TICKS(100) : timeout);
+    return false;
+  }
+  return xQueueReceive(gestureQueue, &event, timeout) == pdTRUE;
+}
@@ -0,0 +1,18 @@
+#ifndef GESTURE_TASK_H
+#define GESTURE_TASK_H
+
+#include <Arduino.h>
+#include "gesture/gesture.h"
+
+// 检测任务的唤醒周期 (ms)，决定手势响应延迟的上限
+#define GESTURE_POLL_MS      10
+// 手势事件队列长度
+#define GESTURE_QUEUE_LENGTH 8
+
+// 启动手势检测任务，从IMU环形缓冲区读取样本，检测到的手势发送到事件队列
+bool startGestureTask();
+
+// 阻塞等待手势事件，超时返回false
+bool waitGestureEvent(GestureEvent &event, TickType_t timeout);
+
+#endif
@@ -1,4 +1,5 @@
 #include "home/home_ui.h"
+#include "ui/ui_widget.h"
 
 // Color definitions
 #define COLOR_BG            0x0000  // Black background
@@ -21,7 +22,7 @@ bool homeUIRedrawNeeded = true;
 // 静态变量用于动画和状态跟踪
 static unsigned long lastAnimationTime = 0;
 static unsigned long lastTimeUpdateTime = 0;
-static int animationFrame = 0;
+static int32_t animationFrame = 0;
 static bool timeInitialized = false;
 
 // 用于保持时间的变量
@@ -32,9 +33,15 @@ static String cachedTimeStr = "00:00";  // 缓存的时间字符串
 // 状态栏高度
 #define STATUS_BAR_HEIGHT 20
 
+// 状态栏控件: 时间、电池和动画区域
+enum { HOME_TIME, HOME_BATTERY, HOME_ANIM, HOME_WIDGET_COUNT };
+static UIWidget homeWidgets[HOME_WIDGET_COUNT];
+static bool homeWidgetsReady = false;
+
 // 动画区域参数
 #define ANIM_MAX_RADIUS 50  // 动画最大半径
 #define ANIM_CENTER_Y ((M5.Display.height() + STATUS_BAR_HEIGHT) / 2 + 10)  // 动画中心Y坐标，下移一点
+#define ANIM_STEP_MS 100    // 动画参数按每100ms一帧设计
 
 // NTP服务器设置
 const char* ntpServer = "pool.ntp.org";
@@ -42,12 +49,9 @@ const long  gmtOffset_sec = 28800;  // 东八区 (UTC+8)
 const int   daylightOffset_sec = 0;
 
 // 前向声明辅助函数
-void drawSimpleMusicNote(int centerX, int centerY, int frame);
-void drawCircleToBuffer(uint16_t* buffer, int bufWidth, int bufHeight, int x0, int y0, int radius, uint16_t color);
-void drawRectToBuffer(uint16_t* buffer, int bufWidth, int bufHeight, int x, int y, int w, int h, uint16_t color);
-void drawLineToBuffer(uint16_t* buffer, int bufWidth, int bufHeight, int x0, int y0, int x1, int y1, uint16_t color);
-void drawMusicNoteToBuffer(uint16_t* buffer, int bufWidth, int bufHeight, int centerX, int centerY, float scale, uint16_t color);
-void drawMusicNoteAnimation(int frame);
+void drawSimpleMusicNote(int centerX, int centerY, float frame);
+void drawMusicNote(LGFX_Sprite& canvas, int centerX, int centerY, float scale, uint16_t color);
+void drawMusicNoteAnimation(int32_t frameIndex);
 
 // 非阻塞方式初始化时间 - 完全不阻塞UI线程
 void initTimeAsync() {
@@ -110,20 +114,21 @@ String getFormattedTime() {
   return cachedTimeStr;
 }
 
-// 绘制状态栏（时间和电池）
-void drawStatusBar() {
-  // 绘制状态栏背景
-  M5.Display.fillRect(0, 0, M5.Display.width(), STATUS_BAR_HEIGHT, COLOR_STATUS_BG);
-  
-  // 绘制时间
-  M5.Display.setTextColor(COLOR_TEXT);
+// 绘制时间: 文本带背景色绘制，不需要先清除
+static void drawTimeWidget(const UIWidget& widget) {
+  M5.Display.setTextColor(COLOR_TEXT, COLOR_STATUS_BG);
   M5.Display.setTextSize(1);
-  M5.Display.setCursor(5, 6);
+  M5.Display.setCursor(widget.bounds.x, widget.bounds.y);
   M5.Display.print(getFormattedTime());
+}
+
+// 绘制电池状态: value低8位为电量，第8位为是否充电
+static void drawBatteryWidget(const UIWidget& widget) {
+  float batteryLevel = widget.value & 0xFF;
+  bool isCharging = (widget.value >> 8) & 1;
   
-  // 绘制电池状态
-  float batteryLevel = M5.Power.getBatteryLevel();
-  bool isCharging = M5.Power.isCharging();
+  // 只有电量或充电状态变化时才会重绘，清除整个电池区域
+  M5.Display.fillRect(widget.bounds.x, widget.bounds.y, widget.bounds.w, widget.bounds.h, COLOR_STATUS_BG);
   
   // 电池外框
   int battX = M5.Display.width() - 30;
@@ -172,64 +177,50 @@ void drawStatusBar() {
   }
 }
 
-// 绘制音符律动动画 - 优化版本，防止屏闪
-void drawMusicNoteAnimation(int frame) {
-  int centerX = M5.Display.width() / 2;
-  int centerY = ANIM_CENTER_Y;
-  
-  // 创建双缓冲区，减少屏闪
-  static uint16_t* animBuffer = NULL;
-  static int lastBufferWidth = 0;
-  static int lastBufferHeight = 0;
-  
-  // 计算动画区域大小
-  int animWidth = M5.Display.width();
-  int animHeight = M5.Display.height() - STATUS_BAR_HEIGHT;
-  int animStartY = STATUS_BAR_HEIGHT;
-  
-  // 如果缓冲区未初始化或大小改变，重新分配
-  if (animBuffer == NULL || lastBufferWidth != animWidth || lastBufferHeight != animHeight) {
-    if (animBuffer != NULL) {
-      free(animBuffer);
-    }
-    animBuffer = (uint16_t*)malloc(animWidth * animHeight * sizeof(uint16_t));
-    lastBufferWidth = animWidth;
-    lastBufferHeight = animHeight;
-    
-    // 如果内存分配失败，直接在屏幕上绘制
-    if (animBuffer == NULL) {
-      // 清除整个动画区域
-      M5.Display.fillRect(0, STATUS_BAR_HEIGHT, M5.Display.width(), 
-                         M5.Display.height() - STATUS_BAR_HEIGHT, COLOR_BG);
-      
-      // 简化版动画，减少复杂度
-      drawSimpleMusicNote(centerX, centerY, frame);
-      return;
-    }
+// 绘制动画区域: value为帧序号
+static void drawAnimWidget(const UIWidget& widget) {
+  drawMusicNoteAnimation(widget.value);
+}
+
+// 创建控件，屏幕尺寸在M5.begin之后才确定
+static void initHomeWidgets() {
+  int width = M5.Display.width();
+  uiWidgetInit(homeWidgets[HOME_TIME], 5, 6, 30, 8, COLOR_STATUS_BG, drawTimeWidget);
+  uiWidgetInit(homeWidgets[HOME_BATTERY], width - 60, 0, 60, STATUS_BAR_HEIGHT, COLOR_STATUS_BG, drawBatteryWidget);
+  uiWidgetInit(homeWidgets[HOME_ANIM], 0, STATUS_BAR_HEIGHT, width, M5.Display.height() - STATUS_BAR_HEIGHT, COLOR_BG, drawAnimWidget);
+  homeWidgetsReady = true;
+}
+
+// 计算动画帧对应的音符颜色
+static uint16_t noteColorForFrame(float frame) {
+  switch ((int)(frame / 30) % 6) {
+    case 0: return COLOR_NOTE1;
+    case 1: return COLOR_NOTE2;
+    case 2: return COLOR_NOTE3;
+    case 3: return COLOR_NOTE4;
+    case 4: return COLOR_NOTE5;
+    case 5: return COLOR_BATTERY_LOW;
+    default: return COLOR_TEXT;
   }
+}
+
+// 在精灵中绘制一帧音符律动动画，坐标相对动画区域
+static void renderMusicNoteFrame(LGFX_Sprite& canvas, float frame) {
+  int animWidth = canvas.width();
+  int animHeight = canvas.height();
+  int centerX = animWidth / 2;
+  int centerY = ANIM_CENTER_Y - STATUS_BAR_HEIGHT;
   
-  // 填充缓冲区背景色
-  for (int i = 0; i < animWidth * animHeight; i++) {
-    animBuffer[i] = COLOR_BG;
-  }
+  canvas.fillScreen(COLOR_BG);
   
   // 动态音符颜色
-  uint16_t noteColor;
-  switch ((frame / 30) % 6) {
-    case 0: noteColor = COLOR_NOTE1; break;
-    case 1: noteColor = COLOR_NOTE2; break;
-    case 2: noteColor = COLOR_NOTE3; break;
-    case 3: noteColor = COLOR_NOTE4; break;
-    case 4: noteColor = COLOR_NOTE5; break;
-    case 5: noteColor = COLOR_BATTERY_LOW; break;
-    default: noteColor = COLOR_TEXT; break;
-  }
+  uint16_t noteColor = noteColorForFrame(frame);
   
   // 音符大小随动画帧变化 - 使用正弦函数实现平滑律动
   float scale = 1.0 + 0.15 * sin(frame * 0.05);
   
   // 绘制中央音符
-  drawMusicNoteToBuffer(animBuffer, animWidth, animHeight, centerX, centerY - animStartY, scale, noteColor);
+  drawMusicNote(canvas, centerX, centerY, scale, noteColor);
   
   // 绘制音波
   for (int i = 0; i < 3; i++) {
@@ -239,14 +230,14 @@ void drawMusicNoteAnimation(int frame) {
     for (int angle = 0; angle < 360; angle += 30) {
       float radian = (angle + waveOffset * 10) * PI / 180.0;
       int x1 = centerX + waveRadius * cos(radian);
-      int y1 = (centerY + waveRadius * sin(radian)) - animStartY;
+      int y1 = centerY + waveRadius * sin(radian);
       int x2 = centerX + (waveRadius + 5) * cos(radian);
-      int y2 = (centerY + (waveRadius + 5) * sin(radian)) - animStartY;
+      int y2 = centerY + (waveRadius + 5) * sin(radian);
       
-      // 确保点在缓冲区内
+      // 只画完整落在动画区域内的音波
       if (x1 >= 0 && x1 < animWidth && y1 >= 0 && y1 < animHeight &&
           x2 >= 0 && x2 < animWidth && y2 >= 0 && y2 < animHeight) {
-        drawLineToBuffer(animBuffer, animWidth, animHeight, x1, y1, x2, y2, noteColor);
+        canvas.drawLine(x1, y1, x2, y2, noteColor);
       }
     }
   }
@@ -259,31 +250,27 @@ void drawMusicNoteAnimation(int frame) {
     float angle = decorAngle + i * (2 * PI / 5);
     int radius = 35 * scale;
     int x = centerX + radius * cos(angle);
-    int y = (centerY + radius * sin(angle)) - animStartY;
+    int y = centerY + radius * sin(angle);
     
-    // 确保在缓冲区范围内
+    // 确保在动画区域范围内
     if (x >= decorSize && x < animWidth - decorSize && 
         y >= decorSize && y < animHeight - decorSize) {
       
       // 交替绘制不同形状的装饰
       if (i % 2 == 0) {
         // 小音符
-        drawCircleToBuffer(animBuffer, animWidth, animHeight, x, y, decorSize, noteColor);
+        canvas.fillCircle(x, y, decorSize, noteColor);
         
         // 小音符杆
         int miniStemLength = 8 * scale;
-        if (y - miniStemLength >= 0) {
-          drawRectToBuffer(animBuffer, animWidth, animHeight, 
-                        x + decorSize - 1, y - miniStemLength, 
-                        1, miniStemLength, noteColor);
-        }
+        canvas.fillRect(x + decorSize - 1, y - miniStemLength, 1, miniStemLength, noteColor);
       } else {
         // 星形装饰
         for (int j = 0; j < 8; j++) {
           float starAngle = j * PI / 4;
           int x1 = x + decorSize * cos(starAngle);
           int y1 = y + decorSize * sin(starAngle);
-          drawLineToBuffer(animBuffer, animWidth, animHeight, x, y, x1, y1, noteColor);
+          canvas.drawLine(x, y, x1, y1, noteColor);
         }
       }
     }
@@ -295,29 +282,89 @@ void drawMusicNoteAnimation(int frame) {
     float pointAngle = (frame * 0.02 + i * 36) * PI / 180.0;
     float distance = 20 + 20 * sin(frame * 0.03 + i);
     int x = centerX + distance * cos(pointAngle);
-    int y = (centerY + distance * sin(pointAngle)) - animStartY;
-    
-    if (x >= 0 && x < animWidth && y >= 0 && y < animHeight) {
-      animBuffer[y * animWidth + x] = noteColor;
+    int y = centerY + distance * sin(pointAngle);
+    canvas.drawPixel(x, y, noteColor);
+  }
+}
+
+// 两个动画精灵轮流使用: 一个通过DMA传输到屏幕时，在另一个中绘制下一帧
+static LGFX_Sprite animSprites[2] = {LGFX_Sprite(&M5.Display), LGFX_Sprite(&M5.Display)};
+static int animSpriteState = 0;     // 0未创建，1已创建，-1创建失败
+static int readySprite = -1;        // 已经绘制好、等待传输的精灵
+static int32_t readyFrameIndex = 0; // 等待传输的精灵对应的帧序号
+
+// 创建动画精灵，优先放在PSRAM中，没有PSRAM时放在内部内存
+static bool createAnimSprites(int width, int height) {
+  for (int i = 0; i < 2; i++) {
+    animSprites[i].setColorDepth(16);
+    animSprites[i].setPsram(true);
+    if (animSprites[i].createSprite(width, height) == nullptr) {
+      animSprites[i].setPsram(false);
+      if (animSprites[i].createSprite(width, height) == nullptr) {
+        animSprites[0].deleteSprite();
+        return false;
+      }
     }
   }
+  return true;
+}
+
+// 帧序号转换为动画帧，帧率变化时动画速度不变
+static float animFrameAt(int32_t frameIndex) {
+  return fmodf(frameIndex * (HOME_ANIM_FRAME_MS / (float)ANIM_STEP_MS), 120.0f);
+}
+
+// 绘制音符律动动画 - 双缓冲DMA传输
+// 调用方需要在 startWrite/endWrite 之间调用，传输在 endWrite 之前完成
+void drawMusicNoteAnimation(int32_t frameIndex) {
+  int animWidth = M5.Display.width();
+  int animHeight = M5.Display.height() - STATUS_BAR_HEIGHT;
+  
+  if (animSpriteState == 0) {
+    animSpriteState = createAnimSprites(animWidth, animHeight) ? 1 : -1;
+    if (animSpriteState < 0) {
+      M5.Log.println("[UI] 动画缓冲区分配失败，使用简化动画");
+    }
+  }
+  
+  // 如果内存分配失败，直接在屏幕上绘制
+  if (animSpriteState < 0) {
+    // 清除整个动画区域
+    M5.Display.fillRect(0, STATUS_BAR_HEIGHT, animWidth, animHeight, COLOR_BG);
+    
+    // 简化版动画，减少复杂度
+    drawSimpleMusicNote(animWidth / 2, ANIM_CENTER_Y, animFrameAt(frameIndex));
+    return;
+  }
   
-  // 将缓冲区内容一次性绘制到屏幕上
-  M5.Display.pushImage(0, STATUS_BAR_HEIGHT, animWidth, animHeight, animBuffer);
+  // 上一次预先绘制的帧不是这一帧 (第一次显示或跳过了帧)，现在绘制
+  if (readySprite < 0 || readyFrameIndex != frameIndex) {
+    readySprite = (readySprite < 0) ? 0 : readySprite;
+    renderMusicNoteFrame(animSprites[readySprite], animFrameAt(frameIndex));
+  }
+  
+  // 开始DMA传输，不等待完成
+  LGFX_Sprite& front = animSprites[readySprite];
+  M5.Display.pushImageDMA(0, STATUS_BAR_HEIGHT, animWidth, animHeight,
+                          static_cast<const lgfx::swap565_t*>(front.getBuffer()));
+  
+  // 传输期间在另一个精灵中绘制下一帧
+  // 再下一次写同一个精灵时，这次的传输早已完成 (同一总线上的传输按顺序进行)
+  readySprite ^= 1;
+  readyFrameIndex = frameIndex + 1;
+  renderMusicNoteFrame(animSprites[readySprite], animFrameAt(readyFrameIndex));
 }
 
-// 绘制音符到缓冲区
-void drawMusicNoteToBuffer(uint16_t* buffer, int bufWidth, int bufHeight, int centerX, int centerY, float scale, uint16_t color) {
+// 音符: 头部、杆和两面旗帜
+void drawMusicNote(LGFX_Sprite& canvas, int centerX, int centerY, float scale, uint16_t color) {
   // 绘制音符头部
   int noteHeadSize = 12 * scale;
-  drawCircleToBuffer(buffer, bufWidth, bufHeight, 
-                    centerX, centerY, noteHeadSize, color);
+  canvas.fillCircle(centerX, centerY, noteHeadSize, color);
   
   // 绘制音符杆
   int stemLength = 30 * scale;
   int stemWidth = 3 * scale;
-  drawRectToBuffer(buffer, bufWidth, bufHeight,
-                  centerX + noteHeadSize - stemWidth, centerY - stemLength, 
+  canvas.fillRect(centerX + noteHeadSize - stemWidth, centerY - stemLength, 
                   stemWidth, stemLength, color);
   
   // 绘制音符旗帜
@@ -325,29 +372,18 @@ void drawMusicNoteToBuffer(uint16_t* buffer, int bufWidth, int bufHeight, int ce
   int flagHeight = 8 * scale;
   
   // 第一个旗帜
-  drawRectToBuffer(buffer, bufWidth, bufHeight,
-                  centerX + noteHeadSize - stemWidth, centerY - stemLength, 
+  canvas.fillRect(centerX + noteHeadSize - stemWidth, centerY - stemLength, 
                   flagWidth, flagHeight, color);
   
   // 第二个旗帜
-  drawRectToBuffer(buffer, bufWidth, bufHeight,
-                  centerX + noteHeadSize - stemWidth, centerY - stemLength + 10 * scale, 
+  canvas.fillRect(centerX + noteHeadSize - stemWidth, centerY - stemLength + 10 * scale, 
                   flagWidth, flagHeight, color);
 }
 
 // 简化版音符绘制，用于内存不足时
-void drawSimpleMusicNote(int centerX, int centerY, int frame) {
+void drawSimpleMusicNote(int centerX, int centerY, float frame) {
   // 音符颜色
-  uint16_t noteColor;
-  switch ((frame / 30) % 6) {
-    case 0: noteColor = COLOR_NOTE1; break;
-    case 1: noteColor = COLOR_NOTE2; break;
-    case 2: noteColor = COLOR_NOTE3; break;
-    case 3: noteColor = COLOR_NOTE4; break;
-    case 4: noteColor = COLOR_NOTE5; break;
-    case 5: noteColor = COLOR_BATTERY_LOW; break;
-    default: noteColor = COLOR_TEXT; break;
-  }
+  uint16_t noteColor = noteColorForFrame(frame);
   
   // 音符大小
   float scale = 1.0 + 0.15 * sin(frame * 0.05);
@@ -370,54 +406,6 @@ void drawSimpleMusicNote(int centerX, int centerY, int frame) {
   }
 }
 
-// 辅助函数：在缓冲区中绘制圆形
-void drawCircleToBuffer(uint16_t* buffer, int bufWidth, int bufHeight, int x0, int y0, int radius, uint16_t color) {
-  for (int y = -radius; y <= radius; y++) {
-    for (int x = -radius; x <= radius; x++) {
-      if (x*x + y*y <= radius*radius) {
-        int drawX = x0 + x;
-        int drawY = y0 + y;
-        if (drawX >= 0 && drawX < bufWidth && drawY >= 0 && drawY < bufHeight) {
-          buffer[drawY * bufWidth + drawX] = color;
-        }
-      }
-    }
-  }
-}
-
-// 辅助函数：在缓冲区中绘制矩形
-void drawRectToBuffer(uint16_t* buffer, int bufWidth, int bufHeight, int x, int y, int w, int h, uint16_t color) {
-  for (int j = 0; j < h; j++) {
-    for (int i = 0; i < w; i++) {
-      int drawX = x + i;
-      int drawY = y + j;
-      if (drawX >= 0 && drawX < bufWidth && drawY >= 0 && drawY < bufHeight) {
-        buffer[drawY * bufWidth + drawX] = color;
-      }
-    }
-  }
-}
-
-// 辅助函数：在缓冲区中绘制线段 (简化版Bresenham算法)
-void drawLineToBuffer(uint16_t* buffer, int bufWidth, int bufHeight, int x0, int y0, int x1, int y1, uint16_t color) {
-  int dx = abs(x1 - x0);
-  int dy = abs(y1 - y0);
-  int sx = (x0 < x1) ? 1 : -1;
-  int sy = (y0 < y1) ? 1 : -1;
-  int err = dx - dy;
-  
-  while (true) {
-    if (x0 >= 0 && x0 < bufWidth && y0 >= 0 && y0 < bufHeight) {
-      buffer[y0 * bufWidth + x0] = color;
-    }
-    
-    if (x0 == x1 && y0 == y1) break;
-    int e2 = 2 * err;
-    if (e2 > -dy) { err -= dy; x0 += sx; }
-    if (e2 < dx) { err += dx; y0 += sy; }
-  }
-}
-
 // 显示主界面UI
 void displayHomeUI() {
   unsigned long currentTime = millis();
@@ -427,30 +415,44 @@ void displayHomeUI() {
   
   // 检测是否需要重绘
   bool updateTime = (currentTime - lastTimeUpdateTime >= 1000); // 每秒更新时间
-  bool updateAnimation = (currentTime - lastAnimationTime >= 100); // 每100ms更新动画
+  bool updateAnimation = (currentTime - lastAnimationTime >= HOME_ANIM_FRAME_MS); // 按动画帧率更新
+  
+  if (!homeWidgetsReady) {
+    initHomeWidgets();
+  }
   
   if (homeUIRedrawNeeded) {
-    // 清屏
+    // 清屏并绘制状态栏背景
+    M5.Display.startWrite();
     M5.Display.fillScreen(COLOR_BG);
+    M5.Display.fillRect(0, 0, M5.Display.width(), STATUS_BAR_HEIGHT, COLOR_STATUS_BG);
+    M5.Display.endWrite();
     
     // 重置重绘标志
     homeUIRedrawNeeded = false;
+    uiWidgetInvalidate(homeWidgets, HOME_WIDGET_COUNT);
     
     // 强制立即更新时间和动画
     updateTime = true;
     updateAnimation = true;
   }
   
-  // 更新时间和状态栏
+  // 更新时间和电池，显示的内容变化时才重绘
   if (updateTime) {
-    drawStatusBar();
+    String timeStr = getFormattedTime();
+    uiWidgetSet(homeWidgets[HOME_TIME], atoi(timeStr.c_str()) * 60 + atoi(timeStr.c_str() + 3));
+    int batteryLevel = constrain(M5.Power.getBatteryLevel(), 0, 100);
+    uiWidgetSet(homeWidgets[HOME_BATTERY], batteryLevel | (M5.Power.isCharging() ? 0x100 : 0));
     lastTimeUpdateTime = currentTime;
   }
   
   // 更新动画 - 使用优化的绘制方法
   if (updateAnimation) {
-    animationFrame = (animationFrame + 1) % 120;  // 使用更长的循环周期
-    drawMusicNoteAnimation(animationFrame);
+    animationFrame++;  // 帧序号，动画循环周期在animFrameAt中计算
+    uiWidgetSet(homeWidgets[HOME_ANIM], animationFrame);
     lastAnimationTime = currentTime;
   }
+  
+  // 状态栏和动画一次刷新
+  uiFlush(homeWidgets, HOME_WIDGET_COUNT);
 }
@@ -8,6 +8,9 @@
 // 全局判断变量，用于控制清屏和重绘
 extern bool homeUIRedrawNeeded;
 
+// 动画帧间隔 (ms)，约30FPS
+#define HOME_ANIM_FRAME_MS 33
+
 // 显示主界面UI
 void displayHomeUI();
 
@@ -1,21 +1,555 @@
 #include "http/http.h"
-#include <map> // 添加map头文件
+#include <memory>
+#include <atomic>
 #include <M5Unified.h>
-// 创建HTTP服务器实例，端口80
-WebServer server(80);
+#include <LittleFS.h>
+#include <ESPAsyncWebServer.h>
+#include "note/note_codec.h"
+#include "note/note_session_store.h"
+#include "imu/imu_trace_recorder.h"
+#include "http/live_stream.h"
+#include "http/http_range.h"
+#include "metrics/metrics.h"
+#include "trace/trace.h"
+// 创建异步HTTP服务器实例，端口80
+// 每个请求由AsyncTCP任务在数据到达/发送完成时回调处理，多个客户端可以同时下载，不阻塞其他任务
+AsyncWebServer server(80);
 
-// 存储回调函数，stl map容器存储回调函数，key为String，value为DataCallback
-std::map<String, DataCallback> dataCallbacks;
+// 注册的action，按名称排序，二分查找 (注册只在启动服务器之前进行，之后只读)
+struct DataAction
+{
+    char name[HTTP_ACTION_NAME_SIZE];
+    DataCallback callback;
+};
+static DataAction dataActions[HTTP_MAX_ACTIONS];
+static size_t actionCount = 0;
+
+// 请求体缓冲区，每个正在上传的POST请求占用一个，请求结束时释放
+// 只在AsyncTCP任务中访问，不需要加锁
+#define HTTP_BODY_SLOTS 4
+struct BodySlot
+{
+    AsyncWebServerRequest *owner;
+    size_t length;
+    char data[HTTP_DATA_MAX_SIZE + 1];
+};
+static BodySlot bodySlots[HTTP_BODY_SLOTS];
 
-static bool serverRunning = false;        // 服务器是否运行
-static unsigned long lastRequestTime = 0; // 最后一次请求时间
-static uint16_t errorCount = 0;           // 错误计数
+// 解析命令用的JSON内存池，每个请求从头使用 (请求在AsyncTCP任务中依次处理)
+#define HTTP_JSON_POOL_SIZE 4096
 
-// 存储最新的音符映射数据
-static String latestNoteMapData = "[]";
+static bool serverRunning = false;                      // 服务器是否运行
+static std::atomic<unsigned long> lastRequestTime(0);   // 最后一次请求时间
+static std::atomic<uint16_t> errorCount(0);             // 错误计数
+static std::atomic<int> activeRequests(0);              // 正在处理的请求数
+
+// 存储最新的音符数据 (二进制事件，按需转换为JSON)
+static NoteLog latestNoteMapData = {};
+// 音符数据版本号，每次替换数据时递增，用于检测下载过程中数据是否被替换
+static uint32_t noteDataSeq = 0;
 // 互斥锁,用于保护音符映射数据
 static SemaphoreHandle_t noteMapMutex = NULL;
 
+// 填充分块时等待互斥锁的时间，拿不到锁时让服务器稍后再试，不阻塞AsyncTCP任务
+#define NOTE_LOCK_TIMEOUT_MS 5
+// 每个分块的最小长度
+#define NOTE_CHUNK_MIN_SIZE 32
+// 会话列表中一个会话的JSON最大长度
+#define SESSION_JSON_MAX_SIZE 160
+
+// 音符数据的输出格式
+enum NoteFormat
+{
+    NOTE_FORMAT_JSON,  // [{"n":523,"t":300},...]
+    NOTE_FORMAT_BINARY // 紧凑二进制格式，见 note/note_codec.h
+};
+
+// 把JSON格式的音符填入分块 (调用时需持有互斥锁)，返回写入的字节数
+static size_t fillJSONChunk(size_t &index, bool first, char *chunk, size_t size)
+{
+    size_t len = 0;
+    if (first)
+    {
+        chunk[len++] = '[';
+    }
+    // 预留结尾']'的位置
+    while (index < latestNoteMapData.count)
+    {
+        if (index > 0)
+        {
+            if (len + 1 >= size - 1)
+            {
+                break;
+            }
+            chunk[len] = ',';
+        }
+        size_t offset = (index > 0) ? 1 : 0;
+        size_t written = noteEventToJSON(latestNoteMapData.events[index], chunk + len + offset, size - 1 - len - offset);
+        if (written == 0)
+        {
+            break;
+        }
+        len += offset + written;
+        index++;
+    }
+    if (index >= latestNoteMapData.count)
+    {
+        chunk[len++] = ']';
+    }
+    return len;
+}
+
+// 把二进制格式的音符填入分块 (调用时需持有互斥锁)，返回写入的字节数
+static size_t fillBinaryChunk(NoteEncoder &encoder, size_t &index, bool first, uint8_t *chunk, size_t size)
+{
+    size_t len = 0;
+    if (first)
+    {
+        len += noteEncodeHeader(encoder, latestNoteMapData.count, chunk, size);
+        if (len == 0)
+        {
+            return 0;
+        }
+    }
+    while (index < latestNoteMapData.count)
+    {
+        size_t written = noteEncodeEvent(encoder, latestNoteMapData.events[index], chunk + len, size - len);
+        if (written == 0)
+        {
+            break;
+        }
+        len += written;
+        index++;
+    }
+    return len;
+}
+
+// 一次下载的进度，每个请求一份，随响应一起释放
+struct NoteDownload
+{
+    NoteFormat format;
+    NoteEncoder encoder;
+    size_t index;    // 下一个待发送的音符
+    uint32_t seq;    // 开始下载时的数据版本
+    bool started;
+    bool finished;
+};
+
+// 以分块传输方式发送音符数据，服务器在发送缓冲区有空间时调用填充函数
+// 互斥锁只在填充每个分块时持有，峰值内存只有一个分块大小，与录制长度和客户端数无关
+static void streamNoteData(AsyncWebServerRequest *request, NoteFormat format)
+{
+    // 在请求处理时记下数据版本，之后被替换就结束传输
+    if (!xSemaphoreTake(noteMapMutex, pdMS_TO_TICKS(NOTE_LOCK_TIMEOUT_MS)))
+    {
+        errorCount++;
+        request->send(503, "application/json", "{\"error\":\"Note data busy\"}");
+        return;
+    }
+    std::shared_ptr<NoteDownload> download(new NoteDownload{format, {}, 0, noteDataSeq, false, false});
+    xSemaphoreGive(noteMapMutex);
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+        (format == NOTE_FORMAT_BINARY) ? "application/octet-stream" : "application/json",
+        [download](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+        {
+            if (download->finished)
+            {
+                return 0;
+            }
+            TRACE_SCOPE(TRACE_HTTP_CHUNK);
+            // 缓冲区太小时等发送出去一部分再填，保证至少能放下一个音符和括号
+            if (maxLen < NOTE_CHUNK_MIN_SIZE)
+            {
+                return RESPONSE_TRY_AGAIN;
+            }
+            if (!xSemaphoreTake(noteMapMutex, pdMS_TO_TICKS(NOTE_LOCK_TIMEOUT_MS)))
+            {
+                return RESPONSE_TRY_AGAIN;
+            }
+            // 下载过程中数据被替换，提前结束 (客户端按JSON格式或二进制头部的数量检测到不完整)
+            if (download->seq != noteDataSeq)
+            {
+                xSemaphoreGive(noteMapMutex);
+                errorCount++;
+                M5.Log.println("[HTTP] 音符数据在下载过程中被替换，已结束传输");
+                return 0;
+            }
+            size_t len;
+            if (download->format == NOTE_FORMAT_BINARY)
+            {
+                len = fillBinaryChunk(download->encoder, download->index, !download->started, buffer, maxLen);
+            }
+            else
+            {
+                len = fillJSONChunk(download->index, !download->started, (char *)buffer, maxLen);
+            }
+            download->finished = (download->index >= latestNoteMapData.count) && len > 0;
+            xSemaphoreGive(noteMapMutex);
+
+            // 没有填入数据 (不应发生)，稍后再试
+            if (len == 0)
+            {
+                return RESPONSE_TRY_AGAIN;
+            }
+            download->started = true;
+            return len;
+        });
+    request->send(response);
+}
+
+// 会话列表的输出进度，每个请求一份
+struct SessionList
+{
+    size_t index; // 下一个待输出的会话
+    bool started;
+    bool finished;
+};
+
+// 以分块传输方式输出会话列表，每个分块只在复制索引记录时持有锁
+// {"used":字节数,"capacity":字节数,"sessions":[{"id":1,"start":UNIX时间,"duration":ms,"notes":n,"tempo":bpm,"seed":s,"size":字节数},...]}
+static void streamSessionList(AsyncWebServerRequest *request)
+{
+    std::shared_ptr<SessionList> list(new SessionList{0, false, false});
+    request->send(request->beginChunkedResponse("application/json", [list](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                                {
+        if (list->finished) {
+            return 0;
+        }
+        if (maxLen < SESSION_JSON_MAX_SIZE) {
+            return RESPONSE_TRY_AGAIN;
+        }
+        TRACE_SCOPE(TRACE_HTTP_CHUNK);
+        char *chunk = (char *)buffer;
+        size_t len = 0;
+        if (!list->started) {
+            len = snprintf(chunk, maxLen, "{\"used\":%u,\"capacity\":%u,\"sessions\":[",
+                           (unsigned)getSessionStoreUsed(), (unsigned)SESSION_LOG_MAX_BYTES);
+            list->started = true;
+        }
+        SessionInfo info;
+        while (maxLen - len >= SESSION_JSON_MAX_SIZE) {
+            SessionLookup result = getSessionAt(list->index, info, pdMS_TO_TICKS(NOTE_LOCK_TIMEOUT_MS));
+            if (result == SESSION_BUSY) {
+                break;
+            }
+            if (result == SESSION_MISSING) {
+                chunk[len++] = ']';
+                chunk[len++] = '}';
+                list->finished = true;
+                break;
+            }
+            len += snprintf(chunk + len, maxLen - len,
+                            "%s{\"id\":%u,\"start\":%u,\"duration\":%u,\"notes\":%u,\"tempo\":%u,\"seed\":%u,\"size\":%u}",
+                            list->index > 0 ? "," : "", (unsigned)info.id, (unsigned)info.startTime,
+                            (unsigned)info.duration, (unsigned)info.count, (unsigned)info.tempo,
+                            (unsigned)info.seed, (unsigned)info.length);
+            list->index++;
+        }
+        return len > 0 ? len : RESPONSE_TRY_AGAIN; }));
+}
+
+// 一次会话下载，每个请求一份
+struct SessionDownload
+{
+    SessionInfo info;
+    uint32_t generation; // 开始下载时的存储版本
+    uint32_t start;      // 范围在会话中的起点
+    uint32_t length;     // 范围的字节数
+};
+
+// 下载一个会话 (二进制音符格式)，支持Range请求
+// 日志文件只追加，已保存的会话不会改变，存储在下载过程中被清空时结束传输
+static void streamSession(AsyncWebServerRequest *request, uint32_t id)
+{
+    SessionInfo info;
+    uint32_t generation = 0;
+    SessionLookup result = findSession(id, info, generation, pdMS_TO_TICKS(NOTE_LOCK_TIMEOUT_MS));
+    if (result == SESSION_BUSY)
+    {
+        errorCount++;
+        request->send(503, "application/json", "{\"error\":\"Session store busy\"}");
+        return;
+    }
+    if (result == SESSION_MISSING)
+    {
+        request->send(404, "application/json", "{\"error\":\"Session not found\"}");
+        return;
+    }
+
+    uint32_t start = 0;
+    uint32_t end = info.length - 1;
+    int range = 0;
+    const AsyncWebHeader *header = request->getHeader("Range");
+    if (header != NULL)
+    {
+        range = parseRange(header->value().c_str(), info.length, start, end);
+    }
+    if (range < 0)
+    {
+        char contentRange[32];
+        snprintf(contentRange, sizeof(contentRange), "bytes */%u", (unsigned)info.length);
+        AsyncWebServerResponse *response = request->beginResponse(416, "application/json", "{\"error\":\"Range not satisfiable\"}");
+        response->addHeader("Content-Range", contentRange);
+        request->send(response);
+        return;
+    }
+
+    std::shared_ptr<SessionDownload> download(new SessionDownload{info, generation, start, end - start + 1});
+    AsyncWebServerResponse *response = request->beginResponse(
+        "application/octet-stream", download->length,
+        [download](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+        {
+            if (index >= download->length)
+            {
+                return 0;
+            }
+            TRACE_SCOPE(TRACE_HTTP_CHUNK);
+            if (maxLen > download->length - index)
+            {
+                maxLen = download->length - index;
+            }
+            int len = readSessionData(download->info, download->generation, download->start + index, buffer, maxLen,
+                                      pdMS_TO_TICKS(NOTE_LOCK_TIMEOUT_MS));
+            if (len < 0)
+            {
+                errorCount++;
+                M5.Log.println("[HTTP] 会话在下载过程中被删除，已结束传输");
+                return 0;
+            }
+            return len > 0 ? len : RESPONSE_TRY_AGAIN;
+        });
+    response->addHeader("Accept-Ranges", "bytes");
+    if (range > 0)
+    {
+        char contentRange[48];
+        snprintf(contentRange, sizeof(contentRange), "bytes %u-%u/%u", (unsigned)start, (unsigned)end, (unsigned)info.length);
+        response->setCode(206);
+        response->addHeader("Content-Range", contentRange);
+    }
+    request->send(response);
+}
+
+// JSON内存池: 按顺序分配，释放时什么都不做，每个请求开始时整体清空
+// 每块前面记录长度，最后一块可以原地扩大或缩小 (ArduinoJson 解析字符串时会反复扩大)
+class JsonPool : public ArduinoJson::Allocator
+{
+public:
+    void reset()
+    {
+        used = 0;
+        last = NULL;
+    }
+
+    void *allocate(size_t size) override
+    {
+        size_t need = HEADER + align(size);
+        if (need > sizeof(buffer) - used)
+        {
+            return NULL;
+        }
+        uint8_t *block = buffer + used;
+        *(size_t *)block = size;
+        used += need;
+        last = block + HEADER;
+        return last;
+    }
+
+    void deallocate(void *) override
+    {
+    }
+
+    void *reallocate(void *ptr, size_t size) override
+    {
+        if (ptr == NULL)
+        {
+            return allocate(size);
+        }
+        uint8_t *block = (uint8_t *)ptr - HEADER;
+        size_t oldSize = *(size_t *)block;
+        if (ptr == last && (size_t)(block - buffer) + HEADER + align(size) <= sizeof(buffer))
+        {
+            *(size_t *)block = size;
+            used = (block - buffer) + HEADER + align(size);
+            return ptr;
+        }
+        void *moved = allocate(size);
+        if (moved != NULL)
+        {
+            memcpy(moved, ptr, oldSize < size ? oldSize : size);
+        }
+        return moved;
+    }
+
+private:
+    static const size_t HEADER = 8;
+    static size_t align(size_t size) { return (size + 7) & ~(size_t)7; }
+
+    alignas(8) uint8_t buffer[HTTP_JSON_POOL_SIZE];
+    size_t used = 0;
+    void *last = NULL;
+};
+static JsonPool jsonPool;
+
+// 查找请求占用的请求体缓冲区
+static BodySlot *findBody(AsyncWebServerRequest *request)
+{
+    for (int i = 0; i < HTTP_BODY_SLOTS; i++)
+    {
+        if (bodySlots[i].owner == request)
+        {
+            return &bodySlots[i];
+        }
+    }
+    return NULL;
+}
+
+// 跟踪导出 (同一时间只有一个)，导出期间暂停记录，下载完或连接断开时恢复
+static TraceExport traceExport;
+static AsyncWebServerRequest *traceDownload = NULL;
+
+static void endTraceDownload(AsyncWebServerRequest *request)
+{
+    if (traceDownload == request && request != NULL)
+    {
+        traceExportEnd(traceExport);
+        traceDownload = NULL;
+    }
+}
+
+// 记录一次请求，请求结束时减少计数、记录延迟并释放请求体缓冲区
+static void beginRequest(AsyncWebServerRequest *request)
+{
+    lastRequestTime = millis();
+    activeRequests++;
+    TRACE_INSTANT(TRACE_HTTP_REQUEST, 0);
+    // 只捕获两个32位值，std::function 不需要分配内存
+    uint32_t start = (uint32_t)esp_timer_get_time();
+    request->onDisconnect([request, start]()
+                          {
+        activeRequests--;
+        recordHTTPLatency((uint32_t)esp_timer_get_time() - start);
+        endTraceDownload(request);
+        BodySlot *slot = findBody(request);
+        if (slot != NULL) {
+            slot->owner = NULL;
+        } });
+}
+
+// POST /api/data 的请求体: 按块收集到空闲的请求体缓冲区中
+static void collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+{
+    if (total > HTTP_DATA_MAX_SIZE)
+    {
+        return;
+    }
+    BodySlot *slot = findBody(request);
+    if (index == 0 && slot == NULL)
+    {
+        slot = findBody(NULL);
+        if (slot == NULL)
+        {
+            // 没有空闲的缓冲区，处理请求时返回503
+            return;
+        }
+        slot->owner = request;
+        slot->length = 0;
+        beginRequest(request);
+    }
+    if (slot != NULL && index + len <= total)
+    {
+        memcpy(slot->data + index, data, len);
+        slot->length = index + len;
+        slot->data[slot->length] = '\0';
+    }
+}
+
+// 按名称二分查找action
+static const DataAction *findAction(const char *name)
+{
+    size_t low = 0;
+    size_t high = actionCount;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        int cmp = strcmp(name, dataActions[mid].name);
+        if (cmp == 0)
+        {
+            return &dataActions[mid];
+        }
+        if (cmp < 0)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+// 处理POST /api/data: 解析到固定内存池，查表后调用一次回调，不分配堆内存
+static void handleData(AsyncWebServerRequest *request)
+{
+    BodySlot *slot = findBody(request);
+    if (slot == NULL)
+    {
+        beginRequest(request);
+        errorCount++;
+        if (request->contentLength() > HTTP_DATA_MAX_SIZE)
+        {
+            request->send(413, "application/json", "{\"error\":\"Data too large\"}");
+        }
+        else if (request->contentLength() > 0)
+        {
+            // 同时上传的请求太多
+            request->send(503, "application/json", "{\"error\":\"Server busy\"}");
+        }
+        else
+        {
+            // 没有数据
+            request->send(400, "application/json", "{\"error\":\"No data provided\"}");
+        }
+        return;
+    }
+
+    // 解析JSON
+    jsonPool.reset();
+    JsonDocument doc(&jsonPool);
+    DeserializationError error = deserializeJson(doc, slot->data, slot->length);
+    slot->owner = NULL;
+    if (error)
+    {
+        // JSON解析错误
+        errorCount++;
+        request->send(400, "application/json", "{\"error\":\"Invalid JSON format\"}");
+        return;
+    }
+
+    // 检查是否有action字段
+    const char *action = doc["action"].as<const char *>();
+    if (action == NULL)
+    {
+        // 没有action字段
+        errorCount++;
+        request->send(400, "application/json", "{\"error\":\"Missing 'action' field\"}");
+        return;
+    }
+    // 查找对应的回调函数
+    const DataAction *entry = findAction(action);
+    if (entry == NULL)
+    {
+        // 未知action
+        errorCount++;
+        request->send(404, "application/json", "{\"error\":\"Unknown action\"}");
+        return;
+    }
+    // 调用回调函数，返回成功响应
+    entry->callback(doc);
+    request->send(200, "application/json", "{\"status\":\"success\"}");
+}
+
 // 初始化HTTP服务器
 void setupHTTPServer()
 {
@@ -25,79 +559,109 @@ void setupHTTPServer()
         noteMapMutex = xSemaphoreCreateMutex();
     }
     // 设置CORS头部，允许跨域访问
-    server.enableCORS(true);
+    static bool corsAdded = false;
+    if (!corsAdded)
+    {
+        DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
+        DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+        DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Content-Type, Accept, Range");
+        DefaultHeaders::Instance().addHeader("Access-Control-Expose-Headers", "Content-Range, Accept-Ranges");
+        corsAdded = true;
+    }
+
     // 数据API - 发送和接收数据
-    server.on("/api/data", HTTP_POST, []()
+    server.on("/api/data", HTTP_POST, handleData, NULL, collectBody);
+
+    // 音符数据API - 获取最新的音符数据
+    server.on("/api/notes", HTTP_GET, [](AsyncWebServerRequest *request)
               {
-        lastRequestTime = millis();
-        // 检查是否有数据
-        if (server.hasArg("plain")) {
-            String jsonStr = server.arg("plain");
-            
-            // 解析JSON
-            JsonDocument doc;
-            DeserializationError error = deserializeJson(doc, jsonStr);
-            
-            if (error) {
-                // JSON解析错误
-                errorCount++;
-                server.send(400, "application/json", "{\"error\":\"Invalid JSON format\"}");
-                return;
-            }
-            
-            // 检查是否有action字段
-            if (!doc["action"].isNull()) {
-                // 获取action
-                String action = doc["action"].as<String>();
-                
-                // 查找对应的回调函数
-                if (dataCallbacks.find(action) != dataCallbacks.end()) {
-                    // 调用回调函数
-                    dataCallbacks[action](doc);
-                    
-                    // 返回成功响应
-                    server.send(200, "application/json", "{\"status\":\"success\"}");
-                } else {
-                    // 未知action
-                    errorCount++;
-                    server.send(404, "application/json", "{\"error\":\"Unknown action\"}");
-                }
-            } else {
-                // 没有action字段
-                errorCount++;
-                server.send(400, "application/json", "{\"error\":\"Missing 'action' field\"}");
-            }
+        beginRequest(request);
+        // 客户端可以通过Accept头部请求二进制格式
+        const AsyncWebHeader *accept = request->getHeader("Accept");
+        if (accept != NULL && accept->value().indexOf("application/octet-stream") >= 0) {
+            streamNoteData(request, NOTE_FORMAT_BINARY);
         } else {
-            // 没有数据
-            errorCount++;
-            server.send(400, "application/json", "{\"error\":\"No data provided\"}");
+            streamNoteData(request, NOTE_FORMAT_JSON);
         } });
 
-    // 音符数据API - 获取最新的音符数据
-    server.on("/api/notes", HTTP_GET, []()
+    // 紧凑二进制格式的音符数据
+    server.on("/api/notes.bin", HTTP_GET, [](AsyncWebServerRequest *request)
               {
-        lastRequestTime = millis();
-        
-        if (xSemaphoreTake(noteMapMutex, portMAX_DELAY)) {
-            String response = latestNoteMapData;
-            xSemaphoreGive(noteMapMutex);
-            server.send(200, "application/json", response);
+        beginRequest(request);
+        streamNoteData(request, NOTE_FORMAT_BINARY); });
+
+    // IMU轨迹文件 (格式见 imu/imu_trace.h)，用于在主机上回放
+    server.on("/api/imu/trace", HTTP_GET, [](AsyncWebServerRequest *request)
+              {
+        beginRequest(request);
+        // 录制中的文件还没写完
+        if (isIMUTraceRecording()) {
+            request->send(409, "application/json", "{\"error\":\"Trace recording in progress\"}");
+            return;
+        }
+        if (!LittleFS.exists(IMU_TRACE_PATH)) {
+            request->send(404, "application/json", "{\"error\":\"No trace recorded\"}");
+            return;
+        }
+        request->send(LittleFS, IMU_TRACE_PATH, "application/octet-stream"); });
+
+    // 录制会话 (见 note/note_session_store.h): 不带参数时列出所有会话，?id=N 下载一个会话 (二进制音符格式，支持Range)
+    server.on("/api/sessions", HTTP_GET, [](AsyncWebServerRequest *request)
+              {
+        beginRequest(request);
+        const AsyncWebParameter *id = request->getParam("id");
+        if (id != NULL) {
+            streamSession(request, strtoul(id->value().c_str(), NULL, 10));
         } else {
-            server.send(500, "application/json", "{\"error\":\"Failed to access note data\"}");
+            streamSessionList(request);
         } });
 
-    // CORS预检请求处理
-    server.on("/api/data", HTTP_OPTIONS, []()
-              { server.send(200); });
+    // 运行指标 (见 metrics/metrics.h)，?reset=1 输出后清零直方图
+    server.on("/api/metrics", HTTP_GET, [](AsyncWebServerRequest *request)
+              {
+        beginRequest(request);
+        static char metrics[METRICS_JSON_SIZE];
+        size_t len = writeMetricsJSON(metrics, sizeof(metrics));
+        if (len == 0) {
+            errorCount++;
+            request->send(500, "application/json", "{\"error\":\"Metrics too large\"}");
+            return;
+        }
+        if (request->hasParam("reset")) {
+            resetMetrics();
+        }
+        request->send(200, "application/json", metrics); });
 
-    server.on("/api/notes", HTTP_OPTIONS, []()
-              { server.send(200); });
+    // 跟踪记录，Chrome跟踪格式 (见 trace/trace.h)
+    server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request)
+              {
+        beginRequest(request);
+        if (traceDownload != NULL) {
+            request->send(409, "application/json", "{\"error\":\"Trace download in progress\"}");
+            return;
+        }
+        traceDownload = request;
+        traceExportBegin(traceExport);
+        request->send(request->beginChunkedResponse("application/json", [](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                                    {
+            if (traceExportDone(traceExport)) {
+                return 0;
+            }
+            size_t len = traceExportChunk(traceExport, (char *)buffer, maxLen);
+            return len > 0 ? len : RESPONSE_TRY_AGAIN; })); });
 
-    // 404处理
-    server.onNotFound([]()
+    // 404处理，CORS预检请求 (OPTIONS) 直接返回200
+    server.onNotFound([](AsyncWebServerRequest *request)
                       {
+        if (request->method() == HTTP_OPTIONS) {
+            request->send(200);
+            return;
+        }
         errorCount++;
-        server.send(404, "application/json", "{\"error\":\"Not found\"}"); });
+        request->send(404, "application/json", "{\"error\":\"Not found\"}"); });
+
+    // 实时推送的WebSocket (见 http/live_stream.h)
+    attachLiveStream(server);
 
     // 启动服务器
     server.begin();
@@ -107,36 +671,49 @@ void setupHTTPServer()
     M5.Log.println(WiFi.localIP().toString().c_str());
 }
 
-// 处理HTTP请求
-void handleHTTPRequests()
+// 设置数据回调函数，插入时保持按名称排序
+bool setDataReceiveCallback(const String &endpoint, DataCallback callback)
 {
-    if (serverRunning)
+    if (endpoint.length() >= HTTP_ACTION_NAME_SIZE)
     {
-        server.handleClient();
+        M5.Log.printf("[HTTP] action名称过长: %s\n", endpoint.c_str());
+        return false;
     }
+    size_t pos = 0;
+    while (pos < actionCount && strcmp(dataActions[pos].name, endpoint.c_str()) < 0)
+    {
+        pos++;
+    }
+    if (pos < actionCount && strcmp(dataActions[pos].name, endpoint.c_str()) == 0)
+    {
+        dataActions[pos].callback = callback;
+        return true;
+    }
+    if (actionCount >= HTTP_MAX_ACTIONS)
+    {
+        M5.Log.printf("[HTTP] action已满，无法注册: %s\n", endpoint.c_str());
+        return false;
+    }
+    for (size_t i = actionCount; i > pos; i--)
+    {
+        dataActions[i] = dataActions[i - 1];
+    }
+    strcpy(dataActions[pos].name, endpoint.c_str());
+    dataActions[pos].callback = callback;
+    actionCount++;
+    return true;
 }
 
-// 设置数据回调函数
-void setDataReceiveCallback(const String &endpoint, DataCallback callback)
-{
-    dataCallbacks[endpoint] = callback;
-}
-
-// 发送数据到客户端
+// 推送数据到所有WebSocket客户端
 bool sendData(const JsonDocument &data)
 {
-    // 这个函数可以用于主动向连接的客户端发送数据
-    // 由于HTTP是请求-响应模式，这里实现为返回最后一次请求的响应
-
-    if (!serverRunning || !server.client().connected())
+    char message[512];
+    size_t len = serializeJson(data, message, sizeof(message));
+    if (len == 0 || len >= sizeof(message))
     {
         return false;
     }
-
-    String response;
-    serializeJson(data, response);
-    server.send(200, "application/json", response);
-    return true;
+    return broadcastLive(message, len);
 }
 
 // 获取HTTP服务器状态
@@ -147,7 +724,7 @@ HTTPServerStatus getHTTPServerStatus()
     status.isRunning = serverRunning;
     status.lastRequest = lastRequestTime;
     status.errorCount = errorCount;
-    status.clientConnected = server.client().connected();
+    status.clientConnected = activeRequests > 0;
 
     return status;
 }
@@ -157,7 +734,10 @@ bool restartHTTPServer()
 {
     if (serverRunning)
     {
-        server.stop();
+        server.end();
+        // 清除路由，setupHTTPServer会重新注册 (WebSocket是静态对象，先移除，不由reset释放)
+        detachLiveStream(server);
+        server.reset();
         serverRunning = false;
         delay(500); // 给服务器一些时间关闭
     }
@@ -169,7 +749,7 @@ bool restartHTTPServer()
 }
 
 // 上传并替换音符数据
-bool uploadAndReplaceNoteData(const String &jsonData)
+bool uploadAndReplaceNoteData(const NoteLog &log)
 {
     if (noteMapMutex == NULL)
     {
@@ -177,20 +757,20 @@ bool uploadAndReplaceNoteData(const String &jsonData)
     }
 
     // 检查数据大小
-    if (jsonData.length() > 20000)
-    { // 设置合理的大小限制
+    if (log.count > NOTE_LOG_CAPACITY)
+    {
         M5.Log.println("[HTTP] 音符数据过大，无法上传");
         return false;
     }
 
     if (xSemaphoreTake(noteMapMutex, 1000 / portTICK_PERIOD_MS))
     { // 添加超时
-        // 先释放旧数据内存
-        latestNoteMapData = "";
-        // 确保有足够内存后再复制
-        latestNoteMapData = jsonData;
+        // 只复制有效部分，不分配内存
+        memcpy(latestNoteMapData.events, log.events, log.count * sizeof(NoteEvent));
+        latestNoteMapData.count = log.count;
+        noteDataSeq++;
 
-        M5.Log.printf("[HTTP] 音符数据已更新，大小: %d 字节\n", jsonData.length());
+        M5.Log.printf("[HTTP] 音符数据已更新，音符数: %d\n", (int)log.count);
         xSemaphoreGive(noteMapMutex);
         return true;
     }
@@ -3,9 +3,8 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
 #include <ArduinoJson.h>
-#include <map>
+#include "note/note_log.h"
 
 // HTTP服务器状态结构体
 struct HTTPServerStatus
@@ -13,20 +12,25 @@ struct HTTPServerStatus
     bool isRunning;            // 服务器是否运行
     unsigned long lastRequest; // 上次请求时间(毫秒)
     uint16_t errorCount;       // 错误计数
-    bool clientConnected;      // 是否有客户端连接
+    bool clientConnected;      // 是否有请求正在处理
 };
 
-// 初始化HTTP服务器
-void setupHTTPServer();
+// POST /api/data 请求体的最大长度
+#define HTTP_DATA_MAX_SIZE 1024
+// 可以注册的action数
+#define HTTP_MAX_ACTIONS   12
+// action名称的最大长度
+#define HTTP_ACTION_NAME_SIZE 16
 
-// 处理HTTP请求 (在loop中调用)
-void handleHTTPRequests();
+// 初始化HTTP服务器 (异步服务器，请求在AsyncTCP任务中处理，不需要轮询)
+void setupHTTPServer();
 
-// 设置数据回调函数 - 当收到数据时调用
+// 设置数据回调函数 - 当收到数据时调用 (在AsyncTCP任务中执行，应在启动服务器之前注册)
+// 文档使用固定的内存池，回调返回后失效；同名action重复注册时替换，超过 HTTP_MAX_ACTIONS 时返回false
 typedef std::function<void(const JsonDocument &)> DataCallback;
-void setDataReceiveCallback(const String &endpoint, DataCallback callback);
+bool setDataReceiveCallback(const String &endpoint, DataCallback callback);
 
-// 发送数据到客户端
+// 推送数据到所有WebSocket客户端 (见 http/live_stream.h)，只能在HTTP任务中调用
 bool sendData(const JsonDocument &data);
 
 // 获取HTTP服务器状态
@@ -35,7 +39,7 @@ HTTPServerStatus getHTTPServerStatus();
 // 重启HTTP服务器
 bool restartHTTPServer();
 
-// 上传并替换音符数据 - 完全替换现有数据
-bool uploadAndReplaceNoteData(const String &jsonData);
+// 上传并替换音符数据 - 完全替换现有数据，JSON在/api/notes请求时才生成
+bool uploadAndReplaceNoteData(const NoteLog &log);
 
 #endif
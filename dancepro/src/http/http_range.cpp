@@ -0,0 +1,50 @@
+#include "http/http_range.h"
+
+// 解析Range头部
+int parseRange(const char *value, uint32_t size, uint32_t &start, uint32_t &end)
+{
+    if (strncmp(value, "bytes=", 6) != 0 || strchr(value, ',') != NULL)
+    {
+        return 0;
+    }
+    const char *spec = value + 6;
+    char *rest;
+    // 最后n个字节
+    if (*spec == '-')
+    {
+        unsigned long suffix = strtoul(spec + 1, &rest, 10);
+        if (rest == spec + 1 || *rest != '\0')
+        {
+            return 0;
+        }
+        if (suffix == 0)
+        {
+            return -1;
+        }
+        start = (suffix >= size) ? 0 : size - suffix;
+        end = size - 1;
+        return 1;
+    }
+    unsigned long first = strtoul(spec, &rest, 10);
+    if (rest == spec || *rest != '-')
+    {
+        return 0;
+    }
+    unsigned long last = size - 1;
+    const char *lastSpec = rest + 1;
+    if (*lastSpec != '\0')
+    {
+        last = strtoul(lastSpec, &rest, 10);
+        if (rest == lastSpec || *rest != '\0' || last < first)
+        {
+            return 0;
+        }
+    }
+    if (first >= size)
+    {
+        return -1;
+    }
+    start = first;
+    end = (last >= size) ? size - 1 : last;
+    return 1;
+}
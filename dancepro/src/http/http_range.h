@@ -0,0 +1,12 @@
+#ifndef HTTP_RANGE_H
+#define HTTP_RANGE_H
+
+#include <Arduino.h>
+
+// HTTP Range头部解析 (GET /api/sessions?id=N 的断点续传)，不依赖服务器，可以在主机上测试
+
+// 解析Range头部，只支持单个范围: bytes=a-b、bytes=a-、bytes=-n，end超出时截断到 size-1
+// 返回1为有效范围 (start..end，包含end)，0为不支持的格式 (忽略，发送全部)，-1为超出范围 (416)
+int parseRange(const char *value, uint32_t size, uint32_t &start, uint32_t &end);
+
+#endif
@@ -0,0 +1,376 @@
+#include "http/live_stream.h"
+#include <M5Unified.h>
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include "imu/imu_sampler.h"
+
+static AsyncWebSocket liveSocket(LIVE_PATH);
+static bool liveAttached = false;
+
+// 音符环形缓冲区槽位 (顺序锁，与IMU环形缓冲区相同)
+// seq = 序号*2+1 表示正在写入，序号*2+2 表示写入完成
+struct LiveSlot
+{
+    std::atomic<uint32_t> seq;
+    NoteEvent event;
+    uint32_t ms;
+};
+
+static LiveSlot liveRing[LIVE_RING_SIZE];
+static std::atomic<uint32_t> liveHead(0); // 已发布的音符总数
+
+// 每个客户端只保存一个读取位置，积压的音符就是环形缓冲区中它之后的部分
+// 客户端太慢被覆盖时跳到最旧的音符，不会占用更多内存，也不会阻塞其他客户端
+struct LiveClient
+{
+    uint32_t id;       // AsyncWebSocket客户端编号，0表示空闲
+    bool imu;          // 是否订阅IMU帧
+    uint32_t cursor;   // 下一个要发送的音符序号
+};
+
+// 客户端表: AsyncTCP任务在连接事件中修改，HTTP任务发送时复制一份，不持锁发送
+static portMUX_TYPE liveMux = portMUX_INITIALIZER_UNLOCKED;
+static LiveClient liveClients[LIVE_MAX_CLIENTS];
+static uint32_t lastIMUFrame = 0;
+
+// 发送缓冲区: 一批音符的JSON
+#define LIVE_MESSAGE_SIZE (32 + LIVE_BATCH * 40)
+
+// 发布一个音符 (单生产者)
+void publishLiveNote(const NoteEvent &event, uint32_t ms)
+{
+    uint32_t index = liveHead.load(std::memory_order_relaxed);
+    LiveSlot &slot = liveRing[index & (LIVE_RING_SIZE - 1)];
+    slot.seq.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = event;
+    slot.ms = ms;
+    slot.seq.store(index * 2 + 2, std::memory_order_release);
+    liveHead.store(index + 1, std::memory_order_release);
+}
+
+// 读取指定序号的音符，已被覆盖或正在写入时返回false
+static bool readSlot(uint32_t index, NoteEvent &event, uint32_t &ms)
+{
+    const LiveSlot &slot = liveRing[index & (LIVE_RING_SIZE - 1)];
+    uint32_t expected = index * 2 + 2;
+    if (slot.seq.load(std::memory_order_acquire) != expected)
+    {
+        return false;
+    }
+    event = slot.event;
+    ms = slot.ms;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.seq.load(std::memory_order_relaxed) == expected;
+}
+
+// 放入客户端的发送队列 (不等待TCP)，队列已满或客户端已断开时返回false
+static bool sendToClient(uint32_t id, const char *text, size_t length)
+{
+    if (!liveSocket.availableForWrite(id))
+    {
+        return false;
+    }
+    return liveSocket.text(id, text, length);
+}
+
+// 向一个客户端发送积压的音符，每次最多 LIVE_BATCH 个，放入队列后才前移读取位置
+static void sendNotes(LiveClient &client)
+{
+    // 只在HTTP任务中使用，不占任务栈
+    static char message[LIVE_MESSAGE_SIZE];
+    uint32_t head = liveHead.load(std::memory_order_acquire);
+    if (head - client.cursor > LIVE_RING_SIZE)
+    {
+        // 积压超过缓冲区，跳过被覆盖的音符
+        uint32_t skipped = head - client.cursor - LIVE_RING_SIZE;
+        int len = snprintf(message, sizeof(message), "{\"drop\":%u}", (unsigned)skipped);
+        if (!sendToClient(client.id, message, len))
+        {
+            return;
+        }
+        client.cursor = head - LIVE_RING_SIZE;
+    }
+    if (client.cursor == head)
+    {
+        return;
+    }
+
+    size_t len = snprintf(message, sizeof(message), "{\"seq\":%u,\"notes\":[", (unsigned)client.cursor);
+    uint32_t cursor = client.cursor;
+    uint32_t count = 0;
+    while (cursor != head && count < LIVE_BATCH)
+    {
+        NoteEvent event;
+        uint32_t ms;
+        if (!readSlot(cursor, event, ms))
+        {
+            // 发送过程中被覆盖，下一次再按drop处理
+            break;
+        }
+        if (count > 0)
+        {
+            message[len++] = ',';
+        }
+        // {"n":523,"t":300} 去掉结尾的 '}' 再加上时间
+        size_t written = noteEventToJSON(event, message + len, sizeof(message) - len - 20);
+        if (written == 0)
+        {
+            break;
+        }
+        len += written - 1;
+        len += snprintf(message + len, sizeof(message) - len, ",\"ms\":%u}", (unsigned)ms);
+        cursor++;
+        count++;
+    }
+    if (count == 0)
+    {
+        return;
+    }
+    len += snprintf(message + len, sizeof(message) - len, "]}");
+    if (sendToClient(client.id, message, len))
+    {
+        client.cursor = cursor;
+    }
+}
+
+// 向订阅的客户端发送最新的IMU帧，只发最新的一帧，队列已满的客户端丢弃这一帧
+// 返回到下一帧的时间 (ms)，没有客户端订阅时返回 LIVE_IDLE
+static uint32_t sendIMUFrames()
+{
+    bool subscribed = false;
+    portENTER_CRITICAL(&liveMux);
+    for (uint8_t i = 0; i < LIVE_MAX_CLIENTS; i++)
+    {
+        subscribed = subscribed || (liveClients[i].id != 0 && liveClients[i].imu);
+    }
+    portEXIT_CRITICAL(&liveMux);
+    if (!subscribed)
+    {
+        return LIVE_IDLE;
+    }
+    uint32_t now = millis();
+    if (now - lastIMUFrame < LIVE_IMU_PERIOD_MS)
+    {
+        return LIVE_IMU_PERIOD_MS - (now - lastIMUFrame);
+    }
+    lastIMUFrame = now;
+    IMUSample sample;
+    bool ready = false;
+    char message[128];
+    int len = 0;
+    for (uint8_t i = 0; i < LIVE_MAX_CLIENTS; i++)
+    {
+        portENTER_CRITICAL(&liveMux);
+        LiveClient client = liveClients[i];
+        portEXIT_CRITICAL(&liveMux);
+        if (client.id == 0 || !client.imu)
+        {
+            continue;
+        }
+        if (!ready)
+        {
+            if (!getLatestIMUSample(sample))
+            {
+                return LIVE_IMU_PERIOD_MS;
+            }
+            const IMUData &d = sample.data;
+            len = snprintf(message, sizeof(message), "{\"imu\":[%.1f,%.1f,%.1f,%.3f,%.3f,%.3f]}",
+                           d.roll, d.pitch, d.yaw, d.accX, d.accY, d.accZ);
+            ready = true;
+        }
+        sendToClient(client.id, message, len);
+    }
+    return LIVE_IMU_PERIOD_MS;
+}
+
+// 新客户端从下一个音符开始接收，客户端表已满时返回false
+static bool addClient(uint32_t id, bool imu)
+{
+    bool added = false;
+    portENTER_CRITICAL(&liveMux);
+    for (uint8_t i = 0; i < LIVE_MAX_CLIENTS; i++)
+    {
+        if (liveClients[i].id == 0)
+        {
+            liveClients[i] = {id, imu, liveHead.load(std::memory_order_acquire)};
+            added = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&liveMux);
+    return added;
+}
+
+// 断开的客户端释放表项
+static void removeClient(uint32_t id)
+{
+    portENTER_CRITICAL(&liveMux);
+    for (uint8_t i = 0; i < LIVE_MAX_CLIENTS; i++)
+    {
+        if (liveClients[i].id == id)
+        {
+            liveClients[i].id = 0;
+        }
+    }
+    portEXIT_CRITICAL(&liveMux);
+}
+
+// 切换IMU订阅
+static void setClientIMU(uint32_t id, bool imu)
+{
+    portENTER_CRITICAL(&liveMux);
+    for (uint8_t i = 0; i < LIVE_MAX_CLIENTS; i++)
+    {
+        if (liveClients[i].id == id)
+        {
+            liveClients[i].imu = imu;
+        }
+    }
+    portEXIT_CRITICAL(&liveMux);
+}
+
+// WebSocket事件 (在AsyncTCP任务中执行，只修改客户端表，不发送)
+static void onLiveEvent(AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type, void *arg,
+                        uint8_t *data, size_t length)
+{
+    switch (type)
+    {
+    case WS_EVT_CONNECT:
+    {
+        // 连接请求中带 imu=1 时订阅IMU帧
+        AsyncWebServerRequest *request = (AsyncWebServerRequest *)arg;
+        const AsyncWebParameter *param = request != NULL ? request->getParam("imu") : NULL;
+        bool imu = param != NULL && param->value() == "1";
+        if (!addClient(client->id(), imu))
+        {
+            // 超过客户端上限
+            M5.Log.printf("[Live] 客户端数已满，拒绝客户端 %u\n", (unsigned)client->id());
+            client->close();
+            return;
+        }
+        M5.Log.printf("[Live] 客户端 %u 已连接%s\n", (unsigned)client->id(), imu ? " (IMU)" : "");
+        break;
+    }
+    case WS_EVT_DISCONNECT:
+        removeClient(client->id());
+        M5.Log.printf("[Live] 客户端 %u 已断开\n", (unsigned)client->id());
+        break;
+    case WS_EVT_DATA:
+    {
+        // 只处理完整的单帧文本消息
+        AwsFrameInfo *info = (AwsFrameInfo *)arg;
+        if (!info->final || info->index != 0 || info->len != length || info->opcode != WS_TEXT)
+        {
+            break;
+        }
+        JsonDocument doc;
+        if (deserializeJson(doc, (const char *)data, length) == DeserializationError::Ok && !doc["imu"].isNull())
+        {
+            setClientIMU(client->id(), doc["imu"].as<bool>());
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// 在HTTP服务器上注册WebSocket
+void attachLiveStream(AsyncWebServer &server)
+{
+    if (liveAttached)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&liveMux);
+    memset(liveClients, 0, sizeof(liveClients));
+    portEXIT_CRITICAL(&liveMux);
+    liveSocket.onEvent(onLiveEvent);
+    server.addHandler(&liveSocket);
+    liveAttached = true;
+    M5.Log.printf("[Live] WebSocket已启动，路径%s\n", LIVE_PATH);
+}
+
+// 断开所有客户端并从HTTP服务器上移除 (removeHandler 不释放静态对象)
+void detachLiveStream(AsyncWebServer &server)
+{
+    if (!liveAttached)
+    {
+        return;
+    }
+    liveSocket.closeAll();
+    server.removeHandler(&liveSocket);
+    portENTER_CRITICAL(&liveMux);
+    memset(liveClients, 0, sizeof(liveClients));
+    portEXIT_CRITICAL(&liveMux);
+    liveAttached = false;
+}
+
+// 向客户端发送积压的数据，返回下一次需要调用的时间
+uint32_t handleLiveClients()
+{
+    if (!liveAttached)
+    {
+        return LIVE_IDLE;
+    }
+    uint32_t next = LIVE_IDLE;
+    // 释放已断开客户端的资源
+    liveSocket.cleanupClients(LIVE_MAX_CLIENTS);
+    for (uint8_t i = 0; i < LIVE_MAX_CLIENTS; i++)
+    {
+        portENTER_CRITICAL(&liveMux);
+        LiveClient client = liveClients[i];
+        portEXIT_CRITICAL(&liveMux);
+        if (client.id == 0)
+        {
+            continue;
+        }
+        sendNotes(client);
+        // 发送期间客户端没有断开时才保存读取位置
+        portENTER_CRITICAL(&liveMux);
+        if (liveClients[i].id == client.id)
+        {
+            liveClients[i].cursor = client.cursor;
+        }
+        portEXIT_CRITICAL(&liveMux);
+        // 发送队列满或超过一批时还有积压，稍后再发
+        if (client.cursor != liveHead.load(std::memory_order_acquire))
+        {
+            next = LIVE_RETRY_MS;
+        }
+    }
+    uint32_t imu = sendIMUFrames();
+    return imu < next ? imu : next;
+}
+
+// 向所有客户端发送一条文本消息
+bool broadcastLive(const char *text, size_t length)
+{
+    bool sent = false;
+    for (uint8_t i = 0; liveAttached && i < LIVE_MAX_CLIENTS; i++)
+    {
+        portENTER_CRITICAL(&liveMux);
+        uint32_t id = liveClients[i].id;
+        portEXIT_CRITICAL(&liveMux);
+        if (id != 0 && sendToClient(id, text, length))
+        {
+            sent = true;
+        }
+    }
+    return sent;
+}
+
+// 当前连接的客户端数
+uint8_t getLiveClientCount()
+{
+    uint8_t count = 0;
+    portENTER_CRITICAL(&liveMux);
+    for (uint8_t i = 0; i < LIVE_MAX_CLIENTS; i++)
+    {
+        count += liveClients[i].id != 0 ? 1 : 0;
+    }
+    portEXIT_CRITICAL(&liveMux);
+    return count;
+}
@@ -0,0 +1,54 @@
+#ifndef LIVE_STREAM_H
+#define LIVE_STREAM_H
+
+#include <Arduino.h>
+#include "note/note_log.h"
+
+class AsyncWebServer;
+
+// 实时推送 - WebSocket (HTTP服务器的 /live 路径) 在音符生成时立即推送给所有客户端，不需要轮询 /api/notes
+//
+// 连接 ws://<设备>/live ，可选 ws://<设备>/live?imu=1 同时接收IMU帧
+// 服务器发送的文本帧:
+//   {"seq":12,"notes":[{"n":523,"t":300,"ms":1234},...]}   新音符 (seq为第一个音符的序号，ms为录制开始后的时间)
+//   {"drop":5}                                          客户端太慢，跳过了5个音符
+//   {"imu":[roll,pitch,yaw,accX,accY,accZ]}             IMU帧 (订阅后每 LIVE_IMU_PERIOD_MS 一帧)
+// 客户端可以发送 {"imu":true} / {"imu":false} 切换IMU订阅
+//
+// 发送只放入每个客户端有上限的发送队列，不等待TCP；队列满的客户端本轮跳过，积压的音符留在环形缓冲区中
+
+// WebSocket路径
+#define LIVE_PATH          "/live"
+// 同时连接的客户端数
+#define LIVE_MAX_CLIENTS   4
+// 音符环形缓冲区长度 (2的幂)，也是每个客户端最多积压的音符数
+#define LIVE_RING_SIZE     64
+// 每个客户端每次最多发送的音符数
+#define LIVE_BATCH         16
+// IMU帧的间隔 (ms)
+#define LIVE_IMU_PERIOD_MS 50
+// 发送队列满、还有积压的音符时重试的间隔 (ms)
+#define LIVE_RETRY_MS      20
+// 没有需要定时发送的数据
+#define LIVE_IDLE          UINT32_MAX
+
+// 在HTTP服务器上注册WebSocket (setupHTTPServer 调用)
+void attachLiveStream(AsyncWebServer &server);
+
+// 断开所有客户端并从HTTP服务器上移除 (重启服务器前调用)
+void detachLiveStream(AsyncWebServer &server);
+
+// 向客户端发送积压的数据 (在HTTP任务中调用，录制新音符时调用一次即可)
+// 返回下一次需要调用的时间 (ms)：有积压或订阅了IMU帧时需要定时调用，否则返回 LIVE_IDLE
+uint32_t handleLiveClients();
+
+// 发布一个音符 (录制任务调用，不阻塞)，ms为录制开始后的时间
+void publishLiveNote(const NoteEvent &event, uint32_t ms);
+
+// 向所有客户端发送一条文本消息 (在HTTP任务中调用)
+bool broadcastLive(const char *text, size_t length);
+
+// 当前连接的客户端数
+uint8_t getLiveClientCount();
+
+#endif
@@ -1,9 +1,272 @@
 #include "imu/imu.h"
 #include <math.h>
 #include <M5Unified.h>
-// 全局变量实例
-IMUData ImuData = {0};
 
+// BMI270 寄存器 (FIFO批量读取)
+#define BMI270_CHIP_ID            0x24
+#define BMI270_REG_CHIP_ID        0x00
+#define BMI270_REG_FIFO_LENGTH    0x24
+#define BMI270_REG_FIFO_DATA      0x26
+#define BMI270_REG_ACC_CONF       0x40
+#define BMI270_REG_ACC_RANGE      0x41
+#define BMI270_REG_GYR_CONF       0x42
+#define BMI270_REG_GYR_RANGE      0x43
+#define BMI270_REG_FIFO_CONFIG_0  0x48
+#define BMI270_REG_FIFO_CONFIG_1  0x49
+#define BMI270_REG_CMD            0x7E
+#define BMI270_CMD_FIFO_FLUSH     0xB0
+#define BMI270_FIFO_GYR_ACC       0xC0  // FIFO存储陀螺仪和加速度计，无帧头
+#define BMI270_CONF_PERF          0xA0  // 性能模式 + 常规带宽
+#define BMI270_FIFO_FRAME_SIZE    12    // 无帧头模式每帧: 陀螺仪xyz + 加速度计xyz
+#define BMI270_FIFO_READ_FRAMES   16    // 每次I2C传输读取的帧数
+
+#define IMU_I2C_FREQ 400000
+
+// 磁力计的读取间隔 (ms): 磁力计输出频率远低于FIFO，每批都完整读取一次浪费I2C时间
+// 通过M5Unified读取 (板子坐标)，同一次读取的加速度计和陀螺仪作为FIFO轴映射的参考
+#define IMU_MAG_PERIOD_MS 100
+// 确定轴映射时每个轴需要的信号能量 (加速度计按g，陀螺仪按100dps为1，平方累加)
+#define IMU_AXIS_MIN_ENERGY 20.0f
+// 每个轴的最大相关必须超过次大相关的倍数
+#define IMU_AXIS_MARGIN 3.0f
+
+// FIFO状态
+static uint8_t fifoAddress = 0;      // 0表示未启用
+static float fifoAccScale = 0;       // 原始值 -> g
+static float fifoGyroScale = 0;      // 原始值 -> dps
+static float fifoPeriod = 0;         // 样本间隔 (s)
+static IMUData lastBatchSample = {0}; // 上一批的最后一个样本，下一批从它延续
+
+// FIFO是传感器坐标，M5Unified按板子的安装方向转换到板子坐标 (磁力计也是)，两者只差一个带符号的轴置换
+// 映射不从库的源码抄写，而是在板子上用M5Unified的输出与FIFO样本的相关性确定: 板子第i轴 = axisSign[i] * 传感器第axisIndex[i]轴
+// 确定之前FIFO样本保持传感器坐标，不使用磁力计，不会在融合中混用两种坐标
+static uint8_t axisIndex[3] = {0, 1, 2};
+static float axisSign[3] = {1, 1, 1};
+static bool axisMapped = false;
+static float axisCorrelation[3][3]; // [板子轴][传感器轴]
+static float axisEnergy[3];
+static float magX = 0, magY = 0, magZ = 0; // 最近一次的磁力计 (板子坐标)
+static uint32_t lastMagMs = 0;
+
+// 融合滤波器状态 (只在采样任务中更新)
+static FusionState fusion;
+static bool fusionReady = false;
+static uint32_t lastUpdateMicros = 0;
+
+// 待应用的融合配置
+static volatile bool fusionConfigChanged = false;
+static volatile FusionAlgorithm pendingAlgorithm = FUSION_MADGWICK;
+static volatile float pendingGain = FUSION_DEFAULT_GAIN_MADGWICK;
+static volatile bool eulerOutput = true;
+
+// 选择融合算法和增益
+void setIMUFusion(FusionAlgorithm algorithm, float gain) {
+  pendingAlgorithm = algorithm;
+  pendingGain = gain;
+  fusionConfigChanged = true;
+}
+
+// 当前的融合算法和增益
+FusionAlgorithm getIMUFusion(float& gain) {
+  gain = pendingGain;
+  return pendingAlgorithm;
+}
+
+// 是否导出欧拉角
+void setIMUEulerOutput(bool enabled) {
+  eulerOutput = enabled;
+}
+
+// 用融合滤波器更新姿态
+static void fuseIMUData(IMUData& data, float dt) {
+  if (!fusionReady || fusionConfigChanged) {
+    fusionConfigChanged = false;
+    fusionInit(fusion, pendingAlgorithm, pendingGain);
+    fusionReady = true;
+  }
+
+  fusionUpdate(fusion,
+               data.gyroX, data.gyroY, data.gyroZ,
+               data.accX, data.accY, data.accZ,
+               data.magX, data.magY, data.magZ,
+               dt);
+
+  data.qw = fusion.q0;
+  data.qx = fusion.q1;
+  data.qy = fusion.q2;
+  data.qz = fusion.q3;
+  if (eulerOutput) {
+    fusionGetEuler(fusion, data.roll, data.pitch, data.yaw);
+  }
+}
+
+// 启用传感器硬件FIFO
+uint16_t enableIMUFifo(uint16_t rateHz) {
+  // 查找BMI270
+  uint8_t address = 0;
+  const uint8_t candidates[] = {0x68, 0x69};
+  for (uint8_t candidate : candidates) {
+    if (M5.In_I2C.readRegister8(candidate, BMI270_REG_CHIP_ID, IMU_I2C_FREQ) == BMI270_CHIP_ID) {
+      address = candidate;
+      break;
+    }
+  }
+  if (address == 0) {
+    M5.Log.println("[IMU] 未找到BMI270，不使用FIFO");
+    return 0;
+  }
+
+  // 输出频率: 100Hz * 2^(odr-8)，取不小于rateHz的最小值，最大800Hz
+  uint8_t odr = 0x08;
+  uint16_t odrHz = 100;
+  while (odrHz < rateHz && odr < 0x0B) {
+    odr++;
+    odrHz *= 2;
+  }
+  // 加速度计和陀螺仪必须同频才能使用无帧头模式
+  M5.In_I2C.writeRegister8(address, BMI270_REG_ACC_CONF, BMI270_CONF_PERF | odr, IMU_I2C_FREQ);
+  M5.In_I2C.writeRegister8(address, BMI270_REG_GYR_CONF, BMI270_CONF_PERF | odr, IMU_I2C_FREQ);
+
+  // 按当前量程计算换算系数
+  uint8_t accRange = M5.In_I2C.readRegister8(address, BMI270_REG_ACC_RANGE, IMU_I2C_FREQ) & 0x03;
+  uint8_t gyroRange = M5.In_I2C.readRegister8(address, BMI270_REG_GYR_RANGE, IMU_I2C_FREQ) & 0x07;
+  if (gyroRange > 4) gyroRange = 4;
+  fifoAccScale = (float)(2 << accRange) / 32768.0f;
+  fifoGyroScale = (float)(2000 >> gyroRange) / 32768.0f;
+  fifoPeriod = 1.0f / odrHz;
+
+  // 流模式，满了覆盖旧数据
+  M5.In_I2C.writeRegister8(address, BMI270_REG_FIFO_CONFIG_0, 0x00, IMU_I2C_FREQ);
+  M5.In_I2C.writeRegister8(address, BMI270_REG_FIFO_CONFIG_1, BMI270_FIFO_GYR_ACC, IMU_I2C_FREQ);
+  M5.In_I2C.writeRegister8(address, BMI270_REG_CMD, BMI270_CMD_FIFO_FLUSH, IMU_I2C_FREQ);
+
+  fifoAddress = address;
+  M5.Log.printf("[IMU] BMI270 FIFO已启用，输出频率 %dHz\n", odrHz);
+  return odrHz;
+}
+
+// 用一次M5Unified的读数 (板子坐标) 和同一时刻的FIFO样本 (传感器坐标) 累积相关，
+// 每个板子轴都有明显最大且互不相同的传感器轴时确定映射
+static void updateAxisMap(const float* boardAcc, const float* boardGyro, const float* acc, const float* gyro) {
+  for (int b = 0; b < 3; b++) {
+    float gyroB = boardGyro[b] * 0.01f;
+    axisEnergy[b] += boardAcc[b] * boardAcc[b] + gyroB * gyroB;
+    for (int r = 0; r < 3; r++) {
+      axisCorrelation[b][r] += boardAcc[b] * acc[r] + gyroB * gyro[r] * 0.01f;
+    }
+  }
+  int8_t best[3];
+  for (int b = 0; b < 3; b++) {
+    if (axisEnergy[b] < IMU_AXIS_MIN_ENERGY) {
+      return;
+    }
+    best[b] = 0;
+    for (int r = 1; r < 3; r++) {
+      if (fabsf(axisCorrelation[b][r]) > fabsf(axisCorrelation[b][best[b]])) {
+        best[b] = r;
+      }
+    }
+    for (int r = 0; r < 3; r++) {
+      if (r != best[b] && fabsf(axisCorrelation[b][best[b]]) < IMU_AXIS_MARGIN * fabsf(axisCorrelation[b][r])) {
+        return;
+      }
+    }
+  }
+  if (best[0] == best[1] || best[0] == best[2] || best[1] == best[2]) {
+    return;
+  }
+  for (int b = 0; b < 3; b++) {
+    axisIndex[b] = best[b];
+    axisSign[b] = axisCorrelation[b][best[b]] < 0 ? -1.0f : 1.0f;
+  }
+  axisMapped = true;
+  // 坐标改变，融合从头开始
+  fusionConfigChanged = true;
+  M5.Log.printf("[IMU] FIFO轴映射: x=%c%c y=%c%c z=%c%c\n",
+                axisSign[0] < 0 ? '-' : '+', 'x' + axisIndex[0], axisSign[1] < 0 ? '-' : '+', 'x' + axisIndex[1],
+                axisSign[2] < 0 ? '-' : '+', 'x' + axisIndex[2]);
+}
+
+// 一次突发读取FIFO中的全部样本
+size_t readIMUBatch(IMUData* samples, size_t maxCount) {
+  if (fifoAddress == 0 || maxCount == 0) {
+    return 0;
+  }
+
+  uint8_t lengthBytes[2];
+  if (!M5.In_I2C.readRegister(fifoAddress, BMI270_REG_FIFO_LENGTH, lengthBytes, 2, IMU_I2C_FREQ)) {
+    return 0;
+  }
+  size_t frames = ((lengthBytes[0] | (lengthBytes[1] << 8)) & 0x3FFF) / BMI270_FIFO_FRAME_SIZE;
+  if (frames > maxCount) {
+    frames = maxCount;
+  }
+  if (frames == 0) {
+    return 0;
+  }
+
+  // 磁力计不在FIFO中，按 IMU_MAG_PERIOD_MS 读取，期间的样本共用；轴映射确定之前同时作为参考
+  bool reference = false;
+  float boardAcc[3], boardGyro[3];
+  uint32_t now = millis();
+  if (now - lastMagMs >= IMU_MAG_PERIOD_MS && M5.Imu.update()) {
+    lastMagMs = now;
+    auto imuData = M5.Imu.getImuData();
+    magX = imuData.mag.x;
+    magY = imuData.mag.y;
+    magZ = imuData.mag.z;
+    boardAcc[0] = imuData.accel.x;
+    boardAcc[1] = imuData.accel.y;
+    boardAcc[2] = imuData.accel.z;
+    boardGyro[0] = imuData.gyro.x;
+    boardGyro[1] = imuData.gyro.y;
+    boardGyro[2] = imuData.gyro.z;
+    reference = !axisMapped;
+  }
+
+  static uint8_t buffer[BMI270_FIFO_FRAME_SIZE * BMI270_FIFO_READ_FRAMES];
+  float acc[3] = {0}, gyro[3] = {0};
+  size_t count = 0;
+  while (count < frames) {
+    size_t n = frames - count;
+    if (n > BMI270_FIFO_READ_FRAMES) {
+      n = BMI270_FIFO_READ_FRAMES;
+    }
+    if (!M5.In_I2C.readRegister(fifoAddress, BMI270_REG_FIFO_DATA, buffer, n * BMI270_FIFO_FRAME_SIZE, IMU_I2C_FREQ)) {
+      break;
+    }
+    // 在紧凑循环中转换整批数据
+    for (size_t i = 0; i < n; i++, count++) {
+      const uint8_t* frame = buffer + i * BMI270_FIFO_FRAME_SIZE;
+      for (int k = 0; k < 3; k++) {
+        gyro[k] = (int16_t)(frame[k * 2] | (frame[k * 2 + 1] << 8)) * fifoGyroScale;
+        acc[k] = (int16_t)(frame[6 + k * 2] | (frame[6 + k * 2 + 1] << 8)) * fifoAccScale;
+      }
+
+      // 延续上一个样本的姿态输出
+      IMUData& data = samples[count];
+      data = (count > 0) ? samples[count - 1] : lastBatchSample;
+      data.gyroX = axisSign[0] * gyro[axisIndex[0]];
+      data.gyroY = axisSign[1] * gyro[axisIndex[1]];
+      data.gyroZ = axisSign[2] * gyro[axisIndex[2]];
+      data.accX = axisSign[0] * acc[axisIndex[0]];
+      data.accY = axisSign[1] * acc[axisIndex[1]];
+      data.accZ = axisSign[2] * acc[axisIndex[2]];
+      data.magX = axisMapped ? magX : 0;
+      data.magY = axisMapped ? magY : 0;
+      data.magZ = axisMapped ? magZ : 0;
+      fuseIMUData(data, fifoPeriod);
+    }
+  }
+  // 参考读数与这一批最新的样本时间最接近
+  if (reference && count > 0) {
+    updateAxisMap(boardAcc, boardGyro, acc, gyro);
+  }
+  if (count > 0) {
+    lastBatchSample = samples[count - 1];
+  }
+  return count;
+}
 
 // 初始化IMU传感器
 bool initIMU() {
@@ -12,10 +275,9 @@ bool initIMU() {
     M5.Log.println("IMU initialization failed!");
     return false;
   }
-  // 初始化数据结构
-  memset(&ImuData, 0, sizeof(IMUData));
   // 首次更新IMU数据
-  return updateIMUData(ImuData);
+  IMUData data = {0};
+  return updateIMUData(data);
 }
 
 // 更新IMU数据函数，从传感器读取数据并转换为姿态角
@@ -38,29 +300,16 @@ bool updateIMUData(IMUData& data) {
     data.magY = imuData.mag.y;
     data.magZ = imuData.mag.z;
     
-    // 2. 计算姿态角 (转换为欧拉角)
-    // 计算 roll (沿X轴旋转)
-    data.roll = atan2(data.accY, data.accZ) * 180.0 / M_PI;
-    // 计算 pitch (沿Y轴旋转)
-    data.pitch = atan2(-data.accX, sqrt(data.accY * data.accY + data.accZ * data.accZ)) * 180.0 / M_PI;
-    // 计算 yaw (沿Z轴旋转)
-    // 使用磁力计数据，并根据倾斜角度进行校正
-    float magX_comp, magY_comp;
-    // 根据pitch和roll角度补偿磁力计读数
-    magX_comp = data.magX * cos(data.pitch * M_PI / 180.0) + 
-                data.magZ * sin(data.pitch * M_PI / 180.0);
-                
-    magY_comp = data.magX * sin(data.roll * M_PI / 180.0) * sin(data.pitch * M_PI / 180.0) +
-                data.magY * cos(data.roll * M_PI / 180.0) - 
-                data.magZ * sin(data.roll * M_PI / 180.0) * cos(data.pitch * M_PI / 180.0);
-    // 计算补偿后的偏航角
-    data.yaw = atan2(magY_comp, magX_comp) * 180.0 / M_PI;
-    // 将偏航角转换为0-360度范围
-    if (data.yaw < 0) {
-      data.yaw += 360.0;
+    // 2. 计算两次更新之间的时间间隔
+    uint32_t now = micros();
+    float dt = (lastUpdateMicros == 0) ? 0.005f : (now - lastUpdateMicros) * 1e-6f;
+    lastUpdateMicros = now;
+    if (dt <= 0.0f || dt > 0.1f) {
+      dt = 0.005f;  // 间隔异常(首次或长时间停顿)时使用默认值
     }
-    // 更新全局数据
-    ImuData = data;
+
+    // 3. 传感器融合并写入姿态
+    fuseIMUData(data, dt);
   }
   return updated;
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #ifndef IMU_H
 #define IMU_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include "imu/imu_fusion.h"
+
 // 用于存储IMU数据和姿态角的结构体
 struct IMUData {
   // 姿态角数据 (以度为单位)
@@ -12,6 +16,9 @@ struct IMUData {
   float accX, accY, accZ;    // 加速度计数据 (g)
   float gyroX, gyroY, gyroZ; // 陀螺仪数据 (dps)
   float magX, magY, magZ;    // 磁力计数据 (uT)
+
+  // 姿态四元数 (传感器融合输出)
+  float qw, qx, qy, qz;
 };
 
 // 初始化IMU传感器
@@ -20,5 +27,22 @@ bool initIMU();
 // 更新IMU数据
 bool updateIMUData(IMUData& data);
 
+// 选择融合算法和增益，下一次更新时生效
+void setIMUFusion(FusionAlgorithm algorithm, float gain);
+
+// 当前的融合算法，增益写入gain
+FusionAlgorithm getIMUFusion(float& gain);
+
+// 是否导出欧拉角，关闭后只更新四元数以省去三角函数
+void setIMUEulerOutput(bool enabled);
+
+// 启用传感器硬件FIFO (目前支持BMI270)，rateHz会取整到传感器支持的输出频率
+// 成功返回实际输出频率，不支持时返回0
+uint16_t enableIMUFifo(uint16_t rateHz);
+
+// 一次突发读取FIFO中的全部样本并完成融合，返回样本数
+// 超过maxCount的样本留到下一次读取
+size_t readIMUBatch(IMUData* samples, size_t maxCount);
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "imu/imu_fusion.h"
+#include <math.h>
+
+#define FUSION_DEG_TO_RAD 0.0174532925f
+#define FUSION_RAD_TO_DEG 57.2957795f
+
+// 平方根倒数
+static inline float invSqrt(float x) {
+  return 1.0f / sqrtf(x);
+}
+
+// 四元数归一化
+static inline void normalizeQuaternion(FusionState& s) {
+  float recipNorm = invSqrt(s.q0 * s.q0 + s.q1 * s.q1 + s.q2 * s.q2 + s.q3 * s.q3);
+  s.q0 *= recipNorm;
+  s.q1 *= recipNorm;
+  s.q2 *= recipNorm;
+  s.q3 *= recipNorm;
+}
+
+// 用第一次的加速度计数据初始化姿态，避免从水平姿态慢慢收敛 (只执行一次)
+static void initFromAccel(FusionState& s, float ax, float ay, float az) {
+  float halfRoll = 0.5f * atan2f(ay, az);
+  float halfPitch = 0.5f * atan2f(-ax, sqrtf(ay * ay + az * az));
+  float cr = cosf(halfRoll), sr = sinf(halfRoll);
+  float cp = cosf(halfPitch), sp = sinf(halfPitch);
+  s.q0 = cr * cp;
+  s.q1 = sr * cp;
+  s.q2 = cr * sp;
+  s.q3 = -sr * sp;
+  s.initialized = true;
+}
+
+// 初始化滤波器
+void fusionInit(FusionState& state, FusionAlgorithm algorithm, float gain) {
+  state.q0 = 1.0f;
+  state.q1 = 0.0f;
+  state.q2 = 0.0f;
+  state.q3 = 0.0f;
+  state.integralX = 0.0f;
+  state.integralY = 0.0f;
+  state.integralZ = 0.0f;
+  state.algorithm = algorithm;
+  state.gain = gain;
+  state.integralGain = 0.0f;
+  state.initialized = false;
+}
+
+// Madgwick 梯度下降更新 (陀螺仪单位rad/s，加速度计和磁力计已归一化)
+static void madgwickUpdate(FusionState& s, float gx, float gy, float gz,
+                           float ax, float ay, float az,
+                           float mx, float my, float mz, bool useMag, float dt) {
+  float q0 = s.q0, q1 = s.q1, q2 = s.q2, q3 = s.q3;
+
+  // 陀螺仪积分得到的四元数变化率
+  float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+  float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+  float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+  float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+  float s0, s1, s2, s3;
+  float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+  float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+
+  if (useMag) {
+    float q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+    float q1q2 = q1 * q2, q1q3 = q1 * q3, q2q3 = q2 * q3;
+    float _2q0mx = 2.0f * q0 * mx, _2q0my = 2.0f * q0 * my, _2q0mz = 2.0f * q0 * mz;
+    float _2q1mx = 2.0f * q1 * mx;
+    float _2q0q2 = 2.0f * q0 * q2, _2q2q3 = 2.0f * q2 * q3;
+
+    // 地磁场参考方向
+    float hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+    float hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+    float _2bx = sqrtf(hx * hx + hy * hy);
+    float _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+    float _4bx = 2.0f * _2bx, _4bz = 2.0f * _2bz;
+
+    // 目标函数的误差项
+    float fAx = 2.0f * q1q3 - _2q0q2 - ax;
+    float fAy = 2.0f * q0q1 + _2q2q3 - ay;
+    float fAz = 1.0f - 2.0f * q1q1 - 2.0f * q2q2 - az;
+    float fMx = _2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+    float fMy = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+    float fMz = _2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz;
+
+    // 梯度
+    s0 = -_2q2 * fAx + _2q1 * fAy - _2bz * q2 * fMx + (-_2bx * q3 + _2bz * q1) * fMy + _2bx * q2 * fMz;
+    s1 = _2q3 * fAx + _2q0 * fAy - 4.0f * q1 * fAz + _2bz * q3 * fMx + (_2bx * q2 + _2bz * q0) * fMy + (_2bx * q3 - _4bz * q1) * fMz;
+    s2 = -_2q0 * fAx + _2q3 * fAy - 4.0f * q2 * fAz + (-_4bx * q2 - _2bz * q0) * fMx + (_2bx * q1 + _2bz * q3) * fMy + (_2bx * q0 - _4bz * q2) * fMz;
+    s3 = _2q1 * fAx + _2q2 * fAy + (-_4bx * q3 + _2bz * q1) * fMx + (-_2bx * q0 + _2bz * q2) * fMy + _2bx * q1 * fMz;
+  } else {
+    float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+    float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+    s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+    s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+    s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+    s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+  }
+
+  // 沿梯度方向修正
+  float normSq = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+  if (normSq > 0.0f) {
+    float recipNorm = invSqrt(normSq);
+    qDot1 -= s.gain * s0 * recipNorm;
+    qDot2 -= s.gain * s1 * recipNorm;
+    qDot3 -= s.gain * s2 * recipNorm;
+    qDot4 -= s.gain * s3 * recipNorm;
+  }
+
+  s.q0 = q0 + qDot1 * dt;
+  s.q1 = q1 + qDot2 * dt;
+  s.q2 = q2 + qDot3 * dt;
+  s.q3 = q3 + qDot4 * dt;
+}
+
+// Mahony 互补滤波更新 (陀螺仪单位rad/s，加速度计和磁力计已归一化)
+static void mahonyUpdate(FusionState& s, float gx, float gy, float gz,
+                         float ax, float ay, float az,
+                         float mx, float my, float mz, bool useMag, float dt) {
+  float q0 = s.q0, q1 = s.q1, q2 = s.q2, q3 = s.q3;
+  float q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+  float q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+  float q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+
+  // 估计的重力方向
+  float halfvx = q1q3 - q0q2;
+  float halfvy = q0q1 + q2q3;
+  float halfvz = q0q0 - 0.5f + q3q3;
+
+  // 测量方向与估计方向的叉积即为误差
+  float halfex = ay * halfvz - az * halfvy;
+  float halfey = az * halfvx - ax * halfvz;
+  float halfez = ax * halfvy - ay * halfvx;
+
+  if (useMag) {
+    // 地磁场参考方向
+    float hx = 2.0f * (mx * (0.5f - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+    float hy = 2.0f * (mx * (q1q2 + q0q3) + my * (0.5f - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+    float bx = sqrtf(hx * hx + hy * hy);
+    float bz = 2.0f * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (0.5f - q1q1 - q2q2));
+
+    // 估计的地磁方向
+    float halfwx = bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+    float halfwy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+    float halfwz = bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2);
+
+    halfex += my * halfwz - mz * halfwy;
+    halfey += mz * halfwx - mx * halfwz;
+    halfez += mx * halfwy - my * halfwx;
+  }
+
+  // 积分反馈
+  if (s.integralGain > 0.0f) {
+    s.integralX += s.integralGain * halfex * dt;
+    s.integralY += s.integralGain * halfey * dt;
+    s.integralZ += s.integralGain * halfez * dt;
+    gx += s.integralX;
+    gy += s.integralY;
+    gz += s.integralZ;
+  }
+
+  // 比例反馈
+  gx += s.gain * halfex;
+  gy += s.gain * halfey;
+  gz += s.gain * halfez;
+
+  // 积分四元数
+  gx *= 0.5f * dt;
+  gy *= 0.5f * dt;
+  gz *= 0.5f * dt;
+  s.q0 = q0 + (-q1 * gx - q2 * gy - q3 * gz);
+  s.q1 = q1 + (q0 * gx + q2 * gz - q3 * gy);
+  s.q2 = q2 + (q0 * gy - q1 * gz + q3 * gx);
+  s.q3 = q3 + (q0 * gz + q1 * gy - q2 * gx);
+}
+
+// 融合一次样本
+void fusionUpdate(FusionState& state,
+                  float gx, float gy, float gz,
+                  float ax, float ay, float az,
+                  float mx, float my, float mz,
+                  float dt) {
+  float accNormSq = ax * ax + ay * ay + az * az;
+  // 加速度计无效时只积分陀螺仪
+  bool useAccel = accNormSq > 0.0f;
+
+  if (!state.initialized && useAccel) {
+    initFromAccel(state, ax, ay, az);
+    return;
+  }
+
+  gx *= FUSION_DEG_TO_RAD;
+  gy *= FUSION_DEG_TO_RAD;
+  gz *= FUSION_DEG_TO_RAD;
+
+  if (!useAccel) {
+    float q0 = state.q0, q1 = state.q1, q2 = state.q2, q3 = state.q3;
+    float h = 0.5f * dt;
+    state.q0 = q0 + h * (-q1 * gx - q2 * gy - q3 * gz);
+    state.q1 = q1 + h * (q0 * gx + q2 * gz - q3 * gy);
+    state.q2 = q2 + h * (q0 * gy - q1 * gz + q3 * gx);
+    state.q3 = q3 + h * (q0 * gz + q1 * gy - q2 * gx);
+    normalizeQuaternion(state);
+    return;
+  }
+
+  float recipNorm = invSqrt(accNormSq);
+  ax *= recipNorm;
+  ay *= recipNorm;
+  az *= recipNorm;
+
+  float magNormSq = mx * mx + my * my + mz * mz;
+  bool useMag = magNormSq > 0.0f;
+  if (useMag) {
+    recipNorm = invSqrt(magNormSq);
+    mx *= recipNorm;
+    my *= recipNorm;
+    mz *= recipNorm;
+  }
+
+  if (state.algorithm == FUSION_MAHONY) {
+    mahonyUpdate(state, gx, gy, gz, ax, ay, az, mx, my, mz, useMag, dt);
+  } else {
+    madgwickUpdate(state, gx, gy, gz, ax, ay, az, mx, my, mz, useMag, dt);
+  }
+  normalizeQuaternion(state);
+}
+
+// 导出欧拉角 (度)
+void fusionGetEuler(const FusionState& state, float& roll, float& pitch, float& yaw) {
+  float q0 = state.q0, q1 = state.q1, q2 = state.q2, q3 = state.q3;
+  roll = atan2f(q0 * q1 + q2 * q3, 0.5f - q1 * q1 - q2 * q2) * FUSION_RAD_TO_DEG;
+  float sinPitch = -2.0f * (q1 * q3 - q0 * q2);
+  if (sinPitch > 1.0f) sinPitch = 1.0f;
+  if (sinPitch < -1.0f) sinPitch = -1.0f;
+  pitch = asinf(sinPitch) * FUSION_RAD_TO_DEG;
+  yaw = atan2f(q1 * q2 + q0 * q3, 0.5f - q2 * q2 - q3 * q3) * FUSION_RAD_TO_DEG;
+  if (yaw < 0) {
+    yaw += 360.0f;
+  }
+}
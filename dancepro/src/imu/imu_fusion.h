@@ -0,0 +1,41 @@
+#ifndef IMU_FUSION_H
+#define IMU_FUSION_H
+
+// 四元数姿态融合 (Madgwick / Mahony)
+// 全部使用单精度运算，更新过程不调用三角函数，可在主机上单独编译
+
+// 融合算法
+enum FusionAlgorithm {
+  FUSION_MADGWICK,  // 梯度下降，gain为beta
+  FUSION_MAHONY     // 互补滤波PI控制，gain为比例增益2Kp
+};
+
+// 默认增益
+#define FUSION_DEFAULT_GAIN_MADGWICK 0.1f
+#define FUSION_DEFAULT_GAIN_MAHONY   1.0f
+
+// 融合滤波器状态
+struct FusionState {
+  float q0, q1, q2, q3;        // 姿态四元数 (w, x, y, z)
+  float integralX, integralY, integralZ;  // Mahony积分项
+  FusionAlgorithm algorithm;
+  float gain;                  // Madgwick beta 或 Mahony 2Kp
+  float integralGain;          // Mahony 2Ki，0为不使用积分
+  bool initialized;            // 是否已用加速度计初始化姿态
+};
+
+// 初始化滤波器
+void fusionInit(FusionState& state, FusionAlgorithm algorithm, float gain);
+
+// 融合一次样本
+// 陀螺仪单位dps，加速度计单位g，磁力计任意单位 (全为0时只用陀螺仪和加速度计)，dt单位秒
+void fusionUpdate(FusionState& state,
+                  float gx, float gy, float gz,
+                  float ax, float ay, float az,
+                  float mx, float my, float mz,
+                  float dt);
+
+// 导出欧拉角 (度)，yaw范围0-360
+void fusionGetEuler(const FusionState& state, float& roll, float& pitch, float& yaw);
+
+#endif
@@ -0,0 +1,163 @@
+#include "imu/imu_sampler.h"
+#include <atomic>
+#include <string.h>
+#include <M5Unified.h>
+#include "tasks/task_plan.h"
+#include "trace/trace.h"
+
+// 环形缓冲区槽位 (顺序锁)
+// seq = 序号*2+1 表示正在写入，序号*2+2 表示写入完成
+struct IMUSlot {
+  std::atomic<uint32_t> seq;
+  IMUSample sample;
+};
+
+static IMUSlot imuRing[IMU_RING_SIZE];
+static std::atomic<uint32_t> imuHead(0);  // 已写入的样本总数
+
+static volatile TickType_t samplePeriod = 1;  // 唤醒周期 (系统节拍)
+static uint16_t sampleRate = 0;               // 实际采样频率
+static bool batchEnabled = false;             // 是否批量读取FIFO
+static TaskHandle_t samplerTaskHandle = NULL;
+
+// 写入一个样本 (只有采样任务调用，单生产者)
+static void pushSample(const IMUSample& sample) {
+  uint32_t index = imuHead.load(std::memory_order_relaxed);
+  IMUSlot& slot = imuRing[index & (IMU_RING_SIZE - 1)];
+  slot.seq.store(index * 2 + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.sample = sample;
+  slot.seq.store(index * 2 + 2, std::memory_order_release);
+  imuHead.store(index + 1, std::memory_order_release);
+}
+
+// 读取指定序号的样本，已被覆盖或正在写入时返回false
+static bool readSlot(uint32_t index, IMUSample& sample) {
+  const IMUSlot& slot = imuRing[index & (IMU_RING_SIZE - 1)];
+  uint32_t expected = index * 2 + 2;
+  if (slot.seq.load(std::memory_order_acquire) != expected) {
+    return false;
+  }
+  sample = slot.sample;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  // 拷贝期间没有被改写才是一致的样本
+  return slot.seq.load(std::memory_order_relaxed) == expected;
+}
+
+// 逐个采样，每个样本一次I2C读取
+static void sampleOne(IMUSample& sample) {
+  if (updateIMUData(sample.data)) {
+    sample.timestamp = micros();
+    pushSample(sample);
+  }
+}
+
+// 批量采样，一次唤醒读出FIFO中的全部样本
+static void sampleBatch(IMUSample& sample) {
+  static IMUData batch[IMU_BATCH_MAX];
+  size_t count = readIMUBatch(batch, IMU_BATCH_MAX);
+  if (count == 0) {
+    return;
+  }
+  // 最后一个样本对应当前时刻，往前按采样间隔推算时间戳
+  uint32_t now = micros();
+  uint32_t periodUs = 1000000UL / sampleRate;
+  for (size_t i = 0; i < count; i++) {
+    sample.timestamp = now - (count - 1 - i) * periodUs;
+    sample.data = batch[i];
+    pushSample(sample);
+  }
+}
+
+// 采样任务，vTaskDelayUntil保证固定周期，不受处理耗时影响
+static void imuSamplerTask(void* pvParameters) {
+  IMUSample sample;
+  memset(&sample, 0, sizeof(sample));
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;) {
+    TRACE_BEGIN(TRACE_IMU_SAMPLE);
+    if (batchEnabled) {
+      sampleBatch(sample);
+    } else {
+      sampleOne(sample);
+    }
+    TRACE_END(TRACE_IMU_SAMPLE);
+    vTaskDelayUntil(&lastWake, samplePeriod);
+  }
+}
+
+// 启动固定频率采样任务
+bool startIMUSampler(uint16_t rateHz, bool batchMode) {
+  if (rateHz < IMU_SAMPLE_RATE_MIN) rateHz = IMU_SAMPLE_RATE_MIN;
+  if (rateHz > IMU_SAMPLE_RATE_MAX) rateHz = IMU_SAMPLE_RATE_MAX;
+
+  // 批量模式由传感器决定采样时刻，任务只需定期读出
+  uint16_t fifoRate = batchMode ? enableIMUFifo(rateHz) : 0;
+  if (fifoRate > 0) {
+    samplePeriod = pdMS_TO_TICKS(IMU_BATCH_PERIOD_MS);
+    sampleRate = fifoRate;
+    batchEnabled = true;
+  } else {
+    // 周期取整到系统节拍
+    TickType_t period = configTICK_RATE_HZ / rateHz;
+    if (period == 0) period = 1;
+    batchEnabled = false;
+    samplePeriod = period;
+    sampleRate = configTICK_RATE_HZ / period;
+  }
+
+  // 任务已在运行时只修改周期
+  if (samplerTaskHandle != NULL) {
+    M5.Log.printf("[IMU] 采样频率已修改为 %dHz\n", sampleRate);
+    return true;
+  }
+  // 在实时核心上以最高优先级运行，保证采样时刻稳定
+  if (!createPlannedTask(TASK_IMU_SAMPLER, imuSamplerTask, NULL, &samplerTaskHandle)) {
+    M5.Log.println("[IMU] 采样任务创建失败");
+    samplerTaskHandle = NULL;
+    return false;
+  }
+  M5.Log.printf("[IMU] 采样任务已启动，频率 %dHz\n", sampleRate);
+  return true;
+}
+
+// 实际采样频率
+uint16_t getIMUSampleRate() {
+  return sampleRate;
+}
+
+// 已写入的样本总数
+uint32_t getIMUSampleCursor() {
+  return imuHead.load(std::memory_order_acquire);
+}
+
+// 读取最新的一致样本
+bool getLatestIMUSample(IMUSample& sample) {
+  for (int retry = 0; retry < 3; retry++) {
+    uint32_t head = imuHead.load(std::memory_order_acquire);
+    if (head == 0) {
+      return false;
+    }
+    if (readSlot(head - 1, sample)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// 读取游标之后的新样本
+size_t readIMUSamples(uint32_t& cursor, IMUSample* samples, size_t maxCount) {
+  uint32_t head = imuHead.load(std::memory_order_acquire);
+  // 落后超过缓冲区长度，跳到仍然有效的最旧样本
+  if (head - cursor > IMU_RING_SIZE) {
+    cursor = head - IMU_RING_SIZE;
+  }
+  size_t count = 0;
+  while (cursor != head && count < maxCount) {
+    if (readSlot(cursor, samples[count])) {
+      count++;
+    }
+    cursor++;
+  }
+  return count;
+}
@@ -0,0 +1,44 @@
+#ifndef IMU_SAMPLER_H
+#define IMU_SAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "imu/imu.h"
+
+// 带时间戳的IMU样本
+struct IMUSample {
+  uint32_t timestamp;  // 采样时间 (us, micros())
+  IMUData data;        // 传感器数据和姿态角
+};
+
+// 采样频率范围 (Hz)
+#define IMU_SAMPLE_RATE_MIN     100
+#define IMU_SAMPLE_RATE_MAX     1000
+#define IMU_SAMPLE_RATE_DEFAULT 200
+
+// 环形缓冲区长度，必须是2的幂
+#define IMU_RING_SIZE 256
+
+// 批量模式下的唤醒周期 (ms) 和每批最多样本数
+#define IMU_BATCH_PERIOD_MS 20
+#define IMU_BATCH_MAX       32
+
+// 启动固定频率采样任务，频率会被限制在100-1000Hz
+// 批量模式: 传感器按频率写入硬件FIFO，任务每20ms唤醒一次整批读出，频率取整到传感器的输出频率
+// 逐个模式 (或传感器不支持FIFO): 每个样本唤醒一次，频率取整到系统节拍的整数分频
+bool startIMUSampler(uint16_t rateHz = IMU_SAMPLE_RATE_DEFAULT, bool batchMode = true);
+
+// 实际采样频率 (Hz)
+uint16_t getIMUSampleRate();
+
+// 已写入的样本总数，可作为消费者游标的初始值
+uint32_t getIMUSampleCursor();
+
+// 读取最新的一致样本，还没有样本时返回false
+bool getLatestIMUSample(IMUSample& sample);
+
+// 读取游标之后的新样本，返回读取的数量并推进游标
+// 消费者落后太多时会跳过已被覆盖的样本
+size_t readIMUSamples(uint32_t& cursor, IMUSample* samples, size_t maxCount);
+
+#endif
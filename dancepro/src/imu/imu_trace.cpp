@@ -0,0 +1,114 @@
+#include "imu/imu_trace.h"
+#include <math.h>
+#include <string.h>
+
+// 各轴的量化比例
+#define TRACE_ACC_SCALE  1000.0f  // g -> mg
+#define TRACE_GYRO_SCALE 10.0f    // dps -> 0.1dps
+#define TRACE_MAG_SCALE  10.0f    // uT -> 0.1uT
+
+static void putU16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+}
+
+static uint16_t getU16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t getU32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 量化到int16，四舍五入并截断
+static int16_t quantize(float value, float scale) {
+  float scaled = roundf(value * scale);
+  if (scaled > 32767.0f) return 32767;
+  if (scaled < -32768.0f) return -32768;
+  return (int16_t)scaled;
+}
+
+// 写入头部
+size_t imuTraceEncodeHeader(const IMUTraceHeader& header, uint8_t* buf, size_t len) {
+  if (len < IMU_TRACE_HEADER_SIZE) {
+    return 0;
+  }
+  uint32_t gainBits;
+  memcpy(&gainBits, &header.gain, sizeof(gainBits));
+  buf[0] = 'D';
+  buf[1] = 'T';
+  buf[2] = IMU_TRACE_VERSION;
+  buf[3] = (uint8_t)header.algorithm;
+  putU16(buf + 4, header.sampleRate);
+  putU16(buf + 6, header.tempo);
+  putU32(buf + 8, gainBits);
+  putU32(buf + 12, header.seed);
+  return IMU_TRACE_HEADER_SIZE;
+}
+
+// 解析头部
+bool imuTraceDecodeHeader(const uint8_t* buf, size_t len, IMUTraceHeader& header) {
+  if (len < IMU_TRACE_HEADER_SIZE || buf[0] != 'D' || buf[1] != 'T' || buf[2] != IMU_TRACE_VERSION) {
+    return false;
+  }
+  if (buf[3] != FUSION_MADGWICK && buf[3] != FUSION_MAHONY) {
+    return false;
+  }
+  uint32_t gainBits = getU32(buf + 8);
+  header.algorithm = (FusionAlgorithm)buf[3];
+  header.sampleRate = getU16(buf + 4);
+  header.tempo = getU16(buf + 6);
+  memcpy(&header.gain, &gainBits, sizeof(gainBits));
+  header.seed = getU32(buf + 12);
+  return true;
+}
+
+// 写入一个样本
+size_t imuTraceEncodeSample(const IMUSample& sample, uint8_t* buf, size_t len) {
+  if (len < IMU_TRACE_SAMPLE_SIZE) {
+    return 0;
+  }
+  const IMUData& d = sample.data;
+  const int16_t axes[9] = {
+    quantize(d.accX, TRACE_ACC_SCALE), quantize(d.accY, TRACE_ACC_SCALE), quantize(d.accZ, TRACE_ACC_SCALE),
+    quantize(d.gyroX, TRACE_GYRO_SCALE), quantize(d.gyroY, TRACE_GYRO_SCALE), quantize(d.gyroZ, TRACE_GYRO_SCALE),
+    quantize(d.magX, TRACE_MAG_SCALE), quantize(d.magY, TRACE_MAG_SCALE), quantize(d.magZ, TRACE_MAG_SCALE)
+  };
+  putU32(buf, sample.timestamp);
+  for (int i = 0; i < 9; i++) {
+    putU16(buf + 4 + i * 2, (uint16_t)axes[i]);
+  }
+  return IMU_TRACE_SAMPLE_SIZE;
+}
+
+// 解析一个样本
+bool imuTraceDecodeSample(const uint8_t* buf, size_t len, IMUSample& sample) {
+  if (len < IMU_TRACE_SAMPLE_SIZE) {
+    return false;
+  }
+  int16_t axes[9];
+  for (int i = 0; i < 9; i++) {
+    axes[i] = (int16_t)getU16(buf + 4 + i * 2);
+  }
+  memset(&sample, 0, sizeof(sample));
+  IMUData& d = sample.data;
+  sample.timestamp = getU32(buf);
+  d.accX = axes[0] / TRACE_ACC_SCALE;
+  d.accY = axes[1] / TRACE_ACC_SCALE;
+  d.accZ = axes[2] / TRACE_ACC_SCALE;
+  d.gyroX = axes[3] / TRACE_GYRO_SCALE;
+  d.gyroY = axes[4] / TRACE_GYRO_SCALE;
+  d.gyroZ = axes[5] / TRACE_GYRO_SCALE;
+  d.magX = axes[6] / TRACE_MAG_SCALE;
+  d.magY = axes[7] / TRACE_MAG_SCALE;
+  d.magZ = axes[8] / TRACE_MAG_SCALE;
+  d.qw = 1.0f;
+  return true;
+}
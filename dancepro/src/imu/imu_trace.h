@@ -0,0 +1,45 @@
+#ifndef IMU_TRACE_H
+#define IMU_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "imu/imu_sampler.h"
+
+// IMU轨迹格式 - 录制原始9轴数据，在主机上回放复现一次完整的演奏
+// 不依赖Arduino，可以在主机上单独编译
+//
+// 头部 (16字节):
+//   'D' 'T' 版本 融合算法 采样频率(uint16) 节拍速度(uint16, BPM) 融合增益(float) 作曲随机种子(uint32)
+// 每个样本22字节:
+//   时间戳(uint32, us) 加速度xyz(int16, mg) 角速度xyz(int16, 0.1dps) 磁场xyz(int16, 0.1uT)
+// 所有多字节字段都是小端。姿态角不录制，回放时用相同的融合算法重新计算
+
+#define IMU_TRACE_VERSION      1
+#define IMU_TRACE_HEADER_SIZE  16
+#define IMU_TRACE_SAMPLE_SIZE  22
+
+// 轨迹文件大小
+#define IMU_TRACE_SIZE(count) (IMU_TRACE_HEADER_SIZE + (size_t)(count) * IMU_TRACE_SAMPLE_SIZE)
+
+// 头部信息
+struct IMUTraceHeader {
+  uint16_t sampleRate;        // 采样频率 (Hz)
+  FusionAlgorithm algorithm;  // 录制时的融合算法
+  float gain;                 // 录制时的融合增益
+  uint32_t seed;              // 录制时的作曲随机种子
+  uint16_t tempo;             // 节拍时钟速度 (BPM)，0为按固定周期作曲
+};
+
+// 写入头部，空间不足返回0
+size_t imuTraceEncodeHeader(const IMUTraceHeader& header, uint8_t* buf, size_t len);
+
+// 解析头部，格式或版本不对返回false
+bool imuTraceDecodeHeader(const uint8_t* buf, size_t len, IMUTraceHeader& header);
+
+// 写入一个样本的时间戳和9轴数据，超出范围的值会被截断，空间不足返回0
+size_t imuTraceEncodeSample(const IMUSample& sample, uint8_t* buf, size_t len);
+
+// 解析一个样本，只填写时间戳和9轴数据，其余字段清零
+bool imuTraceDecodeSample(const uint8_t* buf, size_t len, IMUSample& sample);
+
+#endif
@@ -0,0 +1,116 @@
+#include "imu/imu_trace_recorder.h"
+#include <LittleFS.h>
+#include <M5Unified.h>
+#include "tasks/task_plan.h"
+
+static TaskHandle_t traceTaskHandle = NULL;
+static volatile bool recordRequested = false;  // 请求的录制状态
+static volatile bool recordActive = false;     // 文件是否打开
+static volatile uint32_t recordSeed = 0;
+static volatile uint16_t recordTempo = 0;
+// 每次开始录制加一，上一次停止还没关闭文件时又开始，录制任务关闭旧文件后马上打开新文件
+static volatile uint32_t recordGeneration = 0;
+
+// 录制任务: 打开、写入和关闭文件都在这里，其它任务只修改请求状态
+static void imuTraceTask(void* pvParameters) {
+  static IMUSample samples[32];
+  static uint8_t buffer[IMU_TRACE_BUFFER];
+  size_t used = 0;
+  size_t written = 0;
+  uint32_t cursor = 0;
+  uint32_t openGeneration = 0;
+  File file;
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, recordActive ? pdMS_TO_TICKS(IMU_TRACE_POLL_MS) : portMAX_DELAY);
+
+    if (recordActive) {
+      // 读出新样本，缓冲区攒满后写入
+      size_t count;
+      while ((count = readIMUSamples(cursor, samples, 32)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+          if (used + IMU_TRACE_SAMPLE_SIZE > sizeof(buffer)) {
+            written += file.write(buffer, used);
+            used = 0;
+          }
+          used += imuTraceEncodeSample(samples[i], buffer + used, sizeof(buffer) - used);
+        }
+      }
+
+      // 达到大小上限自动停止
+      if (written + used + IMU_TRACE_BUFFER > IMU_TRACE_MAX_BYTES && recordRequested && openGeneration == recordGeneration) {
+        M5.Log.println("[IMU] 轨迹文件已达上限，停止录制");
+        recordRequested = false;
+      }
+
+      // 停止录制，或者已经开始了新的录制: 写入剩余数据后关闭
+      if (!recordRequested || openGeneration != recordGeneration) {
+        written += file.write(buffer, used);
+        used = 0;
+        file.close();
+        recordActive = false;
+        M5.Log.printf("[IMU] 轨迹录制结束，%u 个样本\n",
+                      (unsigned)((written - IMU_TRACE_HEADER_SIZE) / IMU_TRACE_SAMPLE_SIZE));
+      }
+    }
+
+    // 开始录制: 写入头部，从当前样本开始
+    if (recordRequested && !recordActive) {
+      openGeneration = recordGeneration;
+      file = LittleFS.open(IMU_TRACE_PATH, FILE_WRITE);
+      if (!file) {
+        M5.Log.println("[IMU] 无法创建轨迹文件");
+        recordRequested = false;
+        continue;
+      }
+      IMUTraceHeader header;
+      header.sampleRate = getIMUSampleRate();
+      header.algorithm = getIMUFusion(header.gain);
+      header.seed = recordSeed;
+      header.tempo = recordTempo;
+      used = imuTraceEncodeHeader(header, buffer, sizeof(buffer));
+      written = 0;
+      cursor = getIMUSampleCursor();
+      recordActive = true;
+      M5.Log.printf("[IMU] 开始录制轨迹，%dHz\n", header.sampleRate);
+    }
+  }
+}
+
+// 开始录制
+bool startIMUTraceRecording(uint32_t seed, uint16_t tempo) {
+  if (traceTaskHandle == NULL) {
+    if (!LittleFS.begin(true)) {
+      M5.Log.println("[IMU] LittleFS挂载失败");
+      return false;
+    }
+    if (!createPlannedTask(TASK_IMU_TRACE, imuTraceTask, NULL, &traceTaskHandle)) {
+      M5.Log.println("[IMU] 轨迹录制任务创建失败");
+      traceTaskHandle = NULL;
+      return false;
+    }
+  }
+  // 上一次停止后文件还没关闭时不拒绝，录制任务关闭后马上开始
+  if (recordRequested) {
+    return false;
+  }
+  recordSeed = seed;
+  recordTempo = tempo;
+  recordGeneration = recordGeneration + 1;
+  recordRequested = true;
+  xTaskNotifyGive(traceTaskHandle);
+  return true;
+}
+
+// 停止录制
+void stopIMUTraceRecording() {
+  recordRequested = false;
+  if (traceTaskHandle != NULL) {
+    xTaskNotifyGive(traceTaskHandle);
+  }
+}
+
+// 是否正在录制
+bool isIMUTraceRecording() {
+  return recordRequested || recordActive;
+}
@@ -0,0 +1,26 @@
+#ifndef IMU_TRACE_RECORDER_H
+#define IMU_TRACE_RECORDER_H
+
+#include <Arduino.h>
+#include "imu/imu_trace.h"
+
+// 轨迹文件 (LittleFS)，每次录制覆盖上一次
+#define IMU_TRACE_PATH       "/imu_trace.bin"
+// 录制任务的唤醒周期 (ms)，必须远小于环形缓冲区能保存的时长
+#define IMU_TRACE_POLL_MS    50
+// 写缓冲区大小，攒满后一次写入闪存
+#define IMU_TRACE_BUFFER     (IMU_TRACE_SAMPLE_SIZE * 48)
+// 文件大小上限，200Hz时约12分钟
+#define IMU_TRACE_MAX_BYTES  (1024 * 1024)
+
+// 开始录制IMU轨迹，seed和tempo写入头部，回放时用同样的种子和速度作曲
+// 上一次录制的文件还没关闭时排队，关闭后马上开始；正在录制或任务创建失败时返回false
+bool startIMUTraceRecording(uint32_t seed, uint16_t tempo);
+
+// 停止录制，剩余数据由录制任务写入后关闭文件
+void stopIMUTraceRecording();
+
+// 是否正在录制 (包括还没写完的情况)
+bool isIMUTraceRecording();
+
+#endif
@@ -1,7 +1,20 @@
 #include <M5Unified.h>
 #include <Arduino.h>
+#include <atomic>
+#include "event/event_bus.h"
 #include "imu/imu.h"
+#include "imu/imu_sampler.h"
+#include "note/note_song_store.h"
+#include "note/note_recorder.h"
+#include "note/beat_clock.h"
+#include "gesture/gesture_task.h"
+#include "tempo/tempo_task.h"
+#include "synth/synth_task.h"
 #include "http/http.h"
+#include "http/live_stream.h"
+#include "metrics/metrics.h"
+#include "tasks/task_plan.h"
+#include "trace/trace.h"
 #include "wifi/my_wifi.h"
 #include "note/note.h"
 #include "home/home_ui.h"
@@ -14,275 +27,333 @@ TaskHandle_t imuTaskHandle = NULL;
 TaskHandle_t wifiTaskHandle = NULL;
 TaskHandle_t uiTaskHandle = NULL;
 TaskHandle_t httpTaskHandle = NULL;
-TaskHandle_t noteTaskHandle = NULL;
 
-// 变量
-extern IMUData ImuData; // imu数据
-int page = 0;           // 页面
-int lastPage = 0;
-bool canSwitchPage = true;           // 是否可以切换页面
-bool isRecording = false;            // 是否正在录制
-unsigned long recordStartTime = 0;   // 记录开始时间
-unsigned long currentRecordTime = 0; // 当前录制时间
-bool isTimeInitialized = false;      // 是否初始化时间
-String musicJSON = "";               // 音乐json字符串
-extern bool noteUIRedrawNeeded;      // 是否需要重新绘制各个ui界面
+// 按键A引脚 (AtomS3R)
+#define BUTTON_A_PIN 41
+
+// 变量 (跨任务读写的用原子变量，修改后通过事件总线通知)
+std::atomic<int> page(0);                      // 页面
+bool canSwitchPage = true;                     // 是否可以切换页面
+bool isTimeInitialized = false;                // 是否初始化时间 (只在wifi任务中使用)
+std::atomic<bool> traceEnabled(false);         // 录制音符时是否同时录制IMU轨迹
+extern bool noteUIRedrawNeeded;                // 是否需要重新绘制各个ui界面 (只在ui任务中修改)
 extern bool wifiUIRedrawNeeded;
 extern bool homeUIRedrawNeeded;
 
-// 传入任务句柄,删除任务
-void deleteTask(TaskHandle_t &taskHandle)
-{
-  if (taskHandle != NULL)
-  {
-    // 删除任务并释放其资源
-    vTaskDelete(taskHandle);
-    // 将任务句柄设置为 NULL，表示任务不存在
-    taskHandle = NULL;
-    M5.Log.println("Task deleted successfully");
-  }
-  else
-  {
-    M5.Log.println("Task already deleted or doesn't exist");
-  }
-}
-
-// 通过imu数据判断手腕动作,并切换页面
+// 通过手势事件切换页面
 void imu_task(void *pvParameters)
 {
-  ImuData = {0};
-  float prevRoll = 0;                     // 记录上一次的roll角度
-  const float threshold = 20;             // 定义角度变化阈值，可根据需要调整
-  unsigned long lastPageChangeTime = 0;   // 上次页面切换时间
-  const unsigned long debounceTime = 500; // 防抖时间（毫秒）
-  // 状态变量，用于跟踪手腕动作
-  enum WristState
-  {
-    NEUTRAL,     // 中立状态
-    FLIPPED_UP,  // 已向上翻转
-    FLIPPED_DOWN // 已向下翻转
-  };
-  WristState wristState = NEUTRAL;
+  GestureEvent event;
   for (;;)
   {
-    if (canSwitchPage)
+    // 阻塞等待手势事件，没有事件时不占用CPU
+    if (!waitGestureEvent(event, portMAX_DELAY))
     {
-      updateIMUData(ImuData);
-      // 记录当前时间
-      unsigned long currentTime = millis();
-      // 计算roll角度变化量
-      float rollChange = ImuData.roll - prevRoll;
-      // 基于角度变化和当前状态判断手腕动作
-      if (currentTime - lastPageChangeTime > debounceTime)
-      {
-        // 正在录制，不进行页面切换
-        if (isRecording)
-        {
-          lastPageChangeTime = currentTime;
-          continue;
-        }
-        // 检测手腕向上翻转
-        if (rollChange > threshold && wristState == NEUTRAL)
-        {
-          // 手腕从中立状态向上翻转，页面加1
-          lastPage = page;
-          page = (page + 1) % 3;
-          M5.Log.printf("手腕向上翻转，页面切换到: %d\n", page);
-          wristState = FLIPPED_UP;
-          lastPageChangeTime = currentTime;
-        }
-        // 检测手腕向下翻转
-        else if (rollChange < -threshold && wristState == NEUTRAL)
-        {
-          // 手腕从中立状态向下翻转，页面减1
-          lastPage = page;
-          page = (page > 0) ? (page - 1) : 2;
-          M5.Log.printf("手腕向下翻转，页面切换到: %d\n", page);
-          wristState = FLIPPED_DOWN;
-          lastPageChangeTime = currentTime;
-        }
-        // 检测手腕是否回到中立位置
-        else if (abs(rollChange) < 5 && (wristState == FLIPPED_UP || wristState == FLIPPED_DOWN))
-        {
-          // 手腕回到中立位置，重置状态但不改变页面
-          lastPage = page;
-          M5.Log.println("手腕回到中立位置");
-          wristState = NEUTRAL;
-        }
-      }
-      // 更新上一次的roll角度
-      prevRoll = ImuData.roll;
+      continue;
+    }
+    LoopTimer timer(METRIC_LOOP_IMU);
+    TRACE_SCOPE(TRACE_IMU_GESTURE);
+    // 正在录制，不进行页面切换
+    if (!canSwitchPage || isNoteRecording())
+    {
+      continue;
+    }
+    int current = page;
+    switch (event.type)
+    {
+    case GESTURE_FLIP_UP:
+      // 手腕向上翻转，页面加1
+      page = (current + 1) % 3;
+      postEvent(EVENT_PAGE_CHANGED);
+      M5.Log.printf("手腕向上翻转，页面切换到: %d\n", (int)page);
+      break;
+    case GESTURE_FLIP_DOWN:
+      // 手腕向下翻转，页面减1
+      page = (current > 0) ? (current - 1) : 2;
+      postEvent(EVENT_PAGE_CHANGED);
+      M5.Log.printf("手腕向下翻转，页面切换到: %d\n", (int)page);
+      break;
+    default:
+      M5.Log.printf("检测到手势: %s\n", gestureName(event.type));
+      break;
     }
-    vTaskDelay(150);
   }
 }
 
 // wifi连接任务
 void wifi_task(void *pvParameters)
 {
+  // 连接/断开时立即处理，否则每秒检查一次超时和重连
+  subscribeEvents(EVENT_WIFI_LINK);
   setupWiFi();
   for (;;)
   {
+    monitorWiFi();
     if (getWiFiStatus() == WIFI_CONNECTED && !isTimeInitialized)
     {
       isTimeInitialized = true;
       initTimeAsync();
     }
-    monitorWiFi();
-    vTaskDelay(100 / portTICK_PERIOD_MS);
+    waitEvents(1000 / portTICK_PERIOD_MS);
   }
 }
 
 // ui显示任务
+// 页面切换、录制状态和WiFi状态变化时立即重绘，其余时间只按动画需要的间隔刷新
 void ui_task(void *pvParameters)
 {
+  IMUSample sample = {0};
+  int shownPage = -1; // 当前显示的页面
+  subscribeEvents(EVENT_PAGE_CHANGED | EVENT_RECORD_START | EVENT_RECORD_STOP | EVENT_WIFI_CHANGED);
   for (;;)
   {
-    switch (page)
+    int64_t frameStart = esp_timer_get_time();
+    TRACE_BEGIN(TRACE_UI_FRAME);
+    int current = page;
+    bool pageChanged = (shownPage != current);
+    shownPage = current;
+    TickType_t frameInterval = 100 / portTICK_PERIOD_MS;
+    switch (current)
     {
     case 0: // 主界面
-      if (lastPage != page)
+      if (pageChanged)
       {
         homeUIRedrawNeeded = true;
-        lastPage = page;
       }
       displayHomeUI();
+      frameInterval = HOME_ANIM_FRAME_MS / portTICK_PERIOD_MS;
       break;
     case 1: // 音符录制界面
-      if (lastPage != page)
+    {
+      if (pageChanged)
       {
         noteUIRedrawNeeded = true;
-        lastPage = page;
       }
-      if (isRecording)
-      {
-
-        currentRecordTime = millis() - recordStartTime;
-      }
-      displayNoteUI(isRecording, currentRecordTime, ImuData);
+      getLatestIMUSample(sample);
+      displayNoteUI(isNoteRecording(), getRecordingTime(), sample.data);
       break;
+    }
     case 2: // wifi界面
-      if (lastPage != page)
+    {
+      if (pageChanged)
       {
         wifiUIRedrawNeeded = true;
-        lastPage = page;
       }
-      // M5.Display.clear();
-      displayWiFiUI(getWiFiStatus());
+      WiFiStatus status = getWiFiStatus();
+      displayWiFiUI(status);
+      // 只有连接中的动画需要频繁刷新
+      if (status != WIFI_CONNECTING && status != WIFI_INIT)
+      {
+        frameInterval = 1000 / portTICK_PERIOD_MS;
+      }
       break;
     }
-    vTaskDelay(100 / portTICK_PERIOD_MS);
+    }
+    TRACE_END(TRACE_UI_FRAME);
+    recordLoopLatency(METRIC_LOOP_UI, (uint32_t)(esp_timer_get_time() - frameStart));
+    waitEvents(frameInterval);
   }
 }
 
-// 音乐处理任务
-void note_task(void *pvParameters)
+// 按键电平变化中断，唤醒按钮任务
+static void IRAM_ATTR buttonISR()
 {
-  for (;;)
+  BaseType_t woken = pdFALSE;
+  postEventFromISR(EVENT_BUTTON, &woken);
+  if (woken)
   {
-    // 检查 JSON 大小，超过一定限制就停止添加
-    if (musicJSON.length() < 10000)
-    { // 设置合理的大小限制，例如 10KB
-      musicJSON = mapIMUToMusicJSON(ImuData, musicJSON);
-    }
-    else
-    {
-      M5.Log.println("警告：JSON 数据过大，停止记录");
-      isRecording = false; // 自动停止录制
-    }
-    vTaskDelay(500 / portTICK_PERIOD_MS);
+    portYIELD_FROM_ISR();
   }
 }
 
+// 按钮按下后持续消抖的时间
+#define BUTTON_ACTIVE_MS 200
+
 // 通过按钮进入页面功能
 void button_task(void *pvParameters)
 {
+  subscribeEvents(EVENT_BUTTON);
+  attachInterrupt(digitalPinToInterrupt(BUTTON_A_PIN), buttonISR, CHANGE);
+  unsigned long lastActive = 0;
   for (;;)
   {
     M5.update(); // 必须首先调用，更新按钮状态
-    if (page == 0 && M5.BtnA.wasPressed())
+    int current = page;
+    if (current == 0 && M5.BtnA.wasPressed())
     {
       M5.Log.println("进入页面0");
     }
-    if (page == 1 && M5.BtnA.wasPressed())
+    if (current == 1 && M5.BtnA.wasPressed())
     {
       M5.Log.println("进入页面1");
-      isRecording = !isRecording;
-      recordStartTime = millis();
-      if (isRecording)
+      // 录制任务常驻，这里只发送命令，结束的会话由保存任务空闲时写入flash
+      if (!isNoteRecording())
       {
-        musicJSON = "[]";
-        xTaskCreate(note_task, "NoteTask", 8192, NULL, 1, &noteTaskHandle);
+        startRecording(traceEnabled);
       }
       else
       {
-        vTaskDelete(noteTaskHandle);
-        // M5.Log.println(musicJSON.c_str());
-        uploadAndReplaceNoteData(musicJSON);
+        stopRecording();
       }
     }
-    if (page == 2 && M5.BtnA.wasPressed())
+    if (current == 2 && M5.BtnA.wasPressed())
     {
       M5.Log.println("进入页面2");
       resetWiFi();
     }
-    vTaskDelay(10 / portTICK_PERIOD_MS);
+    // 按键按下或刚有动作时按10ms轮询消抖，空闲时阻塞等待中断
+    if (M5.BtnA.isPressed() || M5.BtnA.wasReleased())
+    {
+      lastActive = millis();
+    }
+    if (millis() - lastActive < BUTTON_ACTIVE_MS)
+    {
+      vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
+    else if (waitEvents(1000 / portTICK_PERIOD_MS) & EVENT_BUTTON)
+    {
+      lastActive = millis();
+    }
+  }
+}
+
+// 控制命令，每个命令读取同名字段，可以单独发送 (如 {"action":"tempo","bpm":120})，也可以在settings中组合
+// 只读取文档中的字段，不分配内存
+static void brightnessCommand(const JsonDocument &data)
+{
+  if (!data["brightness"].isNull())
+  {
+    int brightness = data["brightness"].as<int>();
+    M5.Display.setBrightness(brightness); // 范围0-255
+    M5.Log.printf("亮度已设置为: %d\n", brightness);
+  }
+}
+
+static void restartCommand(const JsonDocument &data)
+{
+  if (data["restart"].as<bool>())
+  {
+    M5.Log.println("正在重启设备...");
+    ESP.restart();
+  }
+}
+
+static void sleepCommand(const JsonDocument &data)
+{
+  if (data["sleep"].as<bool>())
+  {
+    M5.Log.println("进入休眠模式...");
+    M5.Power.deepSleep();
+  }
+}
+
+static void tempoCommand(const JsonDocument &data)
+{
+  if (data["bpm"].isNull())
+  {
+    return;
+  }
+  // 节拍速度 (BPM)，录制中也立即生效，并关闭默认的跟随舞者；"auto" 恢复跟随舞者的速度
+  const char *mode = data["bpm"].as<const char *>();
+  if (mode != NULL && strcmp(mode, "auto") == 0)
+  {
+    setTempoFollow(true);
+    M5.Log.println("节拍速度跟随舞者");
+  }
+  else
+  {
+    setTempoFollow(false);
+    setBeatClockTempo(data["bpm"].as<int>());
+    M5.Log.printf("节拍速度已设置为: %d BPM\n", getBeatClockTempo());
+  }
+}
+
+// 删除所有保存的录制会话 (GET /api/sessions)，删除文件由保存任务执行，不阻塞AsyncTCP任务
+static void sessionsCommand(const JsonDocument &data)
+{
+  if (data["clear"].as<bool>())
+  {
+    clearRecordings();
   }
 }
 
 // http 注册数据回调函数
 void registerCallbacks()
 {
+  setDataReceiveCallback("brightness", brightnessCommand);
+  setDataReceiveCallback("restart", restartCommand);
+  setDataReceiveCallback("sleep", sleepCommand);
+  setDataReceiveCallback("tempo", tempoCommand);
+  setDataReceiveCallback("sessions", sessionsCommand);
   // 注册处理设置的回调
   setDataReceiveCallback("settings", [](const JsonDocument &data)
                          {
     // 处理设置
-    if (!data["brightness"].isNull()) { // 修改为使用isNull()
-      int brightness = data["brightness"].as<int>();
-      M5.Display.setBrightness(brightness);//范围0-255
-      M5.Log.printf("亮度已设置为: %d\n", brightness);
-      // 这里可以添加亮度控制代码
+    brightnessCommand(data);
+    restartCommand(data);
+    if (!data["fusion"].isNull()) {
+      // 切换姿态融合算法: "madgwick" 或 "mahony"，可选增益fusionGain
+      const char *algorithm = data["fusion"] | "madgwick";
+      bool mahony = strcmp(algorithm, "mahony") == 0;
+      float gain = data["fusionGain"] | (mahony ? FUSION_DEFAULT_GAIN_MAHONY : FUSION_DEFAULT_GAIN_MADGWICK);
+      setIMUFusion(mahony ? FUSION_MAHONY : FUSION_MADGWICK, gain);
+      M5.Log.printf("融合算法已设置为: %s, 增益: %.2f\n", algorithm, gain);
     }
-    if (!data["restart"].isNull()) { // 修改为使用isNull()
-      bool restart = data["restart"].as<bool>();
-      if(restart){
-        M5.Log.println("正在重启设备...");
-        ESP.restart();
-      }
+    if (!data["trace"].isNull()) {
+      // 之后的音符录制同时录制IMU轨迹，下载: GET /api/imu/trace
+      traceEnabled = data["trace"].as<bool>();
+      M5.Log.printf("IMU轨迹录制已%s\n", traceEnabled ? "开启" : "关闭");
     }
-    if(!data["sleep"].isNull()){
-      bool sleep = data["sleep"].as<bool>();
-      if(sleep){
-        M5.Log.println("进入休眠模式...");
-        M5.Power.deepSleep();
-      }
-    } });
+    tempoCommand(data);
+    if (!data["synth"].isNull()) {
+      // 实时发声开关，可选音量volume (0-255)
+      setSynthMute(!data["synth"].as<bool>());
+      M5.Log.printf("实时发声已%s\n", data["synth"].as<bool>() ? "开启" : "关闭");
+    }
+    if (!data["volume"].isNull()) {
+      setSynthVolume(constrain(data["volume"].as<int>(), 0, 255));
+    }
+    if (!data["song"].isNull()) {
+      // 切换乐谱 (LittleFS中 /songs/<名称>.bin，"dance"为内置舞曲)，下次录制生效
+      const char *song = data["song"] | NOTE_SONG_BUILTIN;
+      selectNoteSong(song);
+    }
+    sleepCommand(data); });
 }
 
+// 检查HTTP服务器状态的间隔
+#define HTTP_CHECK_PERIOD_MS 30000
+
 // HTTP服务器任务
 void http_task(void *pvParameters)
 {
-  // 等待WiFi连接
-  while (WiFi.status() != WL_CONNECTED)
+  // 等待WiFi连接，状态变化时才被唤醒
+  subscribeEvents(EVENT_WIFI_CHANGED);
+  M5.Log.println("等待WiFi连接...");
+  while (getWiFiStatus() != WIFI_CONNECTED)
   {
-    M5.Log.println("等待WiFi连接...");
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    waitEvents(portMAX_DELAY);
   }
   M5.Log.println("wifi连接成功，HTTP服务器任务开始\n");
-  // 初始化HTTP服务器
-  setupHTTPServer();
-  // 注册数据回调函数
+  // 注册数据回调函数 (在服务器启动前注册，之后只读)
   registerCallbacks();
-  // 任务循环
+  // 初始化HTTP服务器，请求由AsyncTCP任务处理，实时推送的WebSocket也在同一个服务器上
+  setupHTTPServer();
+  // 录制新音符时被唤醒并推送，不再定时轮询 (缓冲区满时最后一个音符随停止事件推送)
+  subscribeEvents(EVENT_NOTE_ADDED | EVENT_RECORD_STOP);
+  uint32_t lastCheckTime = millis();
   for (;;)
   {
-    // 处理HTTP请求
-    handleHTTPRequests();
+    int64_t loopStart = esp_timer_get_time();
+    TRACE_BEGIN(TRACE_HTTP_LOOP);
+    // 推送新音符，返回下一次需要推送的时间 (有积压或订阅了IMU帧)
+    uint32_t wait = handleLiveClients();
     // 检查服务器状态
-    static unsigned long lastCheckTime = 0;
-    if (millis() - lastCheckTime > 30000)
-    { // 每30秒检查一次
+    uint32_t sinceCheck = millis() - lastCheckTime;
+    if (sinceCheck >= HTTP_CHECK_PERIOD_MS)
+    {
       lastCheckTime = millis();
+      sinceCheck = 0;
       HTTPServerStatus status = getHTTPServerStatus();
       if (!status.isRunning)
       {
@@ -290,24 +361,44 @@ void http_task(void *pvParameters)
         restartHTTPServer();
       }
     }
-    // 给其他任务运行的时间
-    vTaskDelay(10 / portTICK_PERIOD_MS);
+    TRACE_END(TRACE_HTTP_LOOP);
+    recordLoopLatency(METRIC_LOOP_HTTP, (uint32_t)(esp_timer_get_time() - loopStart));
+    // 等待新音符，最迟到下一次推送或状态检查
+    if (HTTP_CHECK_PERIOD_MS - sinceCheck < wait)
+    {
+      wait = HTTP_CHECK_PERIOD_MS - sinceCheck;
+    }
+    waitEvents(pdMS_TO_TICKS(wait));
   }
 }
 
 // 开始任务,用于创建其他任务
 void start_task(void *pvParameters)
 {
+  // 热路径跟踪 (GET /api/trace 导出)
+  startTrace();
+  // 各核心的CPU占用 (GET /api/metrics 输出)
+  startCPUMeter();
+  // imu采样任务
+  startIMUSampler(IMU_SAMPLE_RATE_DEFAULT);
+  // 手势检测任务
+  startGestureTask();
+  // 舞蹈速度检测任务
+  startTempoTask();
+  // 音色合成任务 (没有接扬声器时不启动)
+  startSynthTask();
+  // 音符录制任务
+  startNoteRecorder();
   // 按钮任务
-  xTaskCreate(button_task, "ButtonTask", 8192, NULL, 2, &buttonTaskHandle);
+  createPlannedTask(TASK_BUTTON, button_task, NULL, &buttonTaskHandle);
   // imu任务
-  xTaskCreate(imu_task, "IMUTask", 4096, NULL, 1, &imuTaskHandle);
+  createPlannedTask(TASK_IMU, imu_task, NULL, &imuTaskHandle);
   // ui任务
-  xTaskCreate(ui_task, "UITask", 4096, NULL, 1, &uiTaskHandle);
+  createPlannedTask(TASK_UI, ui_task, NULL, &uiTaskHandle);
   // wifi任务
-  xTaskCreate(wifi_task, "WifiTask", 4096, NULL, 1, &wifiTaskHandle);
+  createPlannedTask(TASK_WIFI, wifi_task, NULL, &wifiTaskHandle);
   // http任务
-  xTaskCreate(http_task, "HttpTask", 4096, NULL, 1, &httpTaskHandle);
+  createPlannedTask(TASK_HTTP, http_task, NULL, &httpTaskHandle);
 
   vTaskDelete(NULL);
 }
@@ -318,10 +409,11 @@ void setup()
   // 正确配置M5Unified，启用串口输出
   auto cfg = M5.config();
   cfg.serial_baudrate = 115200; // 设置波特率
+  cfg.external_speaker.atomic_echo = 1; // Atomic Echo Base 扬声器
   M5.begin(cfg);
   M5.Log.println("M5.Log测试");
   // 创建开始任务
-  xTaskCreate(start_task, "StartTask", 4096, NULL, 1, NULL);
+  createPlannedTask(TASK_START, start_task, NULL, NULL);
 }
 
 void loop()
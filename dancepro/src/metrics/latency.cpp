@@ -0,0 +1,66 @@
+#include "metrics/latency.h"
+#include <stdio.h>
+
+// 延迟所在的桶
+static inline uint32_t bucketOf(uint32_t us) {
+  uint32_t index = (us == 0) ? 0 : 31 - __builtin_clz(us);
+  return index < LATENCY_BUCKETS ? index : LATENCY_BUCKETS - 1;
+}
+
+// 记录一次延迟
+void latencyRecord(LatencyHistogram& histogram, uint32_t us) {
+  histogram.buckets[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+  histogram.count.fetch_add(1, std::memory_order_relaxed);
+  uint32_t max = histogram.max.load(std::memory_order_relaxed);
+  while (us > max && !histogram.max.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+  }
+}
+
+// 清零
+void latencyReset(LatencyHistogram& histogram) {
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    histogram.buckets[i].store(0, std::memory_order_relaxed);
+  }
+  histogram.count.store(0, std::memory_order_relaxed);
+  histogram.max.store(0, std::memory_order_relaxed);
+}
+
+// 百分位数的上界
+uint32_t latencyPercentile(const LatencyHistogram& histogram, uint8_t percent) {
+  // 各桶分别读取，与count可能差几次记录，按桶的总数计算
+  uint32_t counts[LATENCY_BUCKETS];
+  uint32_t total = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    counts[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  uint32_t rank = (uint32_t)(((uint64_t)total * percent + 99) / 100);
+  // 上界不超过记录到的最大值
+  uint32_t max = histogram.max.load(std::memory_order_relaxed);
+  uint32_t seen = 0;
+  for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+    seen += counts[i];
+    if (seen >= rank) {
+      uint32_t bound = (2u << i) - 1;
+      return bound < max ? bound : max;
+    }
+  }
+  return max;
+}
+
+// 写成紧凑JSON
+size_t latencyToJSON(const LatencyHistogram& histogram, char* buf, size_t len) {
+  int written = snprintf(buf, len, "{\"n\":%u,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u}",
+                         (unsigned)histogram.count.load(std::memory_order_relaxed),
+                         (unsigned)latencyPercentile(histogram, 50),
+                         (unsigned)latencyPercentile(histogram, 90),
+                         (unsigned)latencyPercentile(histogram, 99),
+                         (unsigned)histogram.max.load(std::memory_order_relaxed));
+  if (written < 0 || (size_t)written >= len) {
+    return 0;
+  }
+  return written;
+}
@@ -0,0 +1,32 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// 延迟直方图 - 按2的幂分桶的计数器，记录和读取都不加锁，可以在任意任务中记录
+// 第0桶为 0-1us，第i桶为 [2^i, 2^(i+1)) us，最后一桶包括更长的延迟
+// 百分位数取所在桶的上界，误差在2倍以内，足够看出卡顿发生在哪个数量级
+
+#define LATENCY_BUCKETS 24  // 最后一桶从约8.4秒开始
+
+struct LatencyHistogram {
+  std::atomic<uint32_t> buckets[LATENCY_BUCKETS];
+  std::atomic<uint32_t> count;
+  std::atomic<uint32_t> max;  // 最大延迟 (us)
+};
+
+// 记录一次延迟 (us)
+void latencyRecord(LatencyHistogram& histogram, uint32_t us);
+
+// 清零
+void latencyReset(LatencyHistogram& histogram);
+
+// 第percent百分位数的上界 (us)，没有记录时返回0
+uint32_t latencyPercentile(const LatencyHistogram& histogram, uint8_t percent);
+
+// 写成紧凑JSON: {"n":次数,"p50":us,"p90":us,"p99":us,"max":us}，空间不足返回0
+size_t latencyToJSON(const LatencyHistogram& histogram, char* buf, size_t len);
+
+#endif
@@ -0,0 +1,240 @@
+#include "metrics/metrics.h"
+#include <esp_heap_caps.h>
+#include <M5Unified.h>
+#include <esp_freertos_hooks.h>
+#include <stdarg.h>
+#include "note/beat_clock.h"
+#include "synth/synth_task.h"
+#include "tasks/task_plan.h"
+
+static LatencyHistogram loopLatency[METRIC_LOOP_COUNT];
+static LatencyHistogram httpLatency;
+
+static const char *const LOOP_NAMES[METRIC_LOOP_COUNT] = {"imu", "ui", "note", "http"};
+
+// 上一次输出时的任务快照，用于计算这段时间内的CPU占用
+static TaskSnapshot lastSnapshot = {NULL, 0, 0, false};
+
+// 各核心空闲任务运行的时间 (us，32位回绕，只由该核心的空闲任务写)
+// 空闲钩子在空闲任务中反复调用，两次调用的间隔很短说明这段时间一直在空闲，
+// 间隔长说明其他任务或中断运行过，这段不计入
+#define CPU_IDLE_GAP_US 50
+static volatile uint32_t idleTime[portNUM_PROCESSORS];
+static uint32_t idleLast[portNUM_PROCESSORS];
+static bool cpuMeterStarted = false;
+
+// 上一次输出时的空闲时间，用于计算这段时间内各核心的占用
+static uint32_t lastIdleTime[portNUM_PROCESSORS];
+static int64_t lastCoreTime = 0;
+
+static bool countIdle()
+{
+  int core = xPortGetCoreID();
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  uint32_t gap = now - idleLast[core];
+  if (gap < CPU_IDLE_GAP_US)
+  {
+    idleTime[core] += gap;
+  }
+  idleLast[core] = now;
+  // 返回false: 不执行waiti，保持钩子连续调用，计时精确到几微秒
+  return false;
+}
+
+// 开始统计各核心的空闲时间
+void startCPUMeter()
+{
+  if (cpuMeterStarted)
+  {
+    return;
+  }
+  for (int core = 0; core < portNUM_PROCESSORS; core++)
+  {
+    if (esp_register_freertos_idle_hook_for_cpu(countIdle, core) != ESP_OK)
+    {
+      M5.Log.printf("[Metrics] 核心%d的空闲钩子注册失败\n", core);
+      return;
+    }
+  }
+  cpuMeterStarted = true;
+}
+
+// 记录一次循环的耗时
+void recordLoopLatency(MetricLoop loop, uint32_t us)
+{
+  latencyRecord(loopLatency[loop], us);
+}
+
+// 记录一次HTTP请求的时间
+void recordHTTPLatency(uint32_t us)
+{
+  latencyRecord(httpLatency, us);
+}
+
+// 清零所有直方图
+void resetMetrics()
+{
+  for (int i = 0; i < METRIC_LOOP_COUNT; i++)
+  {
+    latencyReset(loopLatency[i]);
+  }
+  latencyReset(httpLatency);
+}
+
+// 追加写入，空间不足时标记失败，之后的写入都忽略
+struct JSONWriter
+{
+  char *buf;
+  size_t len;
+  size_t used;
+  bool failed;
+
+  void printf(const char *format, ...)
+  {
+    if (failed)
+    {
+      return;
+    }
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buf + used, len - used, format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= len - used)
+    {
+      failed = true;
+      return;
+    }
+    used += written;
+  }
+
+  void latency(const LatencyHistogram &histogram)
+  {
+    if (failed)
+    {
+      return;
+    }
+    size_t written = latencyToJSON(histogram, buf + used, len - used);
+    if (written == 0)
+    {
+      failed = true;
+      return;
+    }
+    used += written;
+  }
+};
+
+// 各核心在两次输出之间的CPU占用 (百分比)，第一次输出或没有空闲钩子时为空数组
+static void writeCores(JSONWriter &out)
+{
+  int64_t now = esp_timer_get_time();
+  uint32_t elapsed = (uint32_t)(now - lastCoreTime);
+  out.printf("\"cores\":[");
+  for (int core = 0; core < portNUM_PROCESSORS; core++)
+  {
+    uint32_t idle = idleTime[core];
+    if (cpuMeterStarted && lastCoreTime != 0 && elapsed > 0)
+    {
+      float busy = 100.0f - (idle - lastIdleTime[core]) * 100.0f / elapsed;
+      out.printf("%s%.1f", core > 0 ? "," : "", busy < 0 ? 0.0f : busy);
+    }
+    lastIdleTime[core] = idle;
+  }
+  out.printf("],");
+  lastCoreTime = now;
+}
+
+// 各任务的CPU占用 (相对单个核心的百分比，双核合计最多200) 和栈余量 (字节)
+// 快照数组按当前任务数分配，没有取到任务列表时 tasksTruncated 为true
+// 任务级的CPU占用需要 configGENERATE_RUN_TIME_STATS，没有时 cpuAvailable 为false，只有 cores 中的核心占用
+static void writeTasks(JSONWriter &out)
+{
+#if configGENERATE_RUN_TIME_STATS
+  out.printf("\"cpuAvailable\":true,");
+#else
+  out.printf("\"cpuAvailable\":false,");
+#endif
+#if configUSE_TRACE_FACILITY
+  TaskSnapshot snapshot;
+  takeTaskSnapshot(snapshot);
+#if configGENERATE_RUN_TIME_STATS
+  uint32_t elapsed = snapshot.totalRunTime - lastSnapshot.totalRunTime;
+#endif
+
+  out.printf("\"tasks\":[");
+  for (UBaseType_t i = 0; i < snapshot.count; i++)
+  {
+    const TaskStatus_t &task = snapshot.tasks[i];
+    out.printf("%s{\"name\":\"%s\",\"prio\":%u,\"stack\":%u", i > 0 ? "," : "", task.pcTaskName,
+               (unsigned)task.uxCurrentPriority, (unsigned)task.usStackHighWaterMark);
+#if configTASKLIST_INCLUDE_COREID
+    out.printf(",\"core\":%d", task.xCoreID == tskNO_AFFINITY ? -1 : (int)task.xCoreID);
+#endif
+#if configGENERATE_RUN_TIME_STATS
+    // 找到上一次的运行时间，新任务从0开始算
+    uint32_t previous = 0;
+    for (UBaseType_t j = 0; j < lastSnapshot.count; j++)
+    {
+      if (lastSnapshot.tasks[j].xHandle == task.xHandle)
+      {
+        previous = lastSnapshot.tasks[j].ulRunTimeCounter;
+        break;
+      }
+    }
+    if (lastSnapshot.totalRunTime != 0 && elapsed > 0)
+    {
+      out.printf(",\"cpu\":%.1f", (task.ulRunTimeCounter - previous) * 100.0f / elapsed);
+    }
+#endif
+    out.printf("}");
+  }
+  out.printf("],\"tasksTruncated\":%s,", snapshot.truncated ? "true" : "false");
+
+  // 保留这一次的快照，没有取到时保留上一次的
+  if (snapshot.count > 0)
+  {
+    freeTaskSnapshot(lastSnapshot);
+    lastSnapshot = snapshot;
+  }
+#endif
+}
+
+// 任务布局表 (核心为-1表示不固定)，与 tasks 中实际的核心和优先级对照
+static void writePlan(JSONWriter &out)
+{
+  out.printf("\"plan\":[");
+  for (int i = 0; i < TASK_PLAN_COUNT; i++)
+  {
+    const TaskPlan &plan = TASK_PLAN[i];
+    out.printf("%s{\"name\":\"%s\",\"core\":%d,\"prio\":%u,\"stack\":%u}", i > 0 ? "," : "", plan.name,
+               (int)plan.core, (unsigned)plan.priority, (unsigned)plan.stack);
+  }
+  out.printf("],");
+}
+
+// 写出全部指标的JSON
+size_t writeMetricsJSON(char *buf, size_t len)
+{
+  JSONWriter out = {buf, len, 0, false};
+  out.printf("{\"uptime\":%lu,", (unsigned long)millis());
+  out.printf("\"heap\":{\"free\":%u,\"min\":%u,\"largest\":%u},",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+  out.printf("\"psram\":{\"free\":%u,\"largest\":%u},",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
+  writeCores(out);
+  writeTasks(out);
+  writePlan(out);
+
+  out.printf("\"loops\":{");
+  for (int i = 0; i < METRIC_LOOP_COUNT; i++)
+  {
+    out.printf("%s\"%s\":", i > 0 ? "," : "", LOOP_NAMES[i]);
+    out.latency(loopLatency[i]);
+  }
+  out.printf("},\"http\":");
+  out.latency(httpLatency);
+  out.printf(",\"beatLate\":%u,\"synthLatency\":%u}", (unsigned)getBeatClockMaxLateness(), (unsigned)getSynthMaxLatency());
+  return out.failed ? 0 : out.used;
+}
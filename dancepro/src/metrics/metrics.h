@@ -0,0 +1,49 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "metrics/latency.h"
+
+// 运行指标 - 各任务的CPU占用和栈余量、任务布局表、循环延迟直方图、堆内存和HTTP请求延迟
+// 计数器都是固定大小的原子变量，记录时不加锁也不分配内存，GET /api/metrics 输出紧凑JSON
+
+// 有延迟直方图的任务循环
+enum MetricLoop
+{
+  METRIC_LOOP_IMU,  // imu_task: 处理一个手势事件
+  METRIC_LOOP_UI,   // ui_task: 绘制一帧
+  METRIC_LOOP_NOTE, // 录制任务: 生成一个音符
+  METRIC_LOOP_HTTP, // http_task: 推送一轮WebSocket数据
+  METRIC_LOOP_COUNT
+};
+
+// JSON输出的缓冲区大小
+#define METRICS_JSON_SIZE 4096
+
+// 记录一次循环的耗时 (us)
+void recordLoopLatency(MetricLoop loop, uint32_t us);
+
+// 记录一次HTTP请求从收到到连接关闭的时间 (us)
+void recordHTTPLatency(uint32_t us);
+
+// 清零所有直方图
+void resetMetrics();
+
+// 开始统计各核心的空闲时间，cores 中的CPU占用由此计算 (不依赖FreeRTOS的运行时间统计)
+void startCPUMeter();
+
+// 写出全部指标的JSON，空间不足返回0
+// CPU占用按两次调用之间的运行时间计算，只在一个任务中调用 (AsyncTCP任务)
+size_t writeMetricsJSON(char *buf, size_t len);
+
+// 循环计时: 在循环被唤醒后定义，离开作用域 (包括continue) 时记录耗时
+struct LoopTimer
+{
+  MetricLoop loop;
+  int64_t start;
+  explicit LoopTimer(MetricLoop loop) : loop(loop), start(esp_timer_get_time()) {}
+  ~LoopTimer() { recordLoopLatency(loop, (uint32_t)(esp_timer_get_time() - start)); }
+};
+
+#endif
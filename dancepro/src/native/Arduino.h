@@ -0,0 +1,75 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// 主机编译 (env:native) 用的Arduino接口替身，只提供固件逻辑模块用到的部分
+// 真实的Arduino.h会包含FreeRTOS，这里保持一致
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+
+using std::min;
+using std::max;
+
+#define PI 3.1415926535897932384626433832795
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// 虚拟时钟: 不随真实时间走动，由调用方推进，基准测试和回放的结果可以复现
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void nativeSetMicros(uint64_t us);
+void nativeAdvanceMicros(uint64_t us);
+
+// 伪随机数 (xorshift32)，固定种子时序列固定
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// 精简的String，基于std::string
+class String {
+public:
+  String() {}
+  String(const char* str) : value(str ? str : "") {}
+  String(const std::string& str) : value(str) {}
+  String(int number) : value(std::to_string(number)) {}
+  String(unsigned int number) : value(std::to_string(number)) {}
+  String(long number) : value(std::to_string(number)) {}
+  String(unsigned long number) : value(std::to_string(number)) {}
+  String(float number) : value(std::to_string(number)) {}
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.size(); }
+  bool isEmpty() const { return value.empty(); }
+  int indexOf(const char* str) const {
+    size_t pos = value.find(str);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  String substring(unsigned int from) const { return String(value.substr(from)); }
+  String substring(unsigned int from, unsigned int to) const { return String(value.substr(from, to - from)); }
+  long toInt() const { return atol(value.c_str()); }
+  float toFloat() const { return atof(value.c_str()); }
+
+  String& operator+=(const String& rhs) { value += rhs.value; return *this; }
+  String& operator+=(const char* rhs) { value += rhs; return *this; }
+  String& operator+=(char c) { value += c; return *this; }
+  bool operator==(const String& rhs) const { return value == rhs.value; }
+  bool operator==(const char* rhs) const { return value == rhs; }
+  bool operator!=(const char* rhs) const { return value != rhs; }
+  bool operator<(const String& rhs) const { return value < rhs.value; }
+  char operator[](unsigned int index) const { return value[index]; }
+
+  friend String operator+(const String& lhs, const String& rhs) { return String(lhs.value + rhs.value); }
+  friend String operator+(const String& lhs, const char* rhs) { return String(lhs.value + rhs); }
+
+private:
+  std::string value;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+// 主机编译用的LittleFS替身 - 文件保存在主机的一个目录下 (nativeSetFSRoot)，用标准C文件接口读写
+// 只提供会话存储等模块用到的部分
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+// 设备上的路径都放在这个目录下，默认为当前目录下的 native_fs
+void nativeSetFSRoot(const char* dir);
+// 设备路径对应的主机路径
+std::string nativeFSPath(const char* path);
+
+// 文件，复制时共享同一个打开的文件
+class File {
+public:
+  File() {}
+  explicit File(FILE* file) : file(file, fclose) {}
+
+  explicit operator bool() const { return file != nullptr; }
+  size_t write(const uint8_t* buf, size_t size) { return file ? fwrite(buf, 1, size, file.get()) : 0; }
+  size_t read(uint8_t* buf, size_t size) { return file ? fread(buf, 1, size, file.get()) : 0; }
+  bool seek(uint32_t pos) { return file && fseek(file.get(), pos, SEEK_SET) == 0; }
+  size_t size() const;
+  void close() { file.reset(); }
+
+private:
+  std::shared_ptr<FILE> file;
+};
+
+class NativeLittleFS {
+public:
+  bool begin(bool formatOnFail = false);
+  File open(const char* path, const char* mode = FILE_READ);
+  bool exists(const char* path);
+  bool remove(const char* path);
+  bool mkdir(const char* path);
+};
+
+extern NativeLittleFS LittleFS;
+
+#endif
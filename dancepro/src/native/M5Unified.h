@@ -0,0 +1,26 @@
+#ifndef NATIVE_M5UNIFIED_H
+#define NATIVE_M5UNIFIED_H
+
+// 主机编译用的M5替身，只有日志输出到标准输出
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+struct NativeLog {
+  void print(const char* text) { fputs(text, stdout); }
+  void println(const char* text = "") { puts(text); }
+  void printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+  }
+};
+
+struct NativeM5 {
+  NativeLog Log;
+};
+
+extern NativeM5 M5;
+
+#endif
@@ -0,0 +1,51 @@
+#include <LittleFS.h>
+#include <sys/stat.h>
+
+NativeLittleFS LittleFS;
+
+static std::string fsRoot = "native_fs";
+
+void nativeSetFSRoot(const char* dir) {
+  fsRoot = dir;
+}
+
+std::string nativeFSPath(const char* path) {
+  return fsRoot + path;
+}
+
+// 追加模式下写入位置在末尾，用文件描述符取大小，不移动读写位置
+size_t File::size() const {
+  struct stat st;
+  if (!file || fflush(file.get()) != 0 || fstat(fileno(file.get()), &st) != 0) {
+    return 0;
+  }
+  return (size_t)st.st_size;
+}
+
+// 根目录不存在时创建 (相当于格式化)
+bool NativeLittleFS::begin(bool formatOnFail) {
+  struct stat st;
+  if (stat(fsRoot.c_str(), &st) == 0) {
+    return S_ISDIR(st.st_mode);
+  }
+  return formatOnFail && ::mkdir(fsRoot.c_str(), 0755) == 0;
+}
+
+File NativeLittleFS::open(const char* path, const char* mode) {
+  std::string binary = std::string(mode) + "b";
+  FILE* file = fopen(nativeFSPath(path).c_str(), binary.c_str());
+  return file ? File(file) : File();
+}
+
+bool NativeLittleFS::exists(const char* path) {
+  struct stat st;
+  return stat(nativeFSPath(path).c_str(), &st) == 0;
+}
+
+bool NativeLittleFS::remove(const char* path) {
+  return ::remove(nativeFSPath(path).c_str()) == 0;
+}
+
+bool NativeLittleFS::mkdir(const char* path) {
+  return ::mkdir(nativeFSPath(path).c_str(), 0755) == 0;
+}
@@ -0,0 +1,158 @@
+#include <Arduino.h>
+#include <M5Unified.h>
+
+NativeM5 M5;
+
+// 虚拟时钟
+static uint64_t nativeMicros = 0;
+
+unsigned long millis() {
+  return (unsigned long)(nativeMicros / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)nativeMicros;
+}
+
+void delay(unsigned long ms) {
+  nativeMicros += (uint64_t)ms * 1000;
+}
+
+void nativeSetMicros(uint64_t us) {
+  nativeMicros = us;
+}
+
+void nativeAdvanceMicros(uint64_t us) {
+  nativeMicros += us;
+}
+
+// xorshift32，种子不能为0
+static uint32_t randomState = 2463534242UL;
+
+void randomSeed(unsigned long seed) {
+  randomState = seed ? (uint32_t)seed : 2463534242UL;
+}
+
+static uint32_t nextRandom() {
+  uint32_t x = randomState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  randomState = x;
+  return x;
+}
+
+long random(long howbig) {
+  if (howbig <= 0) {
+    return 0;
+  }
+  return nextRandom() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) {
+    return howsmall;
+  }
+  return howsmall + random(howbig - howsmall);
+}
+
+// FreeRTOS
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)millis();
+}
+
+void vTaskDelay(TickType_t ticks) {
+  delay(ticks);
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period) {
+  *previousWake += period;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(*previousWake - now) > 0) {
+    delay(*previousWake - now);
+  }
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char* name, uint32_t stackDepth, void* params,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+  M5.Log.printf("[Native] 不支持创建任务: %s\n", name);
+  if (handle != NULL) {
+    *handle = NULL;
+  }
+  return pdFAIL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackDepth, void* params,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+  return xTaskCreate(task, name, stackDepth, params, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+}
+
+// 队列: 环形缓冲区，满时发送失败，空时接收失败 (单线程不会等到数据)
+struct NativeQueue {
+  uint8_t* items;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+  UBaseType_t head;
+  UBaseType_t count;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  NativeQueue* queue = (NativeQueue*)calloc(1, sizeof(NativeQueue));
+  if (queue == NULL) {
+    return NULL;
+  }
+  queue->length = length;
+  queue->itemSize = itemSize;
+  if (length > 0 && itemSize > 0) {
+    queue->items = (uint8_t*)malloc(length * itemSize);
+    if (queue->items == NULL) {
+      free(queue);
+      return NULL;
+    }
+  }
+  return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t timeout) {
+  if (queue->count >= queue->length) {
+    return pdFALSE;
+  }
+  UBaseType_t tail = (queue->head + queue->count) % queue->length;
+  if (queue->itemSize > 0) {
+    memcpy(queue->items + tail * queue->itemSize, item, queue->itemSize);
+  }
+  queue->count++;
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout) {
+  if (queue->count == 0) {
+    return pdFALSE;
+  }
+  if (queue->itemSize > 0) {
+    memcpy(item, queue->items + queue->head * queue->itemSize, queue->itemSize);
+  }
+  queue->head = (queue->head + 1) % queue->length;
+  queue->count--;
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  return queue->count;
+}
+
+// 互斥锁: 单线程下总是成功
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return xQueueCreate(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t timeout) {
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+  return pdTRUE;
+}
@@ -0,0 +1,136 @@
+#include "note/beat_clock.h"
+#include "trace/trace.h"
+#include <esp_timer.h>
+#include <M5Unified.h>
+
+static esp_timer_handle_t clockTimer = NULL;
+static TaskHandle_t clockTask = NULL;
+// 保护 running、clockTask 和定时器的重新启动: 回调在esp_timer任务 (核心0) 中，停止在录制任务 (核心1) 中
+// 停止返回后回调不会再启动定时器；clockTask 不清空，已经取到它的回调最多多通知一次
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint16_t tempo = BEAT_CLOCK_DEFAULT_BPM;
+
+// 以下状态只在定时器回调中修改
+static int64_t tickTime = 0;             // 当前细分拍的计划时间 (us)
+static uint32_t tickCount = 0;           // 已经过的细分拍
+static int64_t anchorTime = 0;           // 速度改变时的拍点，之后的拍点从这里计算
+static uint32_t anchorTick = 0;
+static uint16_t anchorTempo = BEAT_CLOCK_DEFAULT_BPM;
+static volatile uint32_t noteTick = 0;   // 当前音符的拍点
+static volatile int64_t noteTime = 0;    // 当前音符的计划时间
+static volatile uint32_t nextNoteTick = 0;
+static volatile bool notePending = false;  // 已通知音符任务，等待它安排下一个音符
+static volatile bool running = false;
+
+static uint32_t maxLateness = 0;
+
+// 细分拍回调 (esp_timer任务): 按计划时间安排下一拍，不累积回调延迟
+static void beatClockTick(void* arg) {
+    portENTER_CRITICAL(&clockMux);
+    if (!running) {
+        portEXIT_CRITICAL(&clockMux);
+        return;
+    }
+    TaskHandle_t task = clockTask;
+    bool notify = false;
+    uint32_t tick = tickCount;
+    // 音符任务来不及安排时，下一个音符在它安排之后的第一拍触发，不会丢失
+    if (!notePending && (int32_t)(tickCount - nextNoteTick) >= 0) {
+        noteTick = tickCount;
+        noteTime = tickTime;
+        notePending = true;
+        notify = true;
+    }
+    if (anchorTempo != tempo) {
+        anchorTime = tickTime;
+        anchorTick = tickCount;
+        anchorTempo = tempo;
+    }
+    tickCount++;
+    tickTime = anchorTime + beatClockTickTime(tickCount - anchorTick, anchorTempo);
+    int64_t delay = tickTime - esp_timer_get_time();
+    esp_timer_start_once(clockTimer, delay > 0 ? delay : 0);
+    portEXIT_CRITICAL(&clockMux);
+    // 通知在锁外: 录制任务常驻，句柄在停止后仍然有效
+    if (notify && task != NULL) {
+        TRACE_INSTANT(TRACE_BEAT_NOTE, tick);
+        xTaskNotifyGive(task);
+    }
+}
+
+// 开始计时
+bool startBeatClock(TaskHandle_t task) {
+    if (clockTimer == NULL) {
+        esp_timer_create_args_t args = {};
+        args.callback = beatClockTick;
+        args.name = "BeatClock";
+        if (esp_timer_create(&args, &clockTimer) != ESP_OK) {
+            M5.Log.println("[Beat] 定时器创建失败");
+            clockTimer = NULL;
+            return false;
+        }
+    }
+    stopBeatClock();
+    portENTER_CRITICAL(&clockMux);
+    clockTask = task;
+    tickCount = 0;
+    nextNoteTick = 0;
+    notePending = false;
+    maxLateness = 0;
+    tickTime = esp_timer_get_time();
+    anchorTime = tickTime;
+    anchorTick = 0;
+    anchorTempo = tempo;
+    running = true;
+    esp_timer_start_once(clockTimer, 0);
+    portEXIT_CRITICAL(&clockMux);
+    M5.Log.printf("[Beat] 节拍时钟启动，%d BPM\n", tempo);
+    return true;
+}
+
+// 停止计时: 在锁内停止定时器，正在执行的回调要么已经重新启动定时器 (在这里被停止)，要么看到 running 为false
+void stopBeatClock() {
+    portENTER_CRITICAL(&clockMux);
+    bool wasRunning = running;
+    running = false;
+    if (clockTimer != NULL) {
+        esp_timer_stop(clockTimer);
+    }
+    portEXIT_CRITICAL(&clockMux);
+    if (wasRunning) {
+        M5.Log.printf("[Beat] 节拍时钟停止，最大延迟 %u us\n", (unsigned)maxLateness);
+    }
+}
+
+// 设置速度
+void setBeatClockTempo(int bpm) {
+    // 按int截断，JSON中的负数或超过65535的值不会先被转换成任意的速度
+    tempo = constrain(bpm, BEAT_CLOCK_MIN_BPM, BEAT_CLOCK_MAX_BPM);
+}
+
+// 当前速度
+uint16_t getBeatClockTempo() {
+    return tempo;
+}
+
+// 安排下一个音符
+int64_t beatClockNextNote(uint32_t durationTicks) {
+    int64_t scheduled = noteTime;
+    uint32_t lateness = (uint32_t)(esp_timer_get_time() - scheduled);
+    if (lateness > maxLateness) {
+        maxLateness = lateness;
+    }
+    nextNoteTick = noteTick + durationTicks;
+    notePending = false;
+    return scheduled;
+}
+
+// 是否有待处理的拍点
+bool beatClockNotePending() {
+    return running && notePending;
+}
+
+// 最大延迟
+uint32_t getBeatClockMaxLateness() {
+    return maxLateness;
+}
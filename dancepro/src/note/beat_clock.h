@@ -0,0 +1,58 @@
+#ifndef BEAT_CLOCK_H
+#define BEAT_CLOCK_H
+
+#include <Arduino.h>
+#include "note/note.h"
+#include "note/note_codec.h"
+
+// 节拍时钟 - 用esp_timer按细分拍触发作曲，音符在拍点上生成，与任务调度无关
+// 乐谱中的时值以 BEAT_UNIT 为一拍，按当前速度换算成细分拍数
+
+// 每拍的细分数，与二进制格式的时值栅格相同，可以表示半拍和三连音
+#define BEAT_CLOCK_SUBDIVISIONS (BEAT_UNIT / NOTE_CODEC_GRID_MS)
+
+// 速度范围 (BPM)，默认速度下一拍正好是 BEAT_UNIT
+#define BEAT_CLOCK_DEFAULT_BPM  (60000 / BEAT_UNIT)
+#define BEAT_CLOCK_MIN_BPM      40
+#define BEAT_CLOCK_MAX_BPM      240
+
+// 乐谱时值 (ms) 换算成细分拍数，至少1拍
+inline uint32_t beatClockTicks(uint32_t durationMs) {
+    uint32_t ticks = (durationMs + NOTE_CODEC_GRID_MS / 2) / NOTE_CODEC_GRID_MS;
+    return ticks > 0 ? ticks : 1;
+}
+
+// 第ticks个细分拍相对起点的时间 (us)，按整数累加一拍的长度会逐渐漂移，所以每次从起点计算
+inline int64_t beatClockTickTime(uint32_t ticks, uint16_t bpm) {
+    return (int64_t)ticks * 60000000LL / ((int64_t)bpm * BEAT_CLOCK_SUBDIVISIONS);
+}
+
+// 细分拍数按速度换算成实际时值 (ms)
+inline uint32_t beatClockTicksToMs(uint32_t ticks, uint16_t bpm) {
+    uint32_t ticksPerMinute = (uint32_t)bpm * BEAT_CLOCK_SUBDIVISIONS;
+    return (ticks * 60000UL + ticksPerMinute / 2) / ticksPerMinute;
+}
+
+// 开始计时，到达音符的拍点时通知task (ulTaskNotifyTake)，第一个拍点立即触发
+bool startBeatClock(TaskHandle_t task);
+
+// 停止计时
+void stopBeatClock();
+
+// 设置速度，从下一个细分拍开始生效，超出范围的值 (包括负数) 会被截断
+void setBeatClockTempo(int bpm);
+
+// 当前速度
+uint16_t getBeatClockTempo();
+
+// 音符任务被唤醒后调用: 返回当前音符的拍点时间 (us, esp_timer)，
+// 并在当前音符的拍点之后durationTicks个细分拍安排下一个音符
+int64_t beatClockNextNote(uint32_t durationTicks);
+
+// 是否有已到达、还没有安排下一个音符的拍点 (音符任务同时等待其他通知时用来区分)
+bool beatClockNotePending();
+
+// 本次计时中音符任务被唤醒的最大延迟 (us)
+uint32_t getBeatClockMaxLateness();
+
+#endif
@@ -2,36 +2,81 @@
 #define NOTE_H
 
 #include <Arduino.h>
-#include <ArduinoJson.h>
 #include "imu/imu.h" // 引入已定义的IMU数据结构
+#include "note/note_log.h"
 
-// 低八度音符 (3) - 仅保留7个自然音
+// 音符频率表 (Hz)，C2-B6 共60个半音，与 others/映射表.txt 一致
+
+// 低八度音符 (2)
+#define NOTE_C2  65   // 低低音do
+#define NOTE_CS2 69   // 低低音do升
+#define NOTE_D2  73   // 低低音re
+#define NOTE_DS2 78   // 低低音re升
+#define NOTE_E2  82   // 低低音mi
+#define NOTE_F2  87   // 低低音fa
+#define NOTE_FS2 93   // 低低音fa升
+#define NOTE_G2  98   // 低低音sol
+#define NOTE_GS2 104  // 低低音sol升
+#define NOTE_A2  110  // 低低音la
+#define NOTE_AS2 117  // 低低音la升
+#define NOTE_B2  123  // 低低音si
+
+// 低八度音符 (3)
 #define NOTE_C3  131  // 低音do
+#define NOTE_CS3 139  // 低音do升
 #define NOTE_D3  147  // 低音re
+#define NOTE_DS3 156  // 低音re升
 #define NOTE_E3  165  // 低音mi
 #define NOTE_F3  175  // 低音fa
+#define NOTE_FS3 185  // 低音fa升
 #define NOTE_G3  196  // 低音sol
+#define NOTE_GS3 208  // 低音sol升
 #define NOTE_A3  220  // 低音la
+#define NOTE_AS3 233  // 低音la升
 #define NOTE_B3  247  // 低音si
 
-// 中八度音符 (4) - 仅保留7个自然音
+// 中八度音符 (4)
 #define NOTE_C4  262  // 中央C (中音do)
+#define NOTE_CS4 277  // 中音do升
 #define NOTE_D4  294  // 中音re
+#define NOTE_DS4 311  // 中音re升
 #define NOTE_E4  330  // 中音mi
 #define NOTE_F4  349  // 中音fa
+#define NOTE_FS4 370  // 中音fa升
 #define NOTE_G4  392  // 中音sol
+#define NOTE_GS4 415  // 中音sol升
 #define NOTE_A4  440  // 标准音高A (中音la)
+#define NOTE_AS4 466  // 中音la升
 #define NOTE_B4  494  // 中音si
 
-// 高八度音符 (5) - 仅保留7个自然音
+// 高八度音符 (5)
 #define NOTE_C5  523  // 高音do
+#define NOTE_CS5 554  // 高音do升
 #define NOTE_D5  587  // 高音re
+#define NOTE_DS5 622  // 高音re升
 #define NOTE_E5  659  // 高音mi
 #define NOTE_F5  698  // 高音fa
+#define NOTE_FS5 740  // 高音fa升
 #define NOTE_G5  784  // 高音sol
+#define NOTE_GS5 831  // 高音sol升
 #define NOTE_A5  880  // 高音la
+#define NOTE_AS5 932  // 高音la升
 #define NOTE_B5  988  // 高音si
 
+// 高八度音符 (6)
+#define NOTE_C6  1047  // 高高音do
+#define NOTE_CS6 1109  // 高高音do升
+#define NOTE_D6  1175  // 高高音re
+#define NOTE_DS6 1245  // 高高音re升
+#define NOTE_E6  1319  // 高高音mi
+#define NOTE_F6  1397  // 高高音fa
+#define NOTE_FS6 1480  // 高高音fa升
+#define NOTE_G6  1568  // 高高音sol
+#define NOTE_GS6 1661  // 高高音sol升
+#define NOTE_A6  1760  // 高高音la
+#define NOTE_AS6 1865  // 高高音la升
+#define NOTE_B6  1976  // 高高音si
+
 // 休止符
 #define NOTE_REST 0  // 休止符 (无声)
 
@@ -42,8 +87,25 @@
 #define Q       300    // 四分音符 (1拍)
 #define E       150    // 八分音符 (1/2拍)
 
-// IMU数据映射到音符和持续时间，并返回JSON格式字符串
-String mapIMUToMusicJSON(const IMUData& imu, const String& existingJson = "[]");
+// 没有节拍时钟时调用mapIMUToNote的周期 (ms)
+#define NOTE_TASK_PERIOD_MS 500
+
+// IMU数据映射到音符和持续时间，生成新音符时返回true并写入event
+// 按墙上时间节流 (至少间隔250ms，10秒无音符时从头开始)，适合按固定周期调用
+bool mapIMUToNote(const IMUData& imu, NoteEvent& event);
+
+// 按乐谱生成下一个音符，不做时间节流，由节拍时钟在音符的拍点上调用
+// 时值为乐谱时值 (BEAT_UNIT为一拍)，读取乐谱失败时返回false
+bool composeNote(const IMUData& imu, NoteEvent& event);
+
+struct NoteScore;
+
+// 切换作曲使用的乐谱 (NULL为默认舞曲)，只在音符任务不运行时调用
+void setNoteScore(const NoteScore* score);
+
+// 重置作曲状态 (从第一小节开始) 并设置随机种子
+// 相同的种子和相同的IMU输入序列总是生成相同的音符
+void resetNoteComposer(uint32_t seed);
 
 #endif
 
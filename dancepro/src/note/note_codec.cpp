@@ -0,0 +1,131 @@
+#include "note/note_codec.h"
+
+// C2-B6 的频率表 (Hz)，与 others/映射表.txt 一致
+static const uint16_t NOTE_FREQ_TABLE[] = {
+    65,   69,   73,   78,   82,   87,   93,   98,   104,  110,  117,  123,   // 2
+    131,  139,  147,  156,  165,  175,  185,  196,  208,  220,  233,  247,   // 3
+    262,  277,  294,  311,  330,  349,  370,  392,  415,  440,  466,  494,   // 4
+    523,  554,  587,  622,  659,  698,  740,  784,  831,  880,  932,  988,   // 5
+    1047, 1109, 1175, 1245, 1319, 1397, 1480, 1568, 1661, 1760, 1865, 1976  // 6
+};
+static const uint8_t NOTE_FREQ_COUNT = sizeof(NOTE_FREQ_TABLE) / sizeof(NOTE_FREQ_TABLE[0]);
+static_assert(sizeof(NOTE_FREQ_TABLE) / sizeof(NOTE_FREQ_TABLE[0]) == NOTE_INDEX_COUNT, "frequency table must cover C2-B6");
+
+// 编码器的初始参考音 (C4)
+static const uint8_t NOTE_INDEX_C4 = 24;
+
+// 频率转换为最接近的半音索引
+uint8_t noteFreqToIndex(uint16_t freq) {
+    // 二分查找第一个不小于freq的音
+    uint8_t lo = 0;
+    uint8_t hi = NOTE_FREQ_COUNT - 1;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (NOTE_FREQ_TABLE[mid] < freq) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    // 与前一个音比较，取更接近的
+    if (lo > 0 && freq - NOTE_FREQ_TABLE[lo - 1] < NOTE_FREQ_TABLE[lo] - freq) {
+        lo--;
+    }
+    return lo;
+}
+
+// 半音索引转换为频率
+uint16_t noteIndexToFreq(uint8_t index) {
+    if (index >= NOTE_FREQ_COUNT) {
+        index = NOTE_FREQ_COUNT - 1;
+    }
+    return NOTE_FREQ_TABLE[index];
+}
+
+// 写入头部
+size_t noteEncodeHeader(NoteEncoder& enc, uint16_t count, uint8_t* buf, size_t len) {
+    if (len < NOTE_CODEC_HEADER_SIZE) {
+        return 0;
+    }
+    buf[0] = 'D';
+    buf[1] = 'N';
+    buf[2] = NOTE_CODEC_VERSION;
+    buf[3] = NOTE_CODEC_GRID_MS;
+    buf[4] = count & 0xFF;
+    buf[5] = count >> 8;
+    enc.prevIndex = NOTE_INDEX_C4;
+    return NOTE_CODEC_HEADER_SIZE;
+}
+
+// 编码一个音符
+size_t noteEncodeEvent(NoteEncoder& enc, const NoteEvent& event, uint8_t* buf, size_t len) {
+    if (len < NOTE_CODEC_EVENT_SIZE) {
+        return 0;
+    }
+
+    // 音高令牌
+    if (event.note == 0) {
+        buf[0] = 0;
+    } else {
+        uint8_t index = noteFreqToIndex(event.note);
+        int delta = (int)index - (int)enc.prevIndex;
+        // zigzag: 0,-1,1,-2,2... -> 0,1,2,3,4...，最大118
+        uint8_t zigzag = (delta >= 0) ? (delta * 2) : (-delta * 2 - 1);
+        buf[0] = zigzag + 1;
+        enc.prevIndex = index;
+    }
+
+    // 时值量化到栅格 (四舍五入)
+    uint32_t units = ((uint32_t)event.duration + NOTE_CODEC_GRID_MS / 2) / NOTE_CODEC_GRID_MS;
+    if (units > 255) {
+        units = 255;
+    }
+    buf[1] = units;
+    return NOTE_CODEC_EVENT_SIZE;
+}
+
+// 一次性编码全部音符
+size_t noteEncodeAll(const NoteEvent* events, size_t count, uint8_t* buf, size_t len) {
+    if (count > 0xFFFF || len < NOTE_CODEC_SIZE(count)) {
+        return 0;
+    }
+    NoteEncoder enc;
+    size_t pos = noteEncodeHeader(enc, count, buf, len);
+    for (size_t i = 0; i < count; i++) {
+        pos += noteEncodeEvent(enc, events[i], buf + pos, len - pos);
+    }
+    return pos;
+}
+
+// 解码
+int noteDecodeAll(const uint8_t* buf, size_t len, NoteEvent* events, size_t maxCount) {
+    if (len < NOTE_CODEC_HEADER_SIZE || buf[0] != 'D' || buf[1] != 'N' ||
+        buf[2] != NOTE_CODEC_VERSION || buf[3] == 0) {
+        return -1;
+    }
+    uint8_t grid = buf[3];
+    size_t count = buf[4] | (buf[5] << 8);
+    if (count > maxCount || len != NOTE_CODEC_SIZE(count)) {
+        return -1;
+    }
+
+    uint8_t prevIndex = NOTE_INDEX_C4;
+    const uint8_t* p = buf + NOTE_CODEC_HEADER_SIZE;
+    for (size_t i = 0; i < count; i++, p += NOTE_CODEC_EVENT_SIZE) {
+        uint8_t token = p[0];
+        if (token == 0) {
+            events[i].note = 0;
+        } else {
+            uint8_t zigzag = token - 1;
+            int delta = (zigzag & 1) ? -(int)((zigzag + 1) / 2) : (int)(zigzag / 2);
+            int index = (int)prevIndex + delta;
+            if (index < 0 || index >= NOTE_FREQ_COUNT) {
+                return -1;
+            }
+            prevIndex = index;
+            events[i].note = noteIndexToFreq(prevIndex);
+        }
+        events[i].duration = p[1] * grid;
+    }
+    return count;
+}
@@ -0,0 +1,52 @@
+#ifndef NOTE_CODEC_H
+#define NOTE_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "note/note_log.h"
+
+// 紧凑二进制音符格式 (GET /api/notes.bin)
+// 不依赖Arduino，可以在主机上单独编译测试
+//
+// 头部 (6字节): 'D' 'N' 版本 时值栅格(ms) 音符数(uint16 小端)
+// 每个音符2字节:
+//   音高令牌: 0 = 休止符，否则为 zigzag(与上一个音符的半音差) + 1
+//   时值: 以栅格为单位，最大255
+// 音高使用C2-B6共60个半音的索引，休止符不改变"上一个音符"
+#define NOTE_CODEC_VERSION      1
+#define NOTE_CODEC_HEADER_SIZE  6
+#define NOTE_CODEC_EVENT_SIZE   2
+
+// 时值栅格: BEAT_UNIT(300ms)的1/12，可以精确表示半拍和三连音
+#define NOTE_CODEC_GRID_MS      25
+
+// 编码后的总字节数
+#define NOTE_CODEC_SIZE(count)  (NOTE_CODEC_HEADER_SIZE + (count) * NOTE_CODEC_EVENT_SIZE)
+
+// 增量编码器状态，可以分块编码
+struct NoteEncoder {
+    uint8_t prevIndex;  // 上一个音符的半音索引
+};
+
+// 半音索引的个数 (C2-B6)
+#define NOTE_INDEX_COUNT        60
+
+// 频率(Hz)转换为最接近的半音索引 (0 = C2)
+uint8_t noteFreqToIndex(uint16_t freq);
+
+// 半音索引转换为频率(Hz)
+uint16_t noteIndexToFreq(uint8_t index);
+
+// 写入头部并初始化编码器，返回写入的字节数，空间不足返回0
+size_t noteEncodeHeader(NoteEncoder& enc, uint16_t count, uint8_t* buf, size_t len);
+
+// 编码一个音符，返回写入的字节数，空间不足返回0
+size_t noteEncodeEvent(NoteEncoder& enc, const NoteEvent& event, uint8_t* buf, size_t len);
+
+// 一次性编码全部音符，返回写入的字节数，空间不足返回0
+size_t noteEncodeAll(const NoteEvent* events, size_t count, uint8_t* buf, size_t len);
+
+// 解码，返回音符数，格式错误或空间不足返回-1
+int noteDecodeAll(const uint8_t* buf, size_t len, NoteEvent* events, size_t maxCount);
+
+#endif
@@ -0,0 +1,31 @@
+#include "note/note_log.h"
+#include <stdio.h>
+
+// 清空缓冲区 - 只重置计数，不触碰数据
+void noteLogReset(NoteLog& log) {
+    log.count = 0;
+}
+
+// 追加一个音符
+bool noteLogAppend(NoteLog& log, const NoteEvent& event) {
+    if (log.count >= NOTE_LOG_CAPACITY) {
+        return false;
+    }
+    log.events[log.count] = event;
+    log.count++;
+    return true;
+}
+
+// 缓冲区是否已满
+bool noteLogFull(const NoteLog& log) {
+    return log.count >= NOTE_LOG_CAPACITY;
+}
+
+// 将单个音符格式化为JSON对象
+size_t noteEventToJSON(const NoteEvent& event, char* buf, size_t len) {
+    int written = snprintf(buf, len, "{\"n\":%u,\"t\":%u}", event.note, event.duration);
+    if (written < 0 || (size_t)written >= len) {
+        return 0;
+    }
+    return written;
+}
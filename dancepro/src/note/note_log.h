@@ -0,0 +1,34 @@
+#ifndef NOTE_LOG_H
+#define NOTE_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 单个音符事件 (4字节)
+struct NoteEvent {
+    uint16_t note;      // 音符频率 (Hz)，0为休止符
+    uint16_t duration;  // 持续时间 (ms)
+};
+
+// 录制缓冲区容量 - 4096个音符仅占16KB
+#define NOTE_LOG_CAPACITY 4096
+
+// 定长追加缓冲区，录制期间O(1)追加且不分配内存
+struct NoteLog {
+    NoteEvent events[NOTE_LOG_CAPACITY];
+    size_t count;
+};
+
+// 清空缓冲区
+void noteLogReset(NoteLog& log);
+
+// 追加一个音符，缓冲区已满时返回false
+bool noteLogAppend(NoteLog& log, const NoteEvent& event);
+
+// 缓冲区是否已满
+bool noteLogFull(const NoteLog& log);
+
+// 将单个音符格式化为JSON对象 {"n":523,"t":300}，返回写入的字节数(不含结尾0)
+size_t noteEventToJSON(const NoteEvent& event, char* buf, size_t len);
+
+#endif
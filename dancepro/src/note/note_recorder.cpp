@@ -0,0 +1,396 @@
+#include "note/note_recorder.h"
+#include <M5Unified.h>
+#include <atomic>
+#include "event/event_bus.h"
+#include "imu/imu_sampler.h"
+#include "imu/imu_trace_recorder.h"
+#include "note/note.h"
+#include "note/note_song_store.h"
+#include "note/note_session_store.h"
+#include "note/beat_clock.h"
+#include "synth/synth_task.h"
+#include "http/http.h"
+#include "http/live_stream.h"
+#include "metrics/metrics.h"
+#include "tasks/task_plan.h"
+#include "trace/trace.h"
+
+// 录制命令
+enum RecorderCommandType : uint8_t
+{
+  RECORDER_START,
+  RECORDER_STOP
+};
+
+struct RecorderCommand
+{
+  RecorderCommandType type;
+  bool trace; // RECORDER_START: 同时录制IMU轨迹
+};
+
+// 保存任务的通知位
+#define WRITER_SESSION_DONE (1UL << 0) // 一个会话录制结束
+#define WRITER_FLUSH        (1UL << 1) // 立即保存
+#define WRITER_CLEAR        (1UL << 2) // 删除所有会话
+
+static QueueHandle_t commandQueue = NULL;
+static TaskHandle_t recorderTaskHandle = NULL;
+static TaskHandle_t writerTaskHandle = NULL;
+
+// 会话池: 录制任务取出空闲会话录制，保存任务保存后放回 (状态是原子变量，DONE之后数据只读)
+static NoteSession sessions[RECORDER_SESSIONS];
+static NoteSession *current = NULL; // 录制中的会话 (只在录制任务中使用)
+static uint32_t nextSessionId = 1;
+static uint32_t publishedId = 0;    // 最后一个替换 /api/notes 的会话 (只在保存任务中使用)
+
+// 供其他任务读取的录制状态
+static std::atomic<bool> recording(false);
+static std::atomic<uint32_t> recordStartMs(0);
+static std::atomic<uint32_t> lastDuration(0);
+
+// 开始录制: 取一个空闲会话，重置作曲器后启动节拍时钟
+static void beginSession(bool trace)
+{
+  if (current != NULL)
+  {
+    return;
+  }
+  NoteSession *session = NULL;
+  for (int i = 0; i < RECORDER_SESSIONS; i++)
+  {
+    if (sessions[i].state.load(std::memory_order_acquire) == SESSION_FREE)
+    {
+      session = &sessions[i];
+      break;
+    }
+  }
+  if (session == NULL)
+  {
+    // 保存任务还没有保存结束的会话，让它立即保存
+    M5.Log.println("[Record] 没有空闲的会话，正在保存，请稍后再试");
+    xTaskNotify(writerTaskHandle, WRITER_FLUSH, eSetBits);
+    return;
+  }
+  // 每次录制用新的随机种子，同时录制轨迹时写入轨迹头部，回放时可以复现
+  noteLogReset(session->log);
+  session->id = nextSessionId++;
+  session->seed = esp_random();
+  session->startMs = millis();
+  struct tm now;
+  session->startTime = getLocalTime(&now, 0) ? (uint32_t)time(NULL) : 0;
+  session->duration = 0;
+  session->tempo = getBeatClockTempo();
+  session->state.store(SESSION_RECORDING, std::memory_order_relaxed);
+  current = session;
+
+  applyNoteSong();
+  resetNoteComposer(session->seed);
+  if (trace)
+  {
+    if (!startIMUTraceRecording(session->seed, session->tempo))
+    {
+      M5.Log.printf("[Record] 录制 #%u 没有IMU轨迹: 轨迹录制无法开始\n", (unsigned)session->id);
+    }
+  }
+  recordStartMs = session->startMs;
+  recording = true;
+  startBeatClock(xTaskGetCurrentTaskHandle());
+  postEvent(EVENT_RECORD_START);
+}
+
+// 停止录制: 会话交给保存任务
+static void endSession()
+{
+  if (current == NULL)
+  {
+    return;
+  }
+  stopBeatClock();
+  stopIMUTraceRecording();
+  current->duration = millis() - current->startMs;
+  lastDuration = current->duration;
+  M5.Log.printf("[Record] 录制 #%u 结束，音符数: %u，时长 %u ms\n", (unsigned)current->id,
+                (unsigned)current->log.count, (unsigned)current->duration);
+  recording = false;
+  current->state.store(SESSION_DONE, std::memory_order_release);
+  current = NULL;
+  xTaskNotify(writerTaskHandle, WRITER_SESSION_DONE, eSetBits);
+  postEvent(EVENT_RECORD_STOP);
+}
+
+// 最新结束的会话替换 /api/notes 的数据 (内存复制，不写flash)
+static void publishNewest()
+{
+  NoteSession *newest = NULL;
+  for (int i = 0; i < RECORDER_SESSIONS; i++)
+  {
+    NoteSession &session = sessions[i];
+    if (session.state.load(std::memory_order_acquire) == SESSION_DONE && session.id > publishedId &&
+        (newest == NULL || session.id > newest->id))
+    {
+      newest = &session;
+    }
+  }
+  if (newest != NULL)
+  {
+    uploadAndReplaceNoteData(newest->log);
+    publishedId = newest->id;
+  }
+}
+
+// 按录制顺序一次保存所有已结束的会话并放回会话池，没有音符的会话不保存
+static void flushSessions()
+{
+  const NoteSession *done[RECORDER_SESSIONS];
+  NoteSession *finished[RECORDER_SESSIONS];
+  size_t doneCount = 0;
+  size_t finishedCount = 0;
+  for (int i = 0; i < RECORDER_SESSIONS; i++)
+  {
+    NoteSession &session = sessions[i];
+    if (session.state.load(std::memory_order_acquire) != SESSION_DONE)
+    {
+      continue;
+    }
+    finished[finishedCount++] = &session;
+    if (session.log.count == 0)
+    {
+      continue;
+    }
+    // 按编号插入
+    size_t pos = doneCount++;
+    while (pos > 0 && done[pos - 1]->id > session.id)
+    {
+      done[pos] = done[pos - 1];
+      pos--;
+    }
+    done[pos] = &session;
+  }
+  if (doneCount > 0)
+  {
+    appendSessions(done, doneCount);
+  }
+  for (size_t i = 0; i < finishedCount; i++)
+  {
+    finished[i]->state.store(SESSION_FREE, std::memory_order_release);
+  }
+}
+
+// 删除所有会话: 还没保存的会话直接放回会话池，再删除会话存储的文件
+static void clearAllSessions()
+{
+  for (int i = 0; i < RECORDER_SESSIONS; i++)
+  {
+    if (sessions[i].state.load(std::memory_order_acquire) == SESSION_DONE)
+    {
+      sessions[i].state.store(SESSION_FREE, std::memory_order_release);
+    }
+  }
+  clearSessions();
+}
+
+// 空闲的会话数
+static int freeSessionCount()
+{
+  int count = 0;
+  for (int i = 0; i < RECORDER_SESSIONS; i++)
+  {
+    count += sessions[i].state.load(std::memory_order_acquire) == SESSION_FREE ? 1 : 0;
+  }
+  return count;
+}
+
+// 是否有等待保存的会话
+static bool hasDoneSessions()
+{
+  for (int i = 0; i < RECORDER_SESSIONS; i++)
+  {
+    if (sessions[i].state.load(std::memory_order_acquire) == SESSION_DONE)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// 保存任务 (网络核心): 会话结束后立即更新 /api/notes，写flash等到停止录制后空闲、会话池满或收到保存请求
+// 录制中不写flash，写入时暂停的缓存不会打断连续录制；删除文件也在这里执行
+static void sessionWriterTask(void *pvParameters)
+{
+  for (;;)
+  {
+    TickType_t timeout = (hasDoneSessions() && !recording) ? pdMS_TO_TICKS(RECORDER_FLUSH_IDLE_MS) : portMAX_DELAY;
+    uint32_t bits = 0;
+    bool idle = xTaskNotifyWait(0, 0xFFFFFFFFUL, &bits, timeout) != pdTRUE;
+    if (bits & WRITER_SESSION_DONE)
+    {
+      publishNewest();
+    }
+    if (bits & WRITER_CLEAR)
+    {
+      clearAllSessions();
+    }
+    bool flush = (bits & WRITER_FLUSH) || (!recording && (idle || freeSessionCount() == 0));
+    if (flush && hasDoneSessions())
+    {
+      flushSessions();
+    }
+  }
+}
+
+// 生成一个音符并记录
+static void composeSessionNote()
+{
+  IMUSample sample;
+  NoteEvent event;
+  LoopTimer timer(METRIC_LOOP_NOTE);
+  TRACE_SCOPE(TRACE_NOTE_COMPOSE);
+  if (!getLatestIMUSample(sample) || !composeNote(sample.data, event))
+  {
+    beatClockNextNote(1); // 下一个细分拍再试
+    return;
+  }
+  // 乐谱时值量化到细分拍，按当前速度记录实际时值
+  uint32_t ticks = beatClockTicks(event.duration);
+  beatClockNextNote(ticks);
+  event.duration = beatClockTicksToMs(ticks, getBeatClockTempo());
+  // 先交给合成器发声，再记录
+  playSynthNote(event);
+  publishLiveNote(event, millis() - current->startMs);
+
+  if (noteLogAppend(current->log, event))
+  {
+    postEvent(EVENT_NOTE_ADDED);
+  }
+  else
+  {
+    // 缓冲区满，自动停止，会话交给保存任务
+    M5.Log.println("警告：音符缓冲区已满，停止记录");
+    endSession();
+  }
+}
+
+// 录制任务: 命令和拍点都通过任务通知唤醒，先处理命令，再处理到达的拍点
+static void recorderTask(void *pvParameters)
+{
+  RecorderCommand command;
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    while (xQueueReceive(commandQueue, &command, 0) == pdPASS)
+    {
+      switch (command.type)
+      {
+      case RECORDER_START:
+        beginSession(command.trace);
+        break;
+      case RECORDER_STOP:
+        endSession();
+        break;
+      }
+    }
+    // 命令唤醒时没有拍点，不作曲
+    if (current != NULL && beatClockNotePending())
+    {
+      composeSessionNote();
+    }
+  }
+}
+
+// 发送命令并唤醒录制任务
+static bool sendCommand(RecorderCommandType type, bool trace)
+{
+  if (commandQueue == NULL)
+  {
+    return false;
+  }
+  RecorderCommand command = {type, trace};
+  if (xQueueSend(commandQueue, &command, 0) != pdPASS)
+  {
+    M5.Log.println("[Record] 命令队列已满");
+    return false;
+  }
+  xTaskNotifyGive(recorderTaskHandle);
+  return true;
+}
+
+// 启动录制任务和保存任务
+bool startNoteRecorder()
+{
+  if (recorderTaskHandle != NULL)
+  {
+    return true;
+  }
+  // 没有文件系统时仍然可以录制，只是不保存
+  initSessionStore();
+  nextSessionId = getNextSessionId();
+  if (commandQueue == NULL)
+  {
+    commandQueue = xQueueCreate(RECORDER_QUEUE_LENGTH, sizeof(RecorderCommand));
+    if (commandQueue == NULL)
+    {
+      M5.Log.println("[Record] 命令队列创建失败");
+      return false;
+    }
+  }
+  // 保存任务先启动，录制任务结束会话时通知它
+  if (writerTaskHandle == NULL && !createPlannedTask(TASK_SESSION_WRITER, sessionWriterTask, NULL, &writerTaskHandle))
+  {
+    M5.Log.println("[Record] 保存任务创建失败");
+    return false;
+  }
+  if (!createPlannedTask(TASK_RECORDER, recorderTask, NULL, &recorderTaskHandle))
+  {
+    M5.Log.println("[Record] 录制任务创建失败");
+    recorderTaskHandle = NULL;
+    return false;
+  }
+  return true;
+}
+
+// 开始录制
+bool startRecording(bool trace)
+{
+  return sendCommand(RECORDER_START, trace);
+}
+
+// 停止录制
+bool stopRecording()
+{
+  return sendCommand(RECORDER_STOP, false);
+}
+
+// 通知保存任务
+static bool notifyWriter(uint32_t bits)
+{
+  if (writerTaskHandle == NULL)
+  {
+    return false;
+  }
+  xTaskNotify(writerTaskHandle, bits, eSetBits);
+  return true;
+}
+
+// 立即保存已结束的会话
+bool flushRecordings()
+{
+  return notifyWriter(WRITER_FLUSH);
+}
+
+// 删除所有会话
+bool clearRecordings()
+{
+  return notifyWriter(WRITER_CLEAR);
+}
+
+// 是否正在录制
+bool isNoteRecording()
+{
+  return recording;
+}
+
+// 本次录制已进行的时间
+uint32_t getRecordingTime()
+{
+  return recording ? millis() - recordStartMs : lastDuration.load();
+}
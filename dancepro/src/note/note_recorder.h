@@ -0,0 +1,62 @@
+#ifndef NOTE_RECORDER_H
+#define NOTE_RECORDER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "note/note_log.h"
+
+// 音符录制任务 - 常驻任务，通过命令队列开始/停止录制，由节拍时钟在拍点唤醒作曲
+// 录制缓冲区来自静态的会话池，反复录制不创建任务也不分配内存
+// 结束的会话由网络核心上的保存任务成批写入flash: 停止录制后空闲一段时间、会话池满或收到保存请求时才写入，
+// 连续录制时不写flash，写入也不占用实时核心
+
+// 会话池大小: 一个录制中，一个等待保存
+#define RECORDER_SESSIONS      2
+// 命令队列长度
+#define RECORDER_QUEUE_LENGTH  4
+// 停止录制后多久没有开始新的录制就保存 (ms)
+#define RECORDER_FLUSH_IDLE_MS 2000
+
+// 会话状态
+enum NoteSessionState : uint8_t
+{
+  SESSION_FREE,      // 空闲，可以开始新的录制
+  SESSION_RECORDING, // 录制中
+  SESSION_DONE       // 录制结束，等待保存
+};
+
+// 一次录制
+struct NoteSession
+{
+  NoteLog log;
+  uint32_t id;        // 录制编号，接着已保存的会话递增
+  uint32_t seed;      // 作曲随机种子
+  uint32_t startMs;   // 开始时间 (millis)
+  uint32_t startTime; // 开始时间 (UNIX时间戳，时间未同步时为0)
+  uint32_t duration;  // 录制时长 (ms)
+  uint16_t tempo;     // 开始时的节拍速度 (BPM)
+  std::atomic<NoteSessionState> state; // 录制任务: FREE -> RECORDING -> DONE，保存任务: DONE -> FREE
+};
+
+// 启动录制任务 (同时读取会话存储的索引)
+bool startNoteRecorder();
+
+// 开始录制，trace为true时同时录制IMU轨迹 (没有空闲会话或队列满时返回false)
+bool startRecording(bool trace);
+
+// 停止录制，录制的会话交给保存任务 (最新的会话立即替换 /api/notes 的数据，空闲后追加到会话存储)
+bool stopRecording();
+
+// 立即保存所有已结束的会话并放回会话池，不等空闲
+bool flushRecordings();
+
+// 删除所有保存的会话和还没保存的会话 (由保存任务执行，录制中的会话不受影响)
+bool clearRecordings();
+
+// 是否正在录制
+bool isNoteRecording();
+
+// 本次录制已进行的时间 (ms)，没有录制时为上一次录制的时长
+uint32_t getRecordingTime();
+
+#endif
@@ -0,0 +1,228 @@
+#include "note/note_score.h"
+#include "note/note.h"
+
+// 定义和弦 - 增加中高音区和弦
+// 高八度和弦 (5音) 用于B段和C段
+constexpr NoteChord DANCE_CHORDS[CHORD_COUNT] = {
+    {{NOTE_C4, NOTE_E4, NOTE_G4, NOTE_C5}, 4},           // C和弦
+    {{NOTE_G3, NOTE_B3, NOTE_D4, NOTE_G4}, 4},           // G和弦
+    {{NOTE_A3, NOTE_C4, NOTE_E4, NOTE_A4}, 4},           // Am和弦
+    {{NOTE_F3, NOTE_A3, NOTE_C4, NOTE_F4}, 4},           // F和弦
+    {{NOTE_C4, NOTE_E4, NOTE_G4, NOTE_C5, NOTE_E5}, 5},  // C和弦高八度
+    {{NOTE_G3, NOTE_B3, NOTE_D4, NOTE_G4, NOTE_B4}, 5},  // G和弦高八度
+    {{NOTE_A3, NOTE_C4, NOTE_E4, NOTE_A4, NOTE_C5}, 5},  // Am和弦高八度
+    {{NOTE_F3, NOTE_A3, NOTE_C4, NOTE_F4, NOTE_A4}, 5}   // F和弦高八度
+};
+
+// 节奏型
+static constexpr NoteRhythm NOTE_RHYTHMS[RHYTHM_COUNT] = {
+    {{BEAT_UNIT, BEAT_UNIT, BEAT_UNIT, BEAT_UNIT}, 4},                                      // 基本
+    {{BEAT_UNIT*5/3, BEAT_UNIT, BEAT_UNIT, BEAT_UNIT}, 4},                                  // 带重拍
+    {{BEAT_UNIT/2, BEAT_UNIT/2, BEAT_UNIT, BEAT_UNIT/2, BEAT_UNIT/2, BEAT_UNIT}, 6},        // 切分音
+    {{BEAT_UNIT, BEAT_UNIT*2/3, BEAT_UNIT*2/3, BEAT_UNIT*2/3, BEAT_UNIT}, 5},               // 三连音
+    {{BEAT_UNIT, BEAT_UNIT, BEAT_UNIT, BEAT_UNIT*5/3}, 4},                                  // 段落结束
+    {{BEAT_UNIT, BEAT_UNIT, BEAT_UNIT*2, BEAT_UNIT*3}, 4}                                   // 尾声渐慢
+};
+
+// ===== 默认舞曲: A(16) B(16) C(8) 尾声(8) 共48小节 =====
+// 休止符在第8、16、24、32、36、40小节的第一拍
+
+// A段 - 基础舞蹈主题，前8小节只用和弦的前3个音，每4小节第一拍加重
+static constexpr NoteMeasure DANCE_A[] = {
+    {CHORD_C, RHYTHM_BASIC, VOICING_CYCLE3, 0},
+    {CHORD_G, RHYTHM_BASIC, VOICING_CYCLE3, 0},
+    {CHORD_AM, RHYTHM_BASIC, VOICING_CYCLE3, 0},
+    {CHORD_F, RHYTHM_ACCENTED, VOICING_CYCLE3, MEASURE_ACCENT},
+    {CHORD_C, RHYTHM_BASIC, VOICING_CYCLE3, 0},
+    {CHORD_G, RHYTHM_BASIC, VOICING_CYCLE3, 0},
+    {CHORD_AM, RHYTHM_SYNCOPATION, VOICING_CYCLE3, 0},
+    {CHORD_F, RHYTHM_SYNCOPATION, VOICING_CYCLE3, MEASURE_ACCENT | MEASURE_REST},
+    {CHORD_C, RHYTHM_BASIC, VOICING_CYCLE4, 0},
+    {CHORD_G, RHYTHM_BASIC, VOICING_CYCLE4, 0},
+    {CHORD_AM, RHYTHM_BASIC, VOICING_CYCLE4, 0},
+    {CHORD_F, RHYTHM_ACCENTED, VOICING_CYCLE4, MEASURE_ACCENT},
+    {CHORD_C, RHYTHM_BASIC, VOICING_CYCLE4, 0},
+    {CHORD_G, RHYTHM_BASIC, VOICING_CYCLE4, 0},
+    {CHORD_AM, RHYTHM_BASIC, VOICING_CYCLE4, 0},
+    {CHORD_F, RHYTHM_SECTION_END, VOICING_CYCLE4, MEASURE_ACCENT | MEASURE_REST}
+};
+
+// B段 - 增加音高变化，切分音的弱拍使用高音区，第24和32小节用长音标记段落
+static constexpr NoteMeasure DANCE_B[] = {
+    {CHORD_F_HIGH, RHYTHM_ACCENTED, VOICING_ROOT_HIGH, 0},
+    {CHORD_C_HIGH, RHYTHM_BASIC, VOICING_ROOT_HIGH, 0},
+    {CHORD_G_HIGH, RHYTHM_BASIC, VOICING_ROOT_HIGH, 0},
+    {CHORD_AM_HIGH, RHYTHM_TRIPLET, VOICING_ROOT_HIGH, 0},
+    {CHORD_F_HIGH, RHYTHM_TRIPLET, VOICING_ROOT_HIGH, 0},
+    {CHORD_C_HIGH, RHYTHM_BASIC, VOICING_ROOT_HIGH, 0},
+    {CHORD_G_HIGH, RHYTHM_SYNCOPATION, VOICING_ROOT_HIGH, MEASURE_HIGH_OFFBEAT},
+    {CHORD_AM_HIGH, RHYTHM_SYNCOPATION, VOICING_ROOT_HIGH, MEASURE_HIGH_OFFBEAT | MEASURE_HOLD_END | MEASURE_REST},
+    {CHORD_F_HIGH, RHYTHM_SYNCOPATION, VOICING_ROOT_HIGH, MEASURE_HIGH_OFFBEAT},
+    {CHORD_C_HIGH, RHYTHM_SYNCOPATION, VOICING_ROOT_HIGH, MEASURE_HIGH_OFFBEAT},
+    {CHORD_G_HIGH, RHYTHM_BASIC, VOICING_ROOT_HIGH, 0},
+    {CHORD_AM_HIGH, RHYTHM_ACCENTED, VOICING_ROOT_HIGH, 0},
+    {CHORD_F_HIGH, RHYTHM_BASIC, VOICING_ROOT_HIGH, 0},
+    {CHORD_C_HIGH, RHYTHM_BASIC, VOICING_ROOT_HIGH, 0},
+    {CHORD_G_HIGH, RHYTHM_BASIC, VOICING_ROOT_HIGH, 0},
+    {CHORD_AM_HIGH, RHYTHM_SECTION_END, VOICING_ROOT_HIGH, MEASURE_HOLD_END | MEASURE_REST}
+};
+
+// C段 - 更多高音区，三连音的后几个音符使用高音区
+static constexpr NoteMeasure DANCE_C[] = {
+    {CHORD_C_HIGH, RHYTHM_ACCENTED, VOICING_HIGH_FIRST, 0},
+    {CHORD_AM_HIGH, RHYTHM_BASIC, VOICING_HIGH_FIRST, 0},
+    {CHORD_F_HIGH, RHYTHM_TRIPLET, VOICING_HIGH_FIRST, MEASURE_HIGH_TAIL},
+    {CHORD_G_HIGH, RHYTHM_BASIC, VOICING_HIGH_FIRST, MEASURE_REST},
+    {CHORD_C_HIGH, RHYTHM_BASIC, VOICING_HIGH_FIRST, 0},
+    {CHORD_AM_HIGH, RHYTHM_TRIPLET, VOICING_HIGH_FIRST, MEASURE_HIGH_TAIL},
+    {CHORD_F_HIGH, RHYTHM_BASIC, VOICING_HIGH_FIRST, 0},
+    {CHORD_G_HIGH, RHYTHM_SECTION_END, VOICING_HIGH_FIRST, MEASURE_REST}
+};
+
+// 尾声 - 渐强结束，最后4小节逐拍上行，以高音C长音结束
+static constexpr NoteMeasure DANCE_OUTRO[] = {
+    {CHORD_F_HIGH, RHYTHM_ACCENTED, VOICING_ROOT_FIRST, 0},
+    {CHORD_G_HIGH, RHYTHM_TRIPLET, VOICING_ROOT_FIRST, 0},
+    {CHORD_AM_HIGH, RHYTHM_BASIC, VOICING_ROOT_FIRST, 0},
+    {CHORD_C_HIGH, RHYTHM_BASIC, VOICING_ROOT_FIRST, 0},
+    {CHORD_F_HIGH, RHYTHM_BASIC, VOICING_ASCEND, 0},
+    {CHORD_G_HIGH, RHYTHM_BASIC, VOICING_ASCEND, 0},
+    {CHORD_AM_HIGH, RHYTHM_BASIC, VOICING_ASCEND, 0},
+    {CHORD_C_HIGH, RHYTHM_ENDING, VOICING_ASCEND, MEASURE_FINAL}
+};
+
+static constexpr NoteSection DANCE_SECTIONS[] = {
+    {DANCE_A, 16, SECTION_REPEAT_MID},
+    {DANCE_B, 16, SECTION_REPEAT_HIGH},
+    {DANCE_C, 8, SECTION_REPEAT_HIGH},
+    {DANCE_OUTRO, 8, SECTION_REPEAT_MID | SECTION_REPEAT_HIGH | SECTION_SLOW_STRETCH}
+};
+
+static constexpr NoteSong DANCE_SONG = {DANCE_CHORDS, CHORD_COUNT, DANCE_SECTIONS, 4};
+
+// ===== 编译期展开 =====
+
+// 歌曲展开后的步骤数
+static constexpr size_t songLength(const NoteSong& song) {
+    size_t length = 0;
+    for (uint8_t s = 0; s < song.count; s++) {
+        for (uint8_t m = 0; m < song.sections[s].count; m++) {
+            length += NOTE_RHYTHMS[song.sections[s].measures[m].rhythm].length;
+        }
+    }
+    return length;
+}
+
+// 一个小节中某一拍的步骤
+static constexpr NoteStep measureStep(const NoteSong& song, const NoteMeasure& measure, uint8_t sectionFlags, uint8_t beat) {
+    const NoteChord& chord = song.chords[measure.chord];
+    uint8_t top = chord.size - 1;
+    uint8_t high = top < 3 ? top : 3;  // 第4个和弦音 (和弦不足4个音时为最高音)
+    NoteStep step = {0, NOTE_RHYTHMS[measure.rhythm].durations[beat], measure.chord, 0, sectionFlags, 0};
+
+    // 在指定的小节第一拍插入休止符，持续一个基本单位
+    if ((measure.flags & MEASURE_REST) && beat == 0) {
+        step.pick = STEP_PICK_NOTE;
+        step.note = NOTE_REST;
+        step.duration = BEAT_UNIT;
+        return step;
+    }
+
+    switch (measure.voicing) {
+        case VOICING_CYCLE3:
+            step.pick = beat % 3;
+            break;
+        case VOICING_CYCLE4:
+            step.pick = beat % 4;
+            break;
+        case VOICING_ROOT_HIGH:
+            step.pick = (beat == 0) ? 0 : (beat == 2) ? high : STEP_PICK_RANDOM;
+            break;
+        case VOICING_HIGH_FIRST:
+            step.pick = (beat == 0) ? high : STEP_PICK_RANDOM;
+            break;
+        case VOICING_ROOT_FIRST:
+            step.pick = (beat == 0) ? 0 : STEP_PICK_RANDOM;
+            break;
+        case VOICING_ASCEND:
+        default:
+            step.pick = (beat == 0) ? 0 : (beat + 1 < top) ? beat + 1 : top;
+            break;
+    }
+    if (step.pick != STEP_PICK_RANDOM && step.pick > top) {
+        step.pick = top;
+    }
+
+    if ((measure.flags & MEASURE_ACCENT) && beat == 0) {
+        step.pick = high;
+        step.duration = BEAT_UNIT * 5/3;  // 稍微延长
+    }
+    if (((measure.flags & MEASURE_HIGH_OFFBEAT) && beat % 2 == 1) ||
+        ((measure.flags & MEASURE_HIGH_TAIL) && beat >= 1)) {
+        step.flags |= STEP_HIGH_SCALE;
+    }
+    if ((measure.flags & MEASURE_HOLD_END) && beat == 3) {
+        step.pick = top;
+        step.duration = BEAT_UNIT * 5/3;
+        step.flags &= ~STEP_HIGH_SCALE;
+    }
+    if ((measure.flags & MEASURE_FINAL) && beat == 3) {
+        step.pick = STEP_PICK_NOTE;
+        step.note = NOTE_C5;
+        step.duration = 1000;
+        step.flags &= ~STEP_HIGH_SCALE;
+    }
+    return step;
+}
+
+// 展开后的步骤表
+template <size_t N>
+struct NoteStepTable {
+    NoteStep steps[N];
+};
+
+// 逐段、逐小节、逐拍展开，返回步骤数
+static constexpr size_t expandSong(const NoteSong& song, NoteStep* steps) {
+    size_t i = 0;
+    for (uint8_t s = 0; s < song.count; s++) {
+        const NoteSection& section = song.sections[s];
+        for (uint8_t m = 0; m < section.count; m++) {
+            const NoteMeasure& measure = section.measures[m];
+            for (uint8_t beat = 0; beat < NOTE_RHYTHMS[measure.rhythm].length; beat++) {
+                steps[i++] = measureStep(song, measure, section.flags, beat);
+            }
+        }
+    }
+    return i;
+}
+
+template <size_t N>
+static constexpr NoteStepTable<N> buildScore(const NoteSong& song) {
+    NoteStepTable<N> table{};
+    expandSong(song, table.steps);
+    return table;
+}
+
+static constexpr size_t DANCE_LENGTH = songLength(DANCE_SONG);
+static constexpr NoteStepTable<DANCE_LENGTH> DANCE_STEPS = buildScore<DANCE_LENGTH>(DANCE_SONG);
+
+static_assert(DANCE_LENGTH == 209, "48-measure dance score expands to 209 steps");
+static_assert(DANCE_STEPS.steps[30].note == NOTE_REST && DANCE_STEPS.steps[30].pick == STEP_PICK_NOTE,
+              "measure 8 opens with a rest");
+static_assert(DANCE_STEPS.steps[DANCE_LENGTH - 1].note == NOTE_C5 && DANCE_STEPS.steps[DANCE_LENGTH - 1].duration == 1000,
+              "the dance ends on a long high C");
+
+const NoteScore DANCE_SCORE = {DANCE_STEPS.steps, DANCE_CHORDS, CHORD_COUNT, DANCE_LENGTH, NULL};
+
+// 歌曲展开后的步骤数
+size_t noteSongLength(const NoteSong& song) {
+    return songLength(song);
+}
+
+// 在运行时展开歌曲，与编译期展开使用相同的规则
+size_t noteSongExpand(const NoteSong& song, NoteStep* steps, size_t maxSteps) {
+    if (songLength(song) > maxSteps) {
+        return 0;
+    }
+    return expandSong(song, steps);
+}
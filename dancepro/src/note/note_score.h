@@ -0,0 +1,140 @@
+#ifndef NOTE_SCORE_H
+#define NOTE_SCORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 乐谱表 - 歌曲模板 (段落、小节、和弦、节奏) 在编译期展开成一张扁平的步骤表
+// 生成音符时只需按位置取一个步骤，再经过IMU调制，不再按小节号分支
+// 不依赖Arduino，可以在主机上单独编译
+
+// 和弦 (从低到高排列)
+#define NOTE_CHORD_MAX_TONES 5
+struct NoteChord {
+    uint16_t tones[NOTE_CHORD_MAX_TONES];
+    uint8_t size;
+};
+
+// 默认舞曲的和弦编号 (DANCE_CHORDS 的索引)
+enum NoteChordId : uint8_t {
+    CHORD_C, CHORD_G, CHORD_AM, CHORD_F,                      // 4音和弦
+    CHORD_C_HIGH, CHORD_G_HIGH, CHORD_AM_HIGH, CHORD_F_HIGH,  // 5音和弦，用于B段之后
+    CHORD_COUNT
+};
+
+// 节奏型 (一个小节内每拍的时值)
+#define NOTE_RHYTHM_MAX_BEATS 6
+struct NoteRhythm {
+    uint16_t durations[NOTE_RHYTHM_MAX_BEATS];
+    uint8_t length;
+};
+
+// 节奏编号 (NOTE_RHYTHMS 的索引)
+enum NoteRhythmId : uint8_t {
+    RHYTHM_BASIC,        // 基本4/4拍
+    RHYTHM_ACCENTED,     // 第一拍加重
+    RHYTHM_SYNCOPATION,  // 切分音
+    RHYTHM_TRIPLET,      // 三连音
+    RHYTHM_SECTION_END,  // 段落结束 (带长音)
+    RHYTHM_ENDING,       // 尾声渐慢
+    RHYTHM_COUNT
+};
+
+extern const NoteChord DANCE_CHORDS[CHORD_COUNT];
+
+// 小节内和弦音的选法
+enum NoteVoicing : uint8_t {
+    VOICING_CYCLE3,      // 依次使用和弦的前3个音
+    VOICING_CYCLE4,      // 依次使用和弦的前4个音
+    VOICING_ROOT_HIGH,   // 第一拍根音，第三拍第4个音，其余随机
+    VOICING_HIGH_FIRST,  // 第一拍第4个音，其余随机
+    VOICING_ROOT_FIRST,  // 第一拍根音，其余随机
+    VOICING_ASCEND       // 第一拍根音，之后逐拍上行
+};
+
+// 小节标记
+#define MEASURE_REST          0x01  // 第一拍为休止符
+#define MEASURE_ACCENT        0x02  // 第一拍用第4个和弦音并延长
+#define MEASURE_HIGH_OFFBEAT  0x04  // 奇数拍换成高音区随机音
+#define MEASURE_HIGH_TAIL     0x08  // 第一拍之后换成高音区随机音
+#define MEASURE_HOLD_END      0x10  // 第四拍用和弦最高音并延长
+#define MEASURE_FINAL         0x20  // 第四拍用高音C长音结束
+
+// 一个小节
+struct NoteMeasure {
+    uint8_t chord;    // 歌曲和弦表的索引
+    uint8_t rhythm;   // NoteRhythmId
+    uint8_t voicing;  // NoteVoicing
+    uint8_t flags;    // MEASURE_*
+};
+
+// 段落标记，决定IMU调制阶段的行为
+#define SECTION_REPEAT_MID    0x01  // 与上一个音相同时换成中音区随机音
+#define SECTION_REPEAT_HIGH   0x02  // 与上一个音相同时换成高音区随机音 (两者都设置时随机选一个音区)
+#define SECTION_SLOW_STRETCH  0x04  // 缓慢移动时延长音符
+
+// 一个段落
+struct NoteSection {
+    const NoteMeasure* measures;
+    uint8_t count;
+    uint8_t flags;    // SECTION_*
+};
+
+// 歌曲模板
+struct NoteSong {
+    const NoteChord* chords;  // 和弦表
+    uint8_t chordCount;
+    const NoteSection* sections;
+    uint8_t count;
+};
+
+// 步骤的音符选法
+#define STEP_PICK_RANDOM  0xFE  // 在整个和弦中随机选
+#define STEP_PICK_NOTE    0xFF  // 直接使用note (包括休止符)
+
+// 步骤标记 (低3位与段落标记相同)
+#define STEP_REPEAT_MID   SECTION_REPEAT_MID
+#define STEP_REPEAT_HIGH  SECTION_REPEAT_HIGH
+#define STEP_SLOW_STRETCH SECTION_SLOW_STRETCH
+#define STEP_HIGH_SCALE   0x08  // 选出和弦音后再换成高音区随机音
+
+// 乐谱中的一步 (一个音符)
+struct NoteStep {
+    uint16_t note;      // STEP_PICK_NOTE 时的音符频率
+    uint16_t duration;  // 时值 (ms)
+    uint8_t chord;      // 乐谱和弦表的索引
+    uint8_t pick;       // 和弦音索引，或 STEP_PICK_*
+    uint8_t flags;      // STEP_*
+    uint8_t reserved;
+};
+
+// 展开后的乐谱
+struct NoteScore {
+    const NoteStep* steps;    // 步骤表 (read不为NULL时不使用)
+    const NoteChord* chords;  // 和弦表 (read不为NULL时不使用)
+    uint8_t chordCount;       // 和弦数
+    size_t length;            // 步骤数
+    // 从存储中按需读取一步和它的和弦，乐谱不载入内存 (见 note_song.h)
+    bool (*read)(size_t index, NoteStep& step, NoteChord& chord);
+};
+
+// 默认的48小节舞曲，步骤表在编译期生成，存放在flash中
+extern const NoteScore DANCE_SCORE;
+
+// 读取第index步和它的和弦
+inline bool noteScoreRead(const NoteScore& score, size_t index, NoteStep& step, NoteChord& chord) {
+    if (score.read != NULL) {
+        return score.read(index, step, chord);
+    }
+    step = score.steps[index];
+    chord = score.chords[step.chord];
+    return true;
+}
+
+// 歌曲展开后的步骤数
+size_t noteSongLength(const NoteSong& song);
+
+// 在运行时展开歌曲 (用于生成乐谱文件)，返回写入的步骤数，空间不足返回0
+size_t noteSongExpand(const NoteSong& song, NoteStep* steps, size_t maxSteps);
+
+#endif
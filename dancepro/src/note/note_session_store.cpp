@@ -0,0 +1,322 @@
+#include "note/note_session_store.h"
+#include <LittleFS.h>
+#include <M5Unified.h>
+#include "note/note_codec.h"
+
+// 索引记录按内存布局直接写入 (小端)
+static_assert(sizeof(SessionInfo) == 28, "SessionInfo must be packed");
+#define SESSION_INDEX_HEADER_SIZE 4
+
+// 索引和文件由互斥锁保护: 录制任务追加，AsyncTCP任务读取和清空
+static SemaphoreHandle_t storeMutex = NULL;
+static SessionInfo sessionIndex[SESSION_STORE_MAX];
+static size_t sessionCount = 0;
+static uint32_t logSize = 0;
+static uint32_t nextId = 1;
+static uint32_t generation = 0;
+static bool fsMounted = false;
+
+// 下载共用的读文件，追加或清空后重新打开
+static File readFile;
+
+// 写缓冲区，攒满后写入日志
+static uint8_t writeBuffer[SESSION_WRITE_BUFFER];
+
+// 索引文件头部
+static void encodeIndexHeader(uint8_t* buf) {
+    buf[0] = 'D';
+    buf[1] = 'S';
+    buf[2] = SESSION_INDEX_VERSION;
+    buf[3] = 0;
+}
+
+// 按内存中的索引重写索引文件 (只在启动时发现不完整的记录后调用)
+static bool rewriteIndex() {
+    File index = LittleFS.open(SESSION_INDEX_PATH, FILE_WRITE);
+    if (!index) {
+        return false;
+    }
+    uint8_t header[SESSION_INDEX_HEADER_SIZE];
+    encodeIndexHeader(header);
+    bool ok = index.write(header, sizeof(header)) == sizeof(header) &&
+              index.write((const uint8_t*)sessionIndex, sessionCount * sizeof(SessionInfo)) ==
+                  sessionCount * sizeof(SessionInfo);
+    index.close();
+    return ok;
+}
+
+// 读取索引，丢弃超出日志文件的记录 (写入日志后断电)
+static bool loadIndex() {
+    File log = LittleFS.open(SESSION_LOG_PATH, FILE_READ);
+    logSize = log ? log.size() : 0;
+    log.close();
+
+    File index = LittleFS.open(SESSION_INDEX_PATH, FILE_READ);
+    if (!index) {
+        return true;
+    }
+    uint8_t header[SESSION_INDEX_HEADER_SIZE];
+    uint8_t expected[SESSION_INDEX_HEADER_SIZE];
+    encodeIndexHeader(expected);
+    if (index.read(header, sizeof(header)) != sizeof(header) || memcmp(header, expected, sizeof(header)) != 0) {
+        M5.Log.println("[Session] 索引格式错误");
+        index.close();
+        return false;
+    }
+    SessionInfo info;
+    while (sessionCount < SESSION_STORE_MAX && index.read((uint8_t*)&info, sizeof(info)) == sizeof(info)) {
+        if (info.offset + info.length > logSize) {
+            M5.Log.printf("[Session] 会话 #%u 不完整，已丢弃\n", (unsigned)info.id);
+            break;
+        }
+        sessionIndex[sessionCount++] = info;
+        if (info.id >= nextId) {
+            nextId = info.id + 1;
+        }
+    }
+    // 末尾有不完整或被丢弃的记录时重写索引，之后的追加保持对齐
+    bool intact = index.size() == SESSION_INDEX_HEADER_SIZE + sessionCount * sizeof(SessionInfo);
+    index.close();
+    if (!intact && !rewriteIndex()) {
+        M5.Log.println("[Session] 索引修复失败");
+        return false;
+    }
+    return true;
+}
+
+// 挂载文件系统并读取索引
+bool initSessionStore() {
+    if (storeMutex == NULL) {
+        storeMutex = xSemaphoreCreateMutex();
+        if (storeMutex == NULL) {
+            return false;
+        }
+    }
+    if (fsMounted) {
+        return true;
+    }
+    fsMounted = LittleFS.begin(true);
+    if (!fsMounted) {
+        M5.Log.println("[Session] LittleFS挂载失败");
+        return false;
+    }
+    if (!LittleFS.exists(SESSION_DIR)) {
+        LittleFS.mkdir(SESSION_DIR);
+    }
+    if (!loadIndex()) {
+        return false;
+    }
+    M5.Log.printf("[Session] 已保存 %u 个会话，%u 字节\n", (unsigned)sessionCount, (unsigned)logSize);
+    return true;
+}
+
+// 关闭文件并丢弃内存中的索引，正在下载的会话读取失败
+void endSessionStore() {
+    if (storeMutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    readFile.close();
+    sessionCount = 0;
+    logSize = 0;
+    nextId = 1;
+    generation++;
+    fsMounted = false;
+    xSemaphoreGive(storeMutex);
+}
+
+// 把一个会话编码后写入日志，返回写入的字节数，失败返回0
+static uint32_t writeSessionLog(File& log, const NoteSession& session) {
+    NoteEncoder encoder;
+    size_t used = noteEncodeHeader(encoder, session.log.count, writeBuffer, sizeof(writeBuffer));
+    uint32_t written = 0;
+    for (size_t i = 0; i < session.log.count; i++) {
+        if (used + NOTE_CODEC_EVENT_SIZE > sizeof(writeBuffer)) {
+            if (log.write(writeBuffer, used) != used) {
+                return 0;
+            }
+            written += used;
+            used = 0;
+        }
+        used += noteEncodeEvent(encoder, session.log.events[i], writeBuffer + used, sizeof(writeBuffer) - used);
+    }
+    if (log.write(writeBuffer, used) != used) {
+        return 0;
+    }
+    return written + used;
+}
+
+// 追加保存一批会话
+bool appendSessions(const NoteSession* const* sessions, size_t count) {
+    if (!fsMounted || count == 0) {
+        return false;
+    }
+    // 只保存放得下的会话
+    uint32_t size = 0;
+    size_t fit = 0;
+    while (fit < count && fit < RECORDER_SESSIONS && sessionCount + fit < SESSION_STORE_MAX &&
+           logSize + size + NOTE_CODEC_SIZE(sessions[fit]->log.count) <= SESSION_LOG_MAX_BYTES) {
+        size += NOTE_CODEC_SIZE(sessions[fit]->log.count);
+        fit++;
+    }
+    if (fit < count) {
+        M5.Log.printf("[Session] 存储已满，%u 个会话未保存\n", (unsigned)(count - fit));
+    }
+    if (fit == 0) {
+        return false;
+    }
+
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    readFile.close();
+    SessionInfo added[RECORDER_SESSIONS];
+    size_t addedCount = 0;
+    File log = LittleFS.open(SESSION_LOG_PATH, FILE_APPEND);
+    if (log) {
+        // 追加前的文件大小可能大于索引记录的末尾 (上次写入后断电)，新会话从文件末尾开始
+        uint32_t offset = log.size();
+        for (size_t i = 0; i < fit; i++) {
+            const NoteSession& session = *sessions[i];
+            uint32_t length = writeSessionLog(log, session);
+            if (length == 0) {
+                break;
+            }
+            added[addedCount++] = {session.id, session.startTime, session.duration, offset, length,
+                                   session.seed, (uint16_t)session.log.count, session.tempo};
+            offset += length;
+        }
+        log.close();
+        logSize = offset;
+    }
+
+    // 日志写完后再写索引，索引中的会话都是完整的
+    bool ok = false;
+    if (addedCount > 0) {
+        bool created = !LittleFS.exists(SESSION_INDEX_PATH);
+        File index = LittleFS.open(SESSION_INDEX_PATH, FILE_APPEND);
+        if (index) {
+            ok = true;
+            if (created) {
+                uint8_t header[SESSION_INDEX_HEADER_SIZE];
+                encodeIndexHeader(header);
+                ok = index.write(header, sizeof(header)) == sizeof(header);
+            }
+            ok = ok && index.write((const uint8_t*)added, addedCount * sizeof(SessionInfo)) ==
+                           addedCount * sizeof(SessionInfo);
+            index.close();
+        }
+        if (ok) {
+            for (size_t i = 0; i < addedCount; i++) {
+                sessionIndex[sessionCount++] = added[i];
+                if (added[i].id >= nextId) {
+                    nextId = added[i].id + 1;
+                }
+            }
+        }
+    }
+    xSemaphoreGive(storeMutex);
+
+    if (!ok) {
+        M5.Log.println("[Session] 会话写入失败");
+        return false;
+    }
+    M5.Log.printf("[Session] 已保存 %u 个会话，共 %u 个，%u 字节\n", (unsigned)addedCount, (unsigned)sessionCount,
+                  (unsigned)logSize);
+    return fit == count;
+}
+
+// 删除所有会话
+bool clearSessions() {
+    if (!fsMounted) {
+        return false;
+    }
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+    readFile.close();
+    bool ok = (!LittleFS.exists(SESSION_INDEX_PATH) || LittleFS.remove(SESSION_INDEX_PATH)) &&
+              (!LittleFS.exists(SESSION_LOG_PATH) || LittleFS.remove(SESSION_LOG_PATH));
+    sessionCount = 0;
+    logSize = 0;
+    generation++;
+    xSemaphoreGive(storeMutex);
+    M5.Log.println(ok ? "[Session] 已删除所有会话" : "[Session] 删除会话失败");
+    return ok;
+}
+
+// 已保存的会话数
+size_t getSessionCount() {
+    return sessionCount;
+}
+
+// 第index个会话
+SessionLookup getSessionAt(size_t index, SessionInfo& info, TickType_t wait) {
+    if (storeMutex == NULL) {
+        return SESSION_MISSING;
+    }
+    if (!xSemaphoreTake(storeMutex, wait)) {
+        return SESSION_BUSY;
+    }
+    bool found = index < sessionCount;
+    if (found) {
+        info = sessionIndex[index];
+    }
+    xSemaphoreGive(storeMutex);
+    return found ? SESSION_FOUND : SESSION_MISSING;
+}
+
+// 按编号查找会话，编号按保存顺序递增，二分查找
+SessionLookup findSession(uint32_t id, SessionInfo& info, uint32_t& version, TickType_t wait) {
+    if (storeMutex == NULL) {
+        return SESSION_MISSING;
+    }
+    if (!xSemaphoreTake(storeMutex, wait)) {
+        return SESSION_BUSY;
+    }
+    size_t low = 0;
+    size_t high = sessionCount;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (sessionIndex[mid].id < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    bool found = low < sessionCount && sessionIndex[low].id == id;
+    if (found) {
+        info = sessionIndex[low];
+        version = generation;
+    }
+    xSemaphoreGive(storeMutex);
+    return found ? SESSION_FOUND : SESSION_MISSING;
+}
+
+// 下一个会话的编号
+uint32_t getNextSessionId() {
+    return nextId;
+}
+
+// 日志文件已使用的字节数
+uint32_t getSessionStoreUsed() {
+    return logSize;
+}
+
+// 读取会话数据
+int readSessionData(const SessionInfo& info, uint32_t expected, uint32_t offset, uint8_t* buf, size_t len,
+                    TickType_t wait) {
+    if (storeMutex == NULL || !xSemaphoreTake(storeMutex, wait)) {
+        return 0;
+    }
+    int result = -1;
+    if (generation == expected && offset < info.length) {
+        if (!readFile) {
+            readFile = LittleFS.open(SESSION_LOG_PATH, FILE_READ);
+        }
+        if (len > info.length - offset) {
+            len = info.length - offset;
+        }
+        if (readFile && readFile.seek(info.offset + offset) && readFile.read(buf, len) == len) {
+            result = (int)len;
+        }
+    }
+    xSemaphoreGive(storeMutex);
+    return result;
+}
@@ -0,0 +1,76 @@
+#ifndef NOTE_SESSION_STORE_H
+#define NOTE_SESSION_STORE_H
+
+#include <Arduino.h>
+#include "note/note_recorder.h"
+
+// 录制会话存储 (LittleFS) - 保存每一次录制，GET /api/sessions 列出和下载
+//
+// 日志文件: 各会话按二进制音符格式 (note/note_codec.h) 依次追加，写入后不再修改
+// 索引文件: 头部 'D' 'S' 版本 保留，之后每个会话一条定长记录，在日志写完后追加
+// 断电时最后一次写入不完整的会话在启动时丢弃；只追加不改写，清空时删除两个文件
+#define SESSION_DIR         "/sessions"
+#define SESSION_LOG_PATH    "/sessions/log.bin"
+#define SESSION_INDEX_PATH  "/sessions/index.bin"
+#define SESSION_INDEX_VERSION 1
+
+// 最多保存的会话数 (索引常驻内存，每条28字节)
+#define SESSION_STORE_MAX       256
+// 日志文件大小上限，平均每个会话约1KB，足够一整天的排练
+#define SESSION_LOG_MAX_BYTES   (256 * 1024)
+// 写缓冲区大小，攒满后一次写入闪存
+#define SESSION_WRITE_BUFFER    512
+
+// 一个已保存的会话
+struct SessionInfo {
+    uint32_t id;
+    uint32_t startTime;  // 开始时间 (UNIX时间戳，时间未同步时为0)
+    uint32_t duration;   // 录制时长 (ms)
+    uint32_t offset;     // 在日志文件中的位置
+    uint32_t length;     // 字节数 (二进制音符格式)
+    uint32_t seed;
+    uint16_t count;      // 音符数
+    uint16_t tempo;      // 开始时的节拍速度 (BPM)
+};
+
+// 查找结果
+enum SessionLookup {
+    SESSION_FOUND,
+    SESSION_MISSING,  // 超出范围或没有这个编号
+    SESSION_BUSY      // 锁等待超时 (正在写入)，稍后再试
+};
+
+// 挂载文件系统并读取索引
+bool initSessionStore();
+
+// 关闭文件并丢弃内存中的索引，之后 initSessionStore 重新读取 (主机测试中模拟重启)
+void endSessionStore();
+
+// 追加保存一批会话 (最多 RECORDER_SESSIONS 个，按编号顺序): 所有会话的数据先写入日志，再一次写入它们的索引
+// 有会话因为空间不足或写入失败没有保存时返回false
+bool appendSessions(const NoteSession* const* sessions, size_t count);
+
+// 删除所有会话
+bool clearSessions();
+
+// 已保存的会话数
+size_t getSessionCount();
+
+// 第index个会话 (按保存顺序)
+SessionLookup getSessionAt(size_t index, SessionInfo& info, TickType_t wait);
+
+// 按编号查找会话，同时返回存储版本 (传给 readSessionData)
+SessionLookup findSession(uint32_t id, SessionInfo& info, uint32_t& generation, TickType_t wait);
+
+// 下一个会话的编号 (已保存的最大编号 + 1)
+uint32_t getNextSessionId();
+
+// 日志文件已使用的字节数
+uint32_t getSessionStoreUsed();
+
+// 读取会话数据 (从会话开头的offset开始)，返回读取的字节数
+// 存储版本每次清空时递增，下载过程中被清空或读取失败返回-1，锁等待超时返回0
+int readSessionData(const SessionInfo& info, uint32_t generation, uint32_t offset, uint8_t* buf, size_t len,
+                    TickType_t wait);
+
+#endif
@@ -0,0 +1,76 @@
+#include "note/note_song.h"
+#include "note/note_codec.h"
+
+// 写入乐谱文件
+size_t noteSongEncode(const NoteScore& score, uint8_t* buf, size_t len) {
+    if (score.read != NULL || score.length > 0xFFFF || len < NOTE_SONG_SIZE(score.chordCount, score.length)) {
+        return 0;
+    }
+    buf[0] = 'D';
+    buf[1] = 'S';
+    buf[2] = NOTE_SONG_VERSION;
+    buf[3] = score.chordCount;
+    buf[4] = score.length & 0xFF;
+    buf[5] = score.length >> 8;
+    buf[6] = 0;
+    buf[7] = 0;
+    uint8_t* p = buf + NOTE_SONG_HEADER_SIZE;
+
+    for (uint8_t i = 0; i < score.chordCount; i++, p += NOTE_SONG_CHORD_SIZE) {
+        const NoteChord& chord = score.chords[i];
+        p[0] = chord.size;
+        for (uint8_t t = 0; t < NOTE_CHORD_MAX_TONES; t++) {
+            p[1 + t] = (t < chord.size) ? noteFreqToIndex(chord.tones[t]) : 0;
+        }
+    }
+
+    for (size_t i = 0; i < score.length; i++, p += NOTE_SONG_STEP_SIZE) {
+        const NoteStep& step = score.steps[i];
+        p[0] = (step.note == 0) ? 0 : noteFreqToIndex(step.note) + 1;
+        p[1] = step.duration & 0xFF;
+        p[2] = step.duration >> 8;
+        p[3] = step.chord;
+        p[4] = step.pick;
+        p[5] = step.flags;
+    }
+    return p - buf;
+}
+
+// 解析头部
+bool noteSongDecodeHeader(const uint8_t* buf, size_t len, NoteSongHeader& header) {
+    if (len < NOTE_SONG_HEADER_SIZE || buf[0] != 'D' || buf[1] != 'S' || buf[2] != NOTE_SONG_VERSION) {
+        return false;
+    }
+    header.chordCount = buf[3];
+    header.stepCount = buf[4] | (buf[5] << 8);
+    return header.chordCount > 0 && header.stepCount > 0;
+}
+
+// 解析和弦
+bool noteSongDecodeChord(const uint8_t* buf, size_t len, NoteChord& chord) {
+    if (len < NOTE_SONG_CHORD_SIZE || buf[0] == 0 || buf[0] > NOTE_CHORD_MAX_TONES) {
+        return false;
+    }
+    chord.size = buf[0];
+    for (uint8_t t = 0; t < NOTE_CHORD_MAX_TONES; t++) {
+        if (t < chord.size && buf[1 + t] >= NOTE_INDEX_COUNT) {
+            return false;
+        }
+        chord.tones[t] = (t < chord.size) ? noteIndexToFreq(buf[1 + t]) : 0;
+    }
+    return true;
+}
+
+// 解析步骤
+bool noteSongDecodeStep(const uint8_t* buf, size_t len, const NoteSongHeader& header, NoteStep& step) {
+    if (len < NOTE_SONG_STEP_SIZE || buf[3] >= header.chordCount || buf[0] > NOTE_INDEX_COUNT) {
+        return false;
+    }
+    step.note = (buf[0] == 0) ? 0 : noteIndexToFreq(buf[0] - 1);
+    step.duration = buf[1] | (buf[2] << 8);
+    step.chord = buf[3];
+    step.pick = buf[4];
+    step.flags = buf[5];
+    step.reserved = 0;
+    return true;
+}
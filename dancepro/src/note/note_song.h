@@ -0,0 +1,55 @@
+#ifndef NOTE_SONG_H
+#define NOTE_SONG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "note/note_score.h"
+
+// 乐谱文件格式 - 展开后的乐谱，存放在LittleFS的 /songs/<名称>.bin
+// 换曲风只需要上传新的乐谱文件，不需要重新烧录固件
+// 不依赖Arduino，可以在主机上单独编译
+//
+// 头部 (8字节): 'D' 'S' 版本 和弦数 步骤数(uint16) 保留(uint16)
+// 每个和弦6字节: 音数(1-5) 5个音 (半音索引，0 = C2，最高B6)
+// 每个步骤6字节: 音符 (0 = 休止符，否则为半音索引+1) 时值(uint16, ms) 和弦 选法 标记
+// 所有多字节字段都是小端，字段含义与 NoteStep 相同
+// 定长记录，可以按索引直接定位，播放时逐步读取而不把整个乐谱读入内存
+
+#define NOTE_SONG_VERSION      1
+#define NOTE_SONG_HEADER_SIZE  8
+#define NOTE_SONG_CHORD_SIZE   6
+#define NOTE_SONG_STEP_SIZE    6
+
+// 乐谱文件大小
+#define NOTE_SONG_SIZE(chords, steps) \
+    (NOTE_SONG_HEADER_SIZE + (size_t)(chords) * NOTE_SONG_CHORD_SIZE + (size_t)(steps) * NOTE_SONG_STEP_SIZE)
+
+// 头部信息
+struct NoteSongHeader {
+    uint8_t chordCount;
+    uint16_t stepCount;
+};
+
+// 第index个和弦在文件中的位置
+inline size_t noteSongChordOffset(uint8_t index) {
+    return NOTE_SONG_HEADER_SIZE + (size_t)index * NOTE_SONG_CHORD_SIZE;
+}
+
+// 第index步在文件中的位置
+inline size_t noteSongStepOffset(const NoteSongHeader& header, size_t index) {
+    return NOTE_SONG_SIZE(header.chordCount, index);
+}
+
+// 把乐谱写成文件格式，返回写入的字节数，空间不足或乐谱太长返回0
+size_t noteSongEncode(const NoteScore& score, uint8_t* buf, size_t len);
+
+// 解析头部，格式或版本不对返回false
+bool noteSongDecodeHeader(const uint8_t* buf, size_t len, NoteSongHeader& header);
+
+// 解析一个和弦，音数或音高超出范围返回false
+bool noteSongDecodeChord(const uint8_t* buf, size_t len, NoteChord& chord);
+
+// 解析一个步骤，和弦编号超出范围返回false
+bool noteSongDecodeStep(const uint8_t* buf, size_t len, const NoteSongHeader& header, NoteStep& step);
+
+#endif
@@ -0,0 +1,123 @@
+#include "note/note_song_store.h"
+#include <LittleFS.h>
+#include <M5Unified.h>
+#include "note/note.h"
+
+// 选择由HTTP任务写入，切换在按钮任务中进行
+static portMUX_TYPE songMux = portMUX_INITIALIZER_UNLOCKED;
+static char pendingSong[NOTE_SONG_NAME_MAX + 1] = NOTE_SONG_BUILTIN;
+static char activeSong[NOTE_SONG_NAME_MAX + 1] = NOTE_SONG_BUILTIN;
+
+// 当前打开的乐谱文件，只在音符任务中读取
+static File songFile;
+static NoteSongHeader songHeader;
+static NoteScore fileScore;
+static bool fsMounted = false;
+
+// 乐谱文件路径
+static String songPath(const char* name) {
+    return String(NOTE_SONG_DIR) + "/" + name + ".bin";
+}
+
+static bool mountSongFS() {
+    if (!fsMounted) {
+        fsMounted = LittleFS.begin(true);
+        if (!fsMounted) {
+            M5.Log.println("[Song] LittleFS挂载失败");
+        }
+    }
+    return fsMounted;
+}
+
+// 打开乐谱文件并检查头部和大小
+static bool openSongFile(const char* name, File& file, NoteSongHeader& header) {
+    if (!mountSongFS()) {
+        return false;
+    }
+    file = LittleFS.open(songPath(name), FILE_READ);
+    if (!file) {
+        M5.Log.printf("[Song] 找不到乐谱: %s\n", name);
+        return false;
+    }
+    uint8_t buf[NOTE_SONG_HEADER_SIZE];
+    if (file.read(buf, sizeof(buf)) != sizeof(buf) || !noteSongDecodeHeader(buf, sizeof(buf), header) ||
+        file.size() < NOTE_SONG_SIZE(header.chordCount, header.stepCount)) {
+        M5.Log.printf("[Song] 乐谱格式错误: %s\n", name);
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+// 按需读取一步: 定长记录直接定位，每个音符只读12字节，经过LittleFS缓存
+static bool readSongStep(size_t index, NoteStep& step, NoteChord& chord) {
+    uint8_t buf[NOTE_SONG_STEP_SIZE];
+    if (!songFile.seek(noteSongStepOffset(songHeader, index)) ||
+        songFile.read(buf, sizeof(buf)) != sizeof(buf) ||
+        !noteSongDecodeStep(buf, sizeof(buf), songHeader, step)) {
+        return false;
+    }
+    if (!songFile.seek(noteSongChordOffset(step.chord)) ||
+        songFile.read(buf, NOTE_SONG_CHORD_SIZE) != NOTE_SONG_CHORD_SIZE ||
+        !noteSongDecodeChord(buf, NOTE_SONG_CHORD_SIZE, chord)) {
+        return false;
+    }
+    // 和弦音索引必须在和弦范围内
+    return step.pick == STEP_PICK_RANDOM || step.pick == STEP_PICK_NOTE || step.pick < chord.size;
+}
+
+// 选择乐谱
+bool selectNoteSong(const char* name) {
+    size_t length = strlen(name);
+    if (length == 0 || length > NOTE_SONG_NAME_MAX || strchr(name, '/') != NULL) {
+        M5.Log.printf("[Song] 无效的乐谱名称: %s\n", name);
+        return false;
+    }
+    if (strcmp(name, NOTE_SONG_BUILTIN) != 0) {
+        File file;
+        NoteSongHeader header;
+        if (!openSongFile(name, file, header)) {
+            return false;
+        }
+        file.close();
+    }
+    portENTER_CRITICAL(&songMux);
+    strcpy(pendingSong, name);
+    portEXIT_CRITICAL(&songMux);
+    M5.Log.printf("[Song] 已选择乐谱: %s，下次录制生效\n", name);
+    return true;
+}
+
+// 切换到已选择的乐谱
+void applyNoteSong() {
+    char name[NOTE_SONG_NAME_MAX + 1];
+    portENTER_CRITICAL(&songMux);
+    strcpy(name, pendingSong);
+    portEXIT_CRITICAL(&songMux);
+    if (strcmp(name, activeSong) == 0) {
+        return;
+    }
+
+    if (songFile) {
+        songFile.close();
+    }
+    if (strcmp(name, NOTE_SONG_BUILTIN) == 0 || !openSongFile(name, songFile, songHeader)) {
+        // 文件在选择之后被删除或损坏时回到内置舞曲
+        strcpy(name, NOTE_SONG_BUILTIN);
+        setNoteScore(NULL);
+    } else {
+        fileScore.steps = NULL;
+        fileScore.chords = NULL;
+        fileScore.chordCount = songHeader.chordCount;
+        fileScore.length = songHeader.stepCount;
+        fileScore.read = readSongStep;
+        setNoteScore(&fileScore);
+    }
+    strcpy(activeSong, name);
+    M5.Log.printf("[Song] 使用乐谱: %s\n", activeSong);
+}
+
+// 当前使用的乐谱名称
+const char* currentNoteSong() {
+    return activeSong;
+}
@@ -0,0 +1,26 @@
+#ifndef NOTE_SONG_STORE_H
+#define NOTE_SONG_STORE_H
+
+#include <Arduino.h>
+#include "note/note_song.h"
+
+// 乐谱文件存放的目录，文件名为 <名称>.bin
+#define NOTE_SONG_DIR "/songs"
+
+// 内置舞曲的名称 (不需要文件)
+#define NOTE_SONG_BUILTIN "dance"
+
+// 名称最大长度
+#define NOTE_SONG_NAME_MAX 24
+
+// 选择乐谱: 检查文件是否有效并记下名称，下一次开始录制时生效
+// 选择失败时保持原来的乐谱
+bool selectNoteSong(const char* name);
+
+// 切换到已选择的乐谱，在开始录制 (音符任务创建) 之前调用
+void applyNoteSong();
+
+// 当前使用的乐谱名称
+const char* currentNoteSong();
+
+#endif
@@ -1,5 +1,6 @@
 #include "note/note_ui.h"
 #include "imu/imu.h"
+#include "ui/ui_widget.h"
 
 // 简化的配色方案 - 仅使用三种主要颜色
 #define COLOR_BG            0x0000  // 黑色背景
@@ -17,12 +18,101 @@ static bool blinkState = false;  // 红点闪烁状态
 // 状态栏高度
 #define STATUS_BAR_HEIGHT 20
 
+// 按钮和律动条布局
+#define BTN_WIDTH       90
+#define BTN_HEIGHT      30
+#define BTN_START_Y     70
+#define BTN_STOP_Y      95
+#define WAVE_Y          50
+#define WAVE_HEIGHT     11
+#define BAR_COUNT       12
+#define BAR_WIDTH       8
+#define BAR_GAP         2
+#define BAR_BASE_Y      70
+#define BAR_MAX_HEIGHT  40
+#define TIMER_WIDTH     45
+
 // 全局判断变量，用于控制清屏和重绘
 bool noteUIRedrawNeeded = true;
 
+// 开始界面的控件
+enum { IDLE_WAVE, IDLE_PULSE, IDLE_WIDGET_COUNT };
+static UIWidget idleWidgets[IDLE_WIDGET_COUNT];
+
+// 录制界面的控件，律动条排在最后
+enum { REC_DOT, REC_TIMER, REC_BAR0, REC_WIDGET_COUNT = REC_BAR0 + BAR_COUNT };
+static UIWidget recWidgets[REC_WIDGET_COUNT];
+
+static bool widgetsReady = false;
+
+// 波形: value为动画帧，每5列一条竖线
+static void drawWave(const UIWidget& widget) {
+  const UIRect& r = widget.bounds;
+  float offset = widget.value * 0.5;
+  for (int i = r.x; i < r.x + r.w; i += 5) {
+    int waveHeight = 5 + 5 * sin(i * 0.1 + offset);
+    M5.Display.drawFastVLine(i, r.y, waveHeight + 1, COLOR_PRIMARY);
+    M5.Display.drawFastVLine(i, r.y + waveHeight + 1, r.h - waveHeight - 1, COLOR_BG);
+  }
+}
+
+// 按钮脉冲边框: value为边框颜色
+static void drawPulse(const UIWidget& widget) {
+  const UIRect& r = widget.bounds;
+  // 清除按钮边框区域
+  M5.Display.drawRoundRect(r.x, r.y, r.w, r.h, 10, COLOR_BG);
+  M5.Display.drawRoundRect(r.x + 1, r.y + 1, r.w - 2, r.h - 2, 9, COLOR_BG);
+  // 绘制新的脉冲
+  M5.Display.drawRoundRect(r.x + 1, r.y + 1, r.w - 2, r.h - 2, 10, (uint16_t)widget.value);
+}
+
+// 录制指示点: value为是否点亮
+static void drawDot(const UIWidget& widget) {
+  const UIRect& r = widget.bounds;
+  M5.Display.fillCircle(r.x + r.w / 2, r.y + r.h / 2, 5, widget.value ? COLOR_ACCENT : COLOR_BG);
+}
+
+// 录制时间: value为秒数，文本带背景色绘制，不需要先清除
+static void drawTimer(const UIWidget& widget) {
+  const UIRect& r = widget.bounds;
+  M5.Display.setTextColor(COLOR_TEXT, COLOR_BG);
+  M5.Display.setTextSize(1);
+  M5.Display.setCursor(r.x, r.y + 6);
+  M5.Display.printf("%02d:%02d", (int)(widget.value / 60) % 100, (int)(widget.value % 60));
+}
+
+// 律动条: value为高度，只画变化的部分
+static void drawBar(const UIWidget& widget) {
+  const UIRect& r = widget.bounds;
+  int barHeight = widget.value;
+  M5.Display.fillRect(r.x, r.y, r.w, r.h - barHeight, COLOR_BG);
+  M5.Display.fillRect(r.x, r.y + r.h - barHeight, r.w, barHeight, COLOR_PRIMARY);
+}
+
+// 创建控件，屏幕尺寸在M5.begin之后才确定
+static void initWidgets() {
+  int width = M5.Display.width();
+  int btnX = (width - BTN_WIDTH) / 2;
+  uiWidgetInit(idleWidgets[IDLE_WAVE], 0, WAVE_Y, width, WAVE_HEIGHT, COLOR_BG, drawWave);
+  uiWidgetInit(idleWidgets[IDLE_PULSE], btnX - 3, BTN_START_Y - 3, BTN_WIDTH + 6, BTN_HEIGHT + 6, COLOR_BG, drawPulse);
+
+  uiWidgetInit(recWidgets[REC_DOT], 25, 5, 11, 11, COLOR_BG, drawDot);
+  uiWidgetInit(recWidgets[REC_TIMER], width - TIMER_WIDTH, 0, TIMER_WIDTH, STATUS_BAR_HEIGHT, COLOR_BG, drawTimer);
+  int totalWidth = BAR_COUNT * (BAR_WIDTH + BAR_GAP) - BAR_GAP;
+  int startX = (width - totalWidth) / 2;
+  for (int i = 0; i < BAR_COUNT; i++) {
+    int barX = startX + i * (BAR_WIDTH + BAR_GAP);
+    uiWidgetInit(recWidgets[REC_BAR0 + i], barX, BAR_BASE_Y - BAR_MAX_HEIGHT, BAR_WIDTH, BAR_MAX_HEIGHT, COLOR_BG, drawBar);
+  }
+  widgetsReady = true;
+}
+
 // Display recording start UI
 void displayNoteUI(bool isRecording, unsigned long recordTime, IMUData imuData) {
   unsigned long currentTime = millis();
+  if (!widgetsReady) {
+    initWidgets();
+  }
   
   // 检测状态变化，需要完全重绘
   if (isRecording != prevIsRecording) {
@@ -34,6 +124,7 @@ void displayNoteUI(bool isRecording, unsigned long recordTime, IMUData imuData)
   if (!isRecording) {
     // 只在需要重绘时绘制静态元素
     if (noteUIRedrawNeeded) {
+      M5.Display.startWrite();
       // 清屏
       M5.Display.fillScreen(COLOR_BG);
       
@@ -57,19 +148,18 @@ void displayNoteUI(bool isRecording, unsigned long recordTime, IMUData imuData)
       // M5.Display.print(" MUSIC");
       
       // 绘制按钮
-      int btnWidth = 90;
-      int btnHeight = 30;
-      int btnX = (M5.Display.width() - btnWidth) / 2;
-      int btnY = 70;
-      M5.Display.fillRoundRect(btnX, btnY, btnWidth, btnHeight, 8, COLOR_PRIMARY);
+      int btnX = (M5.Display.width() - BTN_WIDTH) / 2;
+      M5.Display.fillRoundRect(btnX, BTN_START_Y, BTN_WIDTH, BTN_HEIGHT, 8, COLOR_PRIMARY);
       
       // 按钮文本
       M5.Display.setTextColor(COLOR_BG);
-      M5.Display.setCursor(btnX + 25, btnY + 10);
+      M5.Display.setCursor(btnX + 25, BTN_START_Y + 10);
       M5.Display.print("START");
+      M5.Display.endWrite();
       
       // 重置重绘标志
       noteUIRedrawNeeded = false;
+      uiWidgetInvalidate(idleWidgets, IDLE_WIDGET_COUNT);
       lastAnimationTime = currentTime - 200; // 确保动画立即更新
     }
     
@@ -78,37 +168,20 @@ void displayNoteUI(bool isRecording, unsigned long recordTime, IMUData imuData)
       // 更新动画帧
       animationFrame = (animationFrame + 1) % 12;
       
-      // 按钮脉冲效果
-      int btnWidth = 90;
-      int btnHeight = 30;
-      int btnX = (M5.Display.width() - btnWidth) / 2;
-      int btnY = 70;
-      
-      // 清除按钮边框区域
-      M5.Display.drawRoundRect(btnX - 3, btnY - 3, btnWidth + 6, btnHeight + 6, 10, COLOR_BG);
-      M5.Display.drawRoundRect(btnX - 2, btnY - 2, btnWidth + 4, btnHeight + 4, 9, COLOR_BG);
-      
-      // 绘制新的脉冲（使用主题色的不同亮度）
-      uint16_t pulseColor = (animationFrame % 2 == 0) ? COLOR_PRIMARY : COLOR_TEXT;
-      M5.Display.drawRoundRect(btnX - 2, btnY - 2, btnWidth + 4, btnHeight + 4, 10, pulseColor);
-      
-      // 清除波形区域
-      M5.Display.fillRect(0, 50, M5.Display.width(), 10, COLOR_BG);
-      
-      // 绘制动画波形
-      for (int i = 0; i < M5.Display.width(); i += 5) {
-        float offset = animationFrame * 0.5;
-        int waveHeight = 5 + 5 * sin(i * 0.1 + offset);
-        M5.Display.drawLine(i, 50, i, 50 + waveHeight, COLOR_PRIMARY);
-      }
+      // 按钮脉冲效果（使用主题色的不同亮度）
+      uiWidgetSet(idleWidgets[IDLE_PULSE], (animationFrame % 2 == 0) ? COLOR_PRIMARY : COLOR_TEXT);
+      // 动画波形
+      uiWidgetSet(idleWidgets[IDLE_WAVE], animationFrame);
       
       lastAnimationTime = currentTime;
     }
+    uiFlush(idleWidgets, IDLE_WIDGET_COUNT);
   }
   // 录制中界面
   else {
     // 绘制静态元素
     if (noteUIRedrawNeeded) {
+      M5.Display.startWrite();
       // 清屏
       M5.Display.fillScreen(COLOR_BG);
       
@@ -122,23 +195,23 @@ void displayNoteUI(bool isRecording, unsigned long recordTime, IMUData imuData)
       M5.Display.print("REC");
       
       // 绘制停止按钮
-      int btnWidth = 90;
-      int btnHeight = 30;
-      int btnX = (M5.Display.width() - btnWidth) / 2;
-      int btnY = 95;
-      M5.Display.fillRoundRect(btnX, btnY, btnWidth, btnHeight, 8, COLOR_ACCENT);
+      int btnX = (M5.Display.width() - BTN_WIDTH) / 2;
+      M5.Display.fillRoundRect(btnX, BTN_STOP_Y, BTN_WIDTH, BTN_HEIGHT, 8, COLOR_ACCENT);
       
       // 按钮文本
       M5.Display.setTextColor(COLOR_TEXT);
       M5.Display.setTextSize(1);
-      M5.Display.setCursor(btnX + 30, btnY + 10);
+      M5.Display.setCursor(btnX + 30, BTN_STOP_Y + 10);
       M5.Display.print("STOP");
+      M5.Display.endWrite();
       
       // 初始化闪烁状态
       blinkState = true;
       
       // 重置重绘标志
       noteUIRedrawNeeded = false;
+      uiWidgetInvalidate(recWidgets, REC_WIDGET_COUNT);
+      uiWidgetSet(recWidgets[REC_DOT], blinkState);
       lastAnimationTime = currentTime - 100; // 确保动画立即更新
       lastBlinkTime = currentTime;
     }
@@ -147,53 +220,20 @@ void displayNoteUI(bool isRecording, unsigned long recordTime, IMUData imuData)
     if (currentTime - lastBlinkTime > 800) {
       blinkState = !blinkState;
       
-      // 清除红点区域
-      M5.Display.fillCircle(30, 10, 5, COLOR_BG);
-      
-      // 绘制录制指示点
-      if (blinkState) {
-        M5.Display.fillCircle(30, 10, 5, COLOR_ACCENT);
-      }
+      // 录制指示点
+      uiWidgetSet(recWidgets[REC_DOT], blinkState);
       
       lastBlinkTime = currentTime;
     }
     
     // 更新录制时间（每秒更新一次）
     if (currentTime - lastAnimationTime > 100) {
-      // 更新录制时间显示
-      unsigned long seconds = recordTime / 1000;
-      unsigned long minutes = seconds / 60;
-      seconds = seconds % 60;
-      
-      // 清除时间区域
-      M5.Display.fillRect(M5.Display.width() - 45, 0, 45, STATUS_BAR_HEIGHT, COLOR_BG);
-      
-      // 绘制更新后的时间
-      M5.Display.setTextColor(COLOR_TEXT);
-      M5.Display.setTextSize(1);
-      M5.Display.setCursor(M5.Display.width() - 45, 6);
-      if (minutes < 10) M5.Display.print("0");
-      M5.Display.print(minutes);
-      M5.Display.print(":");
-      if (seconds < 10) M5.Display.print("0");
-      M5.Display.print(seconds);
+      // 更新录制时间显示，秒数变化时才重绘
+      uiWidgetSet(recWidgets[REC_TIMER], recordTime / 1000);
       
       // 更新动画帧
       animationFrame = (animationFrame + 1) % 12;
       
-      // 清除律动区域 - 下移到STOP按钮上方
-      int rhythmAreaTop = STATUS_BAR_HEIGHT + 5;
-      int rhythmAreaBottom = 90; // STOP按钮上方留一些空间
-      M5.Display.fillRect(0, rhythmAreaTop, M5.Display.width(), rhythmAreaBottom - rhythmAreaTop, COLOR_BG);
-      
-      // 使用IMU数据绘制律动条
-      int barCount = 12;
-      int barWidth = 8;
-      int barGap = 2;
-      int totalWidth = barCount * (barWidth + barGap) - barGap;
-      int startX = (M5.Display.width() - totalWidth) / 2;
-      int baseY = 70; // 调整基准Y坐标，使律动条在STOP按钮上方
-      
       // 将IMU数据映射到律动条高度
       float accMagnitude = sqrt(imuData.accX*imuData.accX + 
                                imuData.accY*imuData.accY + 
@@ -203,8 +243,8 @@ void displayNoteUI(bool isRecording, unsigned long recordTime, IMUData imuData)
                                 imuData.gyroY*imuData.gyroY + 
                                 imuData.gyroZ*imuData.gyroZ);
       
-      // 绘制律动条
-      for (int i = 0; i < barCount; i++) {
+      // 更新律动条，高度不变的不重绘
+      for (int i = 0; i < BAR_COUNT; i++) {
         // 使用不同的数据源计算高度
         float heightFactor = 0;
         
@@ -225,15 +265,14 @@ void displayNoteUI(bool isRecording, unsigned long recordTime, IMUData imuData)
         int barHeight = heightFactor + 5 * sin(phase);
         
         // 确保高度在合理范围内
-        barHeight = constrain(barHeight, 5, 40);
-        
-        // 绘制律动条
-        int barX = startX + i * (barWidth + barGap);
-        M5.Display.fillRect(barX, baseY - barHeight, barWidth, barHeight, COLOR_PRIMARY);
+        barHeight = constrain(barHeight, 5, BAR_MAX_HEIGHT);
+        uiWidgetSet(recWidgets[REC_BAR0 + i], barHeight);
       }
       
       lastAnimationTime = currentTime;
     }
+    // 所有变化一次刷新
+    uiFlush(recWidgets, REC_WIDGET_COUNT);
   }
 }
 
@@ -0,0 +1,323 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "imu/imu_trace.h"
+#include "imu/imu_fusion.h"
+#include "gesture/gesture.h"
+#include "tempo/tempo.h"
+#include "synth/synth.h"
+#include "note/note.h"
+#include "note/note_song.h"
+#include "note/beat_clock.h"
+
+// IMU轨迹回放 - 在主机上用录制的9轴数据重新跑一遍融合、手势检测和作曲
+// 时间完全由轨迹中的时间戳驱动，相同的轨迹和种子总是得到相同的输出
+//
+// 用法: program trace.bin [--seed N] [--bpm N|auto] [--note-period ms] [--song file.bin] [--wav out.wav] [--quiet]
+//   --seed         覆盖轨迹头部中的作曲随机种子
+//   --bpm          覆盖轨迹头部中的节拍速度，0为不用节拍时钟，auto为跟随检测到的舞蹈速度
+//                  不指定时与设备的默认一样从头部的速度开始跟随舞蹈速度，录制时设置了固定BPM的轨迹用 --bpm N 复现
+//   --note-period  不用节拍时钟时调用mapIMUToNote的周期
+//   --song         使用乐谱文件 (与设备上 /songs 中的文件相同) 代替内置舞曲
+//   --wav          用设备上的合成器把音符渲染成WAV文件 (16位单声道)
+//   --quiet        只输出最后的统计
+
+// 跟随舞蹈速度时更新节拍速度的间隔 (us)，与 TEMPO_FOLLOW_MS 相同
+#define TEMPO_FOLLOW_US 1000000ULL
+
+static void usage(const char* name) {
+  fprintf(stderr, "usage: %s trace.bin [--seed N] [--bpm N|auto] [--note-period ms] [--song file.bin] [--wav out.wav] [--quiet]\n", name);
+}
+
+// 读取整个文件
+static uint8_t* readFile(const char* path, size_t& size) {
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (length < 0) {
+    fclose(file);
+    return NULL;
+  }
+  uint8_t* data = (uint8_t*)malloc(length > 0 ? length : 1);
+  size = data ? fread(data, 1, length, file) : 0;
+  fclose(file);
+  return data;
+}
+
+// WAV输出: 先写占位的头部，结束时补上长度
+static FILE* wavFile = NULL;
+static Synth synth;
+static uint64_t wavFrames = 0;
+
+static void putLE(uint8_t* p, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    p[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static void writeWavHeader(FILE* file, uint32_t frames) {
+  uint8_t h[44];
+  uint32_t dataSize = frames * 2;
+  memcpy(h, "RIFF", 4);
+  putLE(h + 4, 36 + dataSize, 4);
+  memcpy(h + 8, "WAVEfmt ", 8);
+  putLE(h + 16, 16, 4);
+  putLE(h + 20, 1, 2);                      // PCM
+  putLE(h + 22, 1, 2);                      // 单声道
+  putLE(h + 24, SYNTH_SAMPLE_RATE, 4);
+  putLE(h + 28, SYNTH_SAMPLE_RATE * 2, 4);
+  putLE(h + 32, 2, 2);
+  putLE(h + 34, 16, 2);
+  memcpy(h + 36, "data", 4);
+  putLE(h + 40, dataSize, 4);
+  fseek(file, 0, SEEK_SET);
+  fwrite(h, 1, sizeof(h), file);
+}
+
+// 按合成块渲染到会话时间us (与设备上一样每次一块)
+static void renderWav(uint64_t us) {
+  static int16_t block[SYNTH_BLOCK_FRAMES];
+  uint64_t target = us * SYNTH_SAMPLE_RATE / 1000000;
+  while (wavFile != NULL && wavFrames + SYNTH_BLOCK_FRAMES <= target) {
+    synthRender(synth, block, SYNTH_BLOCK_FRAMES);
+    for (int i = 0; i < SYNTH_BLOCK_FRAMES; i++) {
+      uint8_t le[2] = {(uint8_t)block[i], (uint8_t)(block[i] >> 8)};
+      fwrite(le, 1, 2, wavFile);
+    }
+    wavFrames += SYNTH_BLOCK_FRAMES;
+  }
+}
+
+// 乐谱文件: 与设备上一样按步骤读取
+static const uint8_t* songData = NULL;
+static NoteSongHeader songHeader;
+
+static bool readSongStep(size_t index, NoteStep& step, NoteChord& chord) {
+  return noteSongDecodeStep(songData + noteSongStepOffset(songHeader, index), NOTE_SONG_STEP_SIZE, songHeader, step) &&
+         noteSongDecodeChord(songData + noteSongChordOffset(step.chord), NOTE_SONG_CHORD_SIZE, chord) &&
+         (step.pick == STEP_PICK_RANDOM || step.pick == STEP_PICK_NOTE || step.pick < chord.size);
+}
+
+int main(int argc, char** argv) {
+  const char* path = NULL;
+  const char* songPath = NULL;
+  const char* wavPath = NULL;
+  bool seedOverride = false;
+  uint32_t seed = 0;
+  bool tempoOverride = false;
+  uint16_t tempo = 0;
+  bool follow = false;
+  uint32_t notePeriodMs = NOTE_TASK_PERIOD_MS;
+  bool quiet = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 0);
+      seedOverride = true;
+    } else if (strcmp(argv[i], "--bpm") == 0 && i + 1 < argc) {
+      follow = strcmp(argv[++i], "auto") == 0;
+      tempo = follow ? BEAT_CLOCK_DEFAULT_BPM : strtoul(argv[i], NULL, 0);
+      tempoOverride = true;
+    } else if (strcmp(argv[i], "--note-period") == 0 && i + 1 < argc) {
+      notePeriodMs = strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--song") == 0 && i + 1 < argc) {
+      songPath = argv[++i];
+    } else if (strcmp(argv[i], "--wav") == 0 && i + 1 < argc) {
+      wavPath = argv[++i];
+    } else if (strcmp(argv[i], "--quiet") == 0) {
+      quiet = true;
+    } else if (argv[i][0] != '-' && path == NULL) {
+      path = argv[i];
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (path == NULL || notePeriodMs == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  size_t size = 0;
+  uint8_t* data = readFile(path, size);
+  if (data == NULL) {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 1;
+  }
+
+  IMUTraceHeader header;
+  if (!imuTraceDecodeHeader(data, size, header)) {
+    fprintf(stderr, "%s: not an IMU trace (version %d)\n", path, IMU_TRACE_VERSION);
+    free(data);
+    return 1;
+  }
+  if (!seedOverride) {
+    seed = header.seed;
+  }
+  if (!tempoOverride) {
+    tempo = header.tempo;
+    follow = tempo != 0;
+  }
+  if (tempo != 0) {
+    tempo = constrain(tempo, BEAT_CLOCK_MIN_BPM, BEAT_CLOCK_MAX_BPM);
+  }
+  size_t sampleCount = (size - IMU_TRACE_HEADER_SIZE) / IMU_TRACE_SAMPLE_SIZE;
+  if (!quiet) {
+    printf("# %s: %u samples @ %u Hz, %s gain %.3f, seed %u, %u bpm\n", path, (unsigned)sampleCount,
+           header.sampleRate, header.algorithm == FUSION_MAHONY ? "mahony" : "madgwick",
+           header.gain, seed, tempo);
+  }
+
+  NoteScore songScore = {NULL, NULL, 0, 0, readSongStep};
+  uint8_t* song = NULL;
+  if (songPath != NULL) {
+    size_t songSize = 0;
+    song = readFile(songPath, songSize);
+    if (song == NULL || !noteSongDecodeHeader(song, songSize, songHeader) ||
+        songSize < NOTE_SONG_SIZE(songHeader.chordCount, songHeader.stepCount)) {
+      fprintf(stderr, "%s: not a song file (version %d)\n", songPath, NOTE_SONG_VERSION);
+      free(song);
+      free(data);
+      return 1;
+    }
+    songData = song;
+    songScore.chordCount = songHeader.chordCount;
+    songScore.length = songHeader.stepCount;
+    setNoteScore(&songScore);
+  }
+
+  if (wavPath != NULL) {
+    wavFile = fopen(wavPath, "wb");
+    if (wavFile == NULL) {
+      fprintf(stderr, "cannot write %s\n", wavPath);
+      free(song);
+      free(data);
+      return 1;
+    }
+    writeWavHeader(wavFile, 0);
+    synthInit(synth);
+  }
+
+  FusionState fusion;
+  fusionInit(fusion, header.algorithm, header.gain);
+  GestureDetector detector;
+  gestureInit(detector);
+  GestureEvent events[4];
+  static TempoTracker tracker;
+  tempoInit(tracker);
+  resetNoteComposer(seed);
+  nativeSetMicros(0);
+
+  auto wallStart = std::chrono::steady_clock::now();
+
+  // 会话时间 (us)，从第一个样本开始，时间戳回绕时按无符号差值累加
+  // 有节拍时钟时第一个音符在0时刻，之后在上一个音符的时值结束时
+  uint64_t sessionUs = 0;
+  uint32_t noteTick = 0;
+  uint64_t noteOriginUs = 0;
+  uint64_t lastFollowUs = 0;
+  uint64_t nextNoteUs = tempo ? 0 : notePeriodMs * 1000ULL;
+  uint32_t lastTimestamp = 0;
+  size_t noteCount = 0;
+  size_t gestureCount = 0;
+  IMUSample sample;
+  const uint8_t* p = data + IMU_TRACE_HEADER_SIZE;
+
+  for (size_t i = 0; i < sampleCount; i++, p += IMU_TRACE_SAMPLE_SIZE) {
+    imuTraceDecodeSample(p, IMU_TRACE_SAMPLE_SIZE, sample);
+    uint32_t delta = (i == 0) ? 0 : sample.timestamp - lastTimestamp;
+    lastTimestamp = sample.timestamp;
+    sessionUs += delta;
+    nativeAdvanceMicros(delta);
+
+    // 与设备上的 fuseIMUData 相同
+    IMUData& d = sample.data;
+    float dt = (i == 0 && header.sampleRate > 0) ? 1.0f / header.sampleRate : delta * 1e-6f;
+    fusionUpdate(fusion, d.gyroX, d.gyroY, d.gyroZ, d.accX, d.accY, d.accZ,
+                 d.magX, d.magY, d.magZ, dt);
+    d.qw = fusion.q0;
+    d.qx = fusion.q1;
+    d.qy = fusion.q2;
+    d.qz = fusion.q3;
+    fusionGetEuler(fusion, d.roll, d.pitch, d.yaw);
+
+    size_t eventCount = gestureUpdate(detector, sample, events, 4);
+    for (size_t j = 0; j < eventCount; j++) {
+      if (!quiet) {
+        printf("%llu gesture %s\n", (unsigned long long)(sessionUs / 1000), gestureName(events[j].type));
+      }
+    }
+    gestureCount += eventCount;
+
+    // 与设备上的 TempoTask 相同: 跟随时每秒把可信的估计设为节拍速度
+    // 速度改变时从下一个音符的拍点重新计时 (设备上从下一个细分拍生效，只差一个音符内的几拍)
+    tempoUpdate(tracker, sample);
+    uint16_t danceTempo = tempoBPM(tracker);
+    if (follow && danceTempo != 0 && sessionUs - lastFollowUs >= TEMPO_FOLLOW_US) {
+      lastFollowUs = sessionUs;
+      danceTempo = constrain(danceTempo, BEAT_CLOCK_MIN_BPM, BEAT_CLOCK_MAX_BPM);
+      if (danceTempo != tempo) {
+        noteOriginUs = nextNoteUs;
+        noteTick = 0;
+        tempo = danceTempo;
+        if (!quiet) {
+          printf("%llu tempo %u\n", (unsigned long long)(sessionUs / 1000), tempo);
+        }
+      }
+    }
+
+    // 音符任务在拍点 (或按固定周期) 读取最新的样本，与设备上的录制任务相同
+    while (sessionUs >= nextNoteUs) {
+      NoteEvent event;
+      uint64_t noteUs = nextNoteUs;
+      bool made;
+      if (tempo) {
+        made = composeNote(d, event);
+        uint32_t ticks = made ? beatClockTicks(event.duration) : 1;
+        event.duration = beatClockTicksToMs(ticks, tempo);
+        noteTick += ticks;
+        nextNoteUs = noteOriginUs + beatClockTickTime(noteTick, tempo);
+      } else {
+        made = mapIMUToNote(d, event);
+        nextNoteUs += notePeriodMs * 1000ULL;
+      }
+      if (made) {
+        // 设备上音符在拍点交给合成器，下一块开始发声
+        renderWav(noteUs);
+        synthNoteOn(synth, event.note, event.duration);
+        if (!quiet) {
+          printf("%llu note %u %u\n", (unsigned long long)(noteUs / 1000), event.note, event.duration);
+        }
+        noteCount++;
+      }
+    }
+  }
+
+  // 渲染到会话结束，再等最后的音符释放完
+  renderWav(sessionUs);
+  while (wavFile != NULL && synthActive(synth)) {
+    renderWav((wavFrames + SYNTH_BLOCK_FRAMES) * 1000000ULL / SYNTH_SAMPLE_RATE);
+  }
+
+  double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+  double sessionMs = sessionUs / 1000.0;
+  printf("# samples %u, session %.1f ms, notes %u, gestures %u, dance %u bpm (%.2f), replay %.2f ms (%.0fx)\n",
+         (unsigned)sampleCount, sessionMs, (unsigned)noteCount, (unsigned)gestureCount,
+         tempoBPM(tracker), tracker.confidence,
+         wallMs, wallMs > 0 ? sessionMs / wallMs : 0.0);
+
+  if (wavFile != NULL) {
+    writeWavHeader(wavFile, (uint32_t)wavFrames);
+    fclose(wavFile);
+    printf("# %s: %.1f s @ %d Hz\n", wavPath, (double)wavFrames / SYNTH_SAMPLE_RATE, SYNTH_SAMPLE_RATE);
+  }
+  free(song);
+  free(data);
+  return 0;
+}
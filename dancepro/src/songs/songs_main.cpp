@@ -0,0 +1,140 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "note/note.h"
+#include "note/note_song.h"
+
+// 乐谱文件生成工具 - 把歌曲模板展开并写成 /songs/<名称>.bin
+//
+// 用法: program <目录>       写出全部模板，再用 pio run -t uploadfs 上传
+//       program --dump 文件  打印乐谱文件中的步骤
+
+// ===== 小调流行: 主歌(8) 副歌(8)，用到升号和2-3八度的低音 =====
+enum MinorChordId : uint8_t { MINOR_EM, MINOR_C, MINOR_G, MINOR_D, MINOR_B7, MINOR_CHORD_COUNT };
+
+static const NoteChord MINOR_CHORDS[MINOR_CHORD_COUNT] = {
+    {{NOTE_E3, NOTE_G3, NOTE_B3, NOTE_E4, NOTE_G4}, 5},    // Em
+    {{NOTE_C3, NOTE_E3, NOTE_G3, NOTE_C4, NOTE_E4}, 5},    // C
+    {{NOTE_G2, NOTE_B2, NOTE_D3, NOTE_G3, NOTE_B3}, 5},    // G
+    {{NOTE_D3, NOTE_FS3, NOTE_A3, NOTE_D4, NOTE_FS4}, 5},  // D
+    {{NOTE_B2, NOTE_DS3, NOTE_FS3, NOTE_A3, NOTE_B3}, 5}   // B7，回到Em的属七和弦
+};
+
+static const NoteMeasure MINOR_VERSE[] = {
+    {MINOR_EM, RHYTHM_ACCENTED, VOICING_CYCLE4, 0},
+    {MINOR_C, RHYTHM_BASIC, VOICING_CYCLE4, 0},
+    {MINOR_G, RHYTHM_BASIC, VOICING_CYCLE4, 0},
+    {MINOR_D, RHYTHM_SYNCOPATION, VOICING_CYCLE4, 0},
+    {MINOR_EM, RHYTHM_BASIC, VOICING_CYCLE4, MEASURE_ACCENT},
+    {MINOR_C, RHYTHM_BASIC, VOICING_CYCLE4, 0},
+    {MINOR_G, RHYTHM_SYNCOPATION, VOICING_CYCLE4, 0},
+    {MINOR_B7, RHYTHM_SECTION_END, VOICING_CYCLE4, MEASURE_REST}
+};
+
+static const NoteMeasure MINOR_CHORUS[] = {
+    {MINOR_C, RHYTHM_ACCENTED, VOICING_ROOT_HIGH, 0},
+    {MINOR_G, RHYTHM_SYNCOPATION, VOICING_ROOT_HIGH, MEASURE_HIGH_OFFBEAT},
+    {MINOR_D, RHYTHM_BASIC, VOICING_ROOT_HIGH, 0},
+    {MINOR_EM, RHYTHM_TRIPLET, VOICING_ROOT_HIGH, MEASURE_HIGH_TAIL},
+    {MINOR_C, RHYTHM_BASIC, VOICING_ROOT_FIRST, 0},
+    {MINOR_G, RHYTHM_BASIC, VOICING_ROOT_FIRST, 0},
+    {MINOR_B7, RHYTHM_BASIC, VOICING_ASCEND, MEASURE_HOLD_END},
+    {MINOR_EM, RHYTHM_ENDING, VOICING_ASCEND, 0}
+};
+
+static const NoteSection MINOR_SECTIONS[] = {
+    {MINOR_VERSE, 8, SECTION_REPEAT_MID},
+    {MINOR_CHORUS, 8, SECTION_REPEAT_MID | SECTION_REPEAT_HIGH | SECTION_SLOW_STRETCH}
+};
+
+static const NoteSong MINOR_SONG = {MINOR_CHORDS, MINOR_CHORD_COUNT, MINOR_SECTIONS, 2};
+
+#define MAX_STEPS 1024
+
+// 写出一个乐谱文件
+static bool writeSong(const char* dir, const char* name, const NoteScore& score) {
+    static uint8_t buf[NOTE_SONG_SIZE(255, MAX_STEPS)];
+    size_t size = noteSongEncode(score, buf, sizeof(buf));
+    if (size == 0) {
+        fprintf(stderr, "%s: encode failed\n", name);
+        return false;
+    }
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.bin", dir, name);
+    FILE* file = fopen(path, "wb");
+    if (file == NULL || fwrite(buf, 1, size, file) != size) {
+        fprintf(stderr, "cannot write %s\n", path);
+        if (file != NULL) {
+            fclose(file);
+        }
+        return false;
+    }
+    fclose(file);
+    printf("%s: %u steps, %u chords, %u bytes\n", path, (unsigned)score.length, score.chordCount, (unsigned)size);
+    return true;
+}
+
+// 写出一个歌曲模板
+static bool writeTemplate(const char* dir, const char* name, const NoteSong& song) {
+    static NoteStep steps[MAX_STEPS];
+    NoteScore score = {steps, song.chords, song.chordCount, noteSongExpand(song, steps, MAX_STEPS), NULL};
+    if (score.length == 0) {
+        fprintf(stderr, "%s: more than %d steps\n", name, MAX_STEPS);
+        return false;
+    }
+    return writeSong(dir, name, score);
+}
+
+// 打印乐谱文件
+static int dumpSong(const char* path) {
+    static uint8_t buf[NOTE_SONG_SIZE(255, 0xFFFF)];
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+    size_t size = fread(buf, 1, sizeof(buf), file);
+    fclose(file);
+
+    NoteSongHeader header;
+    if (!noteSongDecodeHeader(buf, size, header) || size < NOTE_SONG_SIZE(header.chordCount, header.stepCount)) {
+        fprintf(stderr, "%s: not a song file (version %d)\n", path, NOTE_SONG_VERSION);
+        return 1;
+    }
+    printf("# %u chords, %u steps\n", header.chordCount, header.stepCount);
+    for (uint8_t i = 0; i < header.chordCount; i++) {
+        NoteChord chord;
+        if (!noteSongDecodeChord(buf + noteSongChordOffset(i), NOTE_SONG_CHORD_SIZE, chord)) {
+            fprintf(stderr, "chord %u invalid\n", i);
+            return 1;
+        }
+        printf("chord %u:", i);
+        for (uint8_t t = 0; t < chord.size; t++) {
+            printf(" %u", chord.tones[t]);
+        }
+        printf("\n");
+    }
+    for (size_t i = 0; i < header.stepCount; i++) {
+        NoteStep step;
+        if (!noteSongDecodeStep(buf + noteSongStepOffset(header, i), NOTE_SONG_STEP_SIZE, header, step)) {
+            fprintf(stderr, "step %u invalid\n", (unsigned)i);
+            return 1;
+        }
+        printf("step %u: chord %u pick %u note %u duration %u flags 0x%02x\n", (unsigned)i,
+               step.chord, step.pick, step.note, step.duration, step.flags);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "--dump") == 0) {
+        return dumpSong(argv[2]);
+    }
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <dir> | --dump file.bin\n", argv[0]);
+        return 2;
+    }
+    bool ok = writeSong(argv[1], "dance", DANCE_SCORE);
+    ok = writeTemplate(argv[1], "minor", MINOR_SONG) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include "synth/synth.h"
+#include <math.h>
+#include <string.h>
+
+// 波表: 基音加少量2、3次谐波，比正弦波明亮，又不像方波刺耳
+static int16_t synthTable[SYNTH_TABLE_SIZE + 1];
+static bool tableReady = false;
+
+static void makeTable() {
+  if (tableReady) {
+    return;
+  }
+  for (int i = 0; i < SYNTH_TABLE_SIZE; i++) {
+    float x = 2.0f * (float)M_PI * i / SYNTH_TABLE_SIZE;
+    float v = sinf(x) + 0.35f * sinf(2 * x) + 0.15f * sinf(3 * x);
+    synthTable[i] = (int16_t)(v / 1.5f * 32767);
+  }
+  // 多存一个点，插值时不用回绕
+  synthTable[SYNTH_TABLE_SIZE] = synthTable[0];
+  tableReady = true;
+}
+
+// ms 换算成每个样本的电平变化，至少1个样本
+static int32_t envelopeStep(uint32_t sampleRate, uint16_t ms, int32_t range) {
+  uint32_t samples = (uint32_t)((uint64_t)sampleRate * ms / 1000);
+  return range / (int32_t)(samples > 0 ? samples : 1);
+}
+
+// 初始化合成器
+void synthInit(Synth& synth, uint32_t sampleRate) {
+  makeTable();
+  memset(&synth, 0, sizeof(synth));
+  synth.sampleRate = sampleRate;
+  synth.volume = 255;
+  synthSetEnvelope(synth, SYNTH_DEFAULT_ATTACK_MS, SYNTH_DEFAULT_DECAY_MS,
+                   SYNTH_DEFAULT_SUSTAIN, SYNTH_DEFAULT_RELEASE_MS);
+}
+
+// 设置包络
+void synthSetEnvelope(Synth& synth, uint16_t attackMs, uint16_t decayMs, uint8_t sustain, uint16_t releaseMs) {
+  SynthEnvelope& env = synth.envelope;
+  env.sustainLevel = (int32_t)((int64_t)SYNTH_LEVEL_MAX * sustain / 255);
+  env.attackStep = envelopeStep(synth.sampleRate, attackMs, SYNTH_LEVEL_MAX);
+  env.decayStep = envelopeStep(synth.sampleRate, decayMs, SYNTH_LEVEL_MAX - env.sustainLevel);
+  env.releaseStep = envelopeStep(synth.sampleRate, releaseMs, SYNTH_LEVEL_MAX);
+  if (env.decayStep == 0) {
+    env.decayStep = 1;
+  }
+}
+
+// 开始一个音符
+void synthNoteOn(Synth& synth, uint16_t freq, uint32_t durationMs) {
+  if (freq == 0 || freq >= synth.sampleRate / 2) {
+    return;
+  }
+  // 优先用空闲的音，否则抢占最早的音 (从当前电平重新起音，不会有爆音)
+  SynthVoice* voice = &synth.voices[0];
+  for (int i = 0; i < SYNTH_VOICES; i++) {
+    SynthVoice& v = synth.voices[i];
+    if (v.stage == SYNTH_OFF) {
+      voice = &v;
+      break;
+    }
+    if ((int32_t)(v.age - voice->age) < 0) {
+      voice = &v;
+    }
+  }
+  if (voice->stage == SYNTH_OFF) {
+    voice->phase = 0;
+    voice->level = 0;
+  }
+  voice->step = (uint32_t)(((uint64_t)freq << 32) / synth.sampleRate);
+  voice->gate = (uint32_t)((uint64_t)synth.sampleRate * durationMs / 1000);
+  voice->age = synth.noteCount++;
+  voice->stage = SYNTH_ATTACK;
+}
+
+// 推进一个音的包络
+static inline void advanceEnvelope(const SynthEnvelope& env, SynthVoice& v) {
+  switch (v.stage) {
+    case SYNTH_ATTACK:
+      v.level += env.attackStep;
+      if (v.level >= SYNTH_LEVEL_MAX) {
+        v.level = SYNTH_LEVEL_MAX;
+        v.stage = SYNTH_DECAY;
+      }
+      break;
+    case SYNTH_DECAY:
+      v.level -= env.decayStep;
+      if (v.level <= env.sustainLevel) {
+        v.level = env.sustainLevel;
+        v.stage = SYNTH_SUSTAIN;
+      }
+      break;
+    case SYNTH_RELEASE:
+      v.level -= env.releaseStep;
+      if (v.level <= 0) {
+        v.level = 0;
+        v.stage = SYNTH_OFF;
+      }
+      return;
+    default:
+      break;
+  }
+  if (v.gate > 0 && --v.gate == 0) {
+    v.stage = SYNTH_RELEASE;
+  }
+}
+
+// 渲染frames个样本
+void synthRender(Synth& synth, int16_t* out, size_t frames) {
+  memset(out, 0, frames * sizeof(int16_t));
+  // 多个音叠加时每个音只用一半幅度，再按主音量缩放并限幅
+  int32_t gain = synth.volume;
+  for (int i = 0; i < SYNTH_VOICES; i++) {
+    SynthVoice& v = synth.voices[i];
+    if (v.stage == SYNTH_OFF) {
+      continue;
+    }
+    for (size_t n = 0; n < frames && v.stage != SYNTH_OFF; n++) {
+      uint32_t index = v.phase >> (32 - SYNTH_TABLE_BITS);
+      int32_t frac = (v.phase >> (16 - SYNTH_TABLE_BITS)) & 0xFFFF;
+      int32_t a = synthTable[index];
+      int32_t b = synthTable[index + 1];
+      int32_t wave = a + (((b - a) * frac) >> 16);
+      int32_t sample = (int32_t)(((int64_t)wave * (v.level >> 14)) >> 17);
+      int32_t mixed = out[n] + ((sample * gain) >> 8);
+      out[n] = (int16_t)(mixed > 32767 ? 32767 : (mixed < -32768 ? -32768 : mixed));
+      v.phase += v.step;
+      advanceEnvelope(synth.envelope, v);
+    }
+  }
+}
+
+// 是否还有音在发声
+bool synthActive(const Synth& synth) {
+  for (int i = 0; i < SYNTH_VOICES; i++) {
+    if (synth.voices[i].stage != SYNTH_OFF) {
+      return true;
+    }
+  }
+  return false;
+}
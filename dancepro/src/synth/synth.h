@@ -0,0 +1,81 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 音色合成 - 波表振荡器加ADSR包络，把音符渲染成16位单声道PCM
+// 全部用定点运算，每个样本的计算量固定，不依赖硬件，可以在主机上渲染成WAV
+
+// 采样率 (Hz)
+#define SYNTH_SAMPLE_RATE  16000
+// 每块的样本数，一块 4ms
+#define SYNTH_BLOCK_FRAMES 64
+// 同时发声的音数，新音符抢占最早的音
+#define SYNTH_VOICES       4
+
+// 波表长度 (2的幂)，相位的高位是表索引，其余位做线性插值
+#define SYNTH_TABLE_BITS   8
+#define SYNTH_TABLE_SIZE   (1 << SYNTH_TABLE_BITS)
+
+// 包络电平满幅 (Q30)
+#define SYNTH_LEVEL_MAX    (1L << 30)
+
+// 默认包络 (ms，持续电平为 0-255)
+#define SYNTH_DEFAULT_ATTACK_MS  5
+#define SYNTH_DEFAULT_DECAY_MS   80
+#define SYNTH_DEFAULT_SUSTAIN    160
+#define SYNTH_DEFAULT_RELEASE_MS 120
+
+// 包络阶段
+enum SynthStage : uint8_t {
+  SYNTH_OFF,
+  SYNTH_ATTACK,
+  SYNTH_DECAY,
+  SYNTH_SUSTAIN,
+  SYNTH_RELEASE
+};
+
+// 包络参数 (换算成每个样本的电平变化)
+struct SynthEnvelope {
+  int32_t attackStep;
+  int32_t decayStep;
+  int32_t sustainLevel;
+  int32_t releaseStep;
+};
+
+// 一个音
+struct SynthVoice {
+  uint32_t phase;      // 波表相位 (Q32)
+  uint32_t step;       // 每个样本的相位增量
+  int32_t level;       // 包络电平 (Q30)
+  uint32_t gate;       // 距离松开还有多少个样本
+  uint32_t age;        // 发声的先后，用于抢占
+  SynthStage stage;
+};
+
+// 合成器状态
+struct Synth {
+  uint32_t sampleRate;
+  SynthEnvelope envelope;
+  SynthVoice voices[SYNTH_VOICES];
+  uint32_t noteCount;
+  uint8_t volume;      // 主音量 (0-255)
+};
+
+// 初始化合成器，使用默认包络
+void synthInit(Synth& synth, uint32_t sampleRate = SYNTH_SAMPLE_RATE);
+
+// 设置包络，之后的音符生效
+void synthSetEnvelope(Synth& synth, uint16_t attackMs, uint16_t decayMs, uint8_t sustain, uint16_t releaseMs);
+
+// 开始一个音符 (频率Hz，时值ms)，时值结束后进入释放阶段，频率为0 (休止符) 时不发声
+void synthNoteOn(Synth& synth, uint16_t freq, uint32_t durationMs);
+
+// 渲染frames个样本
+void synthRender(Synth& synth, int16_t* out, size_t frames);
+
+// 是否还有音在发声
+bool synthActive(const Synth& synth);
+
+#endif
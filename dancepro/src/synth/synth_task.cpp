@@ -0,0 +1,138 @@
+#include "synth/synth_task.h"
+#include <M5Unified.h>
+#include <atomic>
+#include <esp_timer.h>
+#include "tasks/task_plan.h"
+#include "trace/trace.h"
+
+// 队列中的音符，带入队时间用于统计延迟
+struct SynthNote
+{
+  uint16_t freq;
+  uint16_t duration;
+  int64_t time;
+};
+
+static QueueHandle_t synthQueue = NULL;
+static TaskHandle_t synthTaskHandle = NULL;
+static std::atomic<bool> synthMute(false);
+static std::atomic<uint8_t> synthVolume(255);
+static std::atomic<uint32_t> maxLatency(0);
+
+// 两个合成块轮流使用: 一块在播放时渲染另一块
+static int16_t blocks[2][SYNTH_BLOCK_FRAMES];
+
+// 合成任务: 有音在发声时连续渲染，否则阻塞等待音符
+static void synthTask(void *pvParameters)
+{
+  static Synth synth;
+  synthInit(synth);
+  int current = 0;
+  for (;;)
+  {
+    SynthNote note;
+    TickType_t wait = synthActive(synth) ? 0 : portMAX_DELAY;
+    while (xQueueReceive(synthQueue, &note, wait) == pdTRUE)
+    {
+      wait = 0;
+      if (synthMute)
+      {
+        continue;
+      }
+      synthNoteOn(synth, note.freq, note.duration);
+      uint32_t latency = (uint32_t)(esp_timer_get_time() - note.time);
+      if (latency > maxLatency)
+      {
+        maxLatency = latency;
+      }
+    }
+    if (!synthActive(synth))
+    {
+      continue;
+    }
+    synth.volume = synthVolume;
+
+    // 等待上一块开始播放 (通道中最多一块在播放、一块在排队)，再渲染这一块
+    while (M5.Speaker.isPlaying(SYNTH_CHANNEL) > 1)
+    {
+      vTaskDelay(1);
+    }
+    TRACE_BEGIN(TRACE_SYNTH_BLOCK);
+    synthRender(synth, blocks[current], SYNTH_BLOCK_FRAMES);
+    TRACE_END(TRACE_SYNTH_BLOCK);
+    M5.Speaker.playRaw(blocks[current], SYNTH_BLOCK_FRAMES, SYNTH_SAMPLE_RATE, false, 1, SYNTH_CHANNEL, false);
+    current ^= 1;
+  }
+}
+
+// 初始化扬声器并启动合成任务
+bool startSynthTask()
+{
+  if (synthTaskHandle != NULL)
+  {
+    return true;
+  }
+  // DMA缓冲区与合成块一样小，保证从入队到发声在20ms以内
+  auto config = M5.Speaker.config();
+  config.sample_rate = SYNTH_SAMPLE_RATE;
+  config.stereo = false;
+  config.dma_buf_len = SYNTH_DMA_BUF_LEN;
+  config.dma_buf_count = SYNTH_DMA_BUF_COUNT;
+  // I2S写入任务与合成任务同核同优先级
+  config.task_priority = TASK_PLAN[TASK_SYNTH].priority;
+  config.task_pinned_core = TASK_PLAN[TASK_SYNTH].core;
+  M5.Speaker.config(config);
+  if (!M5.Speaker.begin())
+  {
+    M5.Log.println("[Synth] 没有找到扬声器 (Atomic Echo Base)");
+    return false;
+  }
+  M5.Speaker.setVolume(160);
+
+  if (synthQueue == NULL)
+  {
+    synthQueue = xQueueCreate(SYNTH_QUEUE_LENGTH, sizeof(SynthNote));
+    if (synthQueue == NULL)
+    {
+      M5.Log.println("[Synth] 音符队列创建失败");
+      return false;
+    }
+  }
+  if (!createPlannedTask(TASK_SYNTH, synthTask, NULL, &synthTaskHandle))
+  {
+    M5.Log.println("[Synth] 合成任务创建失败");
+    synthTaskHandle = NULL;
+    return false;
+  }
+  M5.Log.printf("[Synth] 合成任务启动，%d Hz，缓冲延迟 %u us\n", SYNTH_SAMPLE_RATE, (unsigned)SYNTH_BUFFER_LATENCY_US);
+  return true;
+}
+
+// 播放一个音符
+bool playSynthNote(const NoteEvent &event)
+{
+  if (synthQueue == NULL || event.note == 0)
+  {
+    return false;
+  }
+  SynthNote note = {event.note, event.duration, esp_timer_get_time()};
+  return xQueueSend(synthQueue, &note, 0) == pdPASS;
+}
+
+// 静音/取消静音
+void setSynthMute(bool mute)
+{
+  synthMute = mute;
+}
+
+// 音量
+void setSynthVolume(uint8_t volume)
+{
+  synthVolume = volume;
+}
+
+// 最大延迟
+uint32_t getSynthMaxLatency()
+{
+  return maxLatency;
+}
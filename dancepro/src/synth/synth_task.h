@@ -0,0 +1,35 @@
+#ifndef SYNTH_TASK_H
+#define SYNTH_TASK_H
+
+#include <Arduino.h>
+#include "note/note_log.h"
+#include "synth/synth.h"
+
+// 合成器使用的扬声器通道
+#define SYNTH_CHANNEL      0
+// 音符队列长度
+#define SYNTH_QUEUE_LENGTH 8
+// 扬声器的DMA缓冲区 (与合成块一样大，两个轮流使用)
+#define SYNTH_DMA_BUF_LEN   SYNTH_BLOCK_FRAMES
+#define SYNTH_DMA_BUF_COUNT 2
+
+// 初始化扬声器 (Atomic Echo Base) 并启动合成任务，没有扬声器时返回false
+bool startSynthTask();
+
+// 播放一个音符，立即返回，队列满时丢弃
+bool playSynthNote(const NoteEvent& event);
+
+// 静音/取消静音
+void setSynthMute(bool mute);
+
+// 音量 (0-255)
+void setSynthVolume(uint8_t volume);
+
+// 从音符入队到开始渲染的最大延迟 (us)，加上缓冲区的固定延迟即为听到声音的延迟
+uint32_t getSynthMaxLatency();
+
+// 缓冲区的固定延迟 (us): 两个合成块加两个DMA缓冲区
+#define SYNTH_BUFFER_LATENCY_US \
+  ((2 * SYNTH_BLOCK_FRAMES + SYNTH_DMA_BUF_COUNT * SYNTH_DMA_BUF_LEN) * 1000000ULL / SYNTH_SAMPLE_RATE)
+
+#endif
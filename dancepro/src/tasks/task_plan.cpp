@@ -0,0 +1,69 @@
+#include "tasks/task_plan.h"
+
+// 任务布局表
+// 优先级: 采样 > 发声 > 作曲 > 手势/按键 > 其他；栈大小可以根据 /api/metrics 中的栈余量调整
+const TaskPlan TASK_PLAN[TASK_PLAN_COUNT] = {
+    {"IMUSampler", TASK_CORE_REALTIME, 5, 4096},   // 按采样周期读取IMU
+    {"SynthTask", TASK_CORE_REALTIME, 4, 4096},    // 渲染音频块，来不及会断音
+    {"Recorder", TASK_CORE_REALTIME, 3, 8192},     // 常驻录制任务，拍点到达后尽快作曲
+    {"GestureTask", TASK_CORE_REALTIME, 2, 4096},  // 手势检测
+    {"ButtonTask", TASK_CORE_REALTIME, 2, 8192},   // 按键和录制控制
+    {"TempoTask", TASK_CORE_REALTIME, 1, 4096},    // 舞蹈速度检测
+    {"IMUTask", TASK_CORE_REALTIME, 1, 4096},      // 手势切换页面
+    {"UITask", TASK_CORE_NETWORK, 1, 4096},        // 屏幕绘制，SPI传输时间长，不占用实时核心
+    {"WifiTask", TASK_CORE_NETWORK, 1, 4096},      // WiFi连接和重连
+    {"HttpTask", TASK_CORE_NETWORK, 1, 4096},      // WebSocket推送
+    {"IMUTrace", TASK_CORE_NETWORK, 1, 4096},      // 轨迹写入flash (写入时会暂停缓存)
+    {"SessionWriter", TASK_CORE_NETWORK, 1, 4096}, // 录制会话成批写入flash
+    {"StartTask", TASK_CORE_NETWORK, 1, 4096},     // 启动其他任务后退出
+};
+
+// 按布局表创建任务
+bool createPlannedTask(TaskPlanId id, TaskFunction_t function, void *arg, TaskHandle_t *handle)
+{
+  const TaskPlan &plan = TASK_PLAN[id];
+  BaseType_t core = (plan.core < 0) ? tskNO_AFFINITY : plan.core;
+  if (xTaskCreatePinnedToCore(function, plan.name, plan.stack, arg, plan.priority, handle, core) != pdPASS)
+  {
+    if (handle != NULL)
+    {
+      *handle = NULL;
+    }
+    return false;
+  }
+  return true;
+}
+
+
+// 取任务快照: 数组放不下时uxTaskGetSystemState返回0，按新的任务数重新分配再试一次
+bool takeTaskSnapshot(TaskSnapshot &snapshot)
+{
+  snapshot = {NULL, 0, 0, false};
+#if configUSE_TRACE_FACILITY
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + TASK_SNAPSHOT_HEADROOM;
+    snapshot.tasks = (TaskStatus_t *)malloc(capacity * sizeof(TaskStatus_t));
+    if (snapshot.tasks == NULL)
+    {
+      break;
+    }
+    snapshot.count = uxTaskGetSystemState(snapshot.tasks, capacity, &snapshot.totalRunTime);
+    if (snapshot.count > 0)
+    {
+      return true;
+    }
+    free(snapshot.tasks);
+    snapshot.tasks = NULL;
+  }
+  snapshot.truncated = true;
+#endif
+  return false;
+}
+
+// 释放任务快照
+void freeTaskSnapshot(TaskSnapshot &snapshot)
+{
+  free(snapshot.tasks);
+  snapshot = {NULL, 0, 0, false};
+}
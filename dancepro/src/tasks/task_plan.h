@@ -0,0 +1,64 @@
+#ifndef TASK_PLAN_H
+#define TASK_PLAN_H
+
+#include <Arduino.h>
+
+// 任务布局 - 所有任务的名称、核心、优先级和栈大小集中在一张表中 (task_plan.cpp)
+// 核心0运行WiFi/lwIP、AsyncTCP、esp_timer和其他慢速任务，核心1留给传感器和音频，
+// 网络繁忙时IMU采样和作曲不会被抢占
+
+// 网络核心和实时核心
+#define TASK_CORE_NETWORK 0
+#define TASK_CORE_REALTIME 1
+
+// 任务编号 (TASK_PLAN 的索引)
+enum TaskPlanId
+{
+  TASK_IMU_SAMPLER,
+  TASK_SYNTH,
+  TASK_RECORDER,
+  TASK_GESTURE,
+  TASK_BUTTON,
+  TASK_TEMPO,
+  TASK_IMU,
+  TASK_UI,
+  TASK_WIFI,
+  TASK_HTTP,
+  TASK_IMU_TRACE,
+  TASK_SESSION_WRITER,
+  TASK_START,
+  TASK_PLAN_COUNT
+};
+
+// 一个任务的布局
+struct TaskPlan
+{
+  const char *name;
+  int8_t core;          // 固定的核心，tskNO_AFFINITY 为不固定
+  UBaseType_t priority;
+  uint32_t stack;       // 栈大小 (字节)
+};
+
+extern const TaskPlan TASK_PLAN[TASK_PLAN_COUNT];
+
+// 按布局表创建任务 (xTaskCreatePinnedToCore)，失败时句柄置空并返回false
+bool createPlannedTask(TaskPlanId id, TaskFunction_t function, void *arg, TaskHandle_t *handle);
+
+// 任务快照的数组比当前任务数多留的项，取快照前后新建的任务 (如AsyncTCP连接、WiFi重连) 也放得下
+#define TASK_SNAPSHOT_HEADROOM 4
+
+// 所有任务的状态 (uxTaskGetSystemState)，数组按当前任务数在堆上分配
+struct TaskSnapshot
+{
+  TaskStatus_t *tasks;
+  UBaseType_t count;
+  uint32_t totalRunTime;
+  bool truncated; // 分配失败或任务数增长太快，没有取到任务列表
+};
+
+// 取任务快照，用完后调用 freeTaskSnapshot (metrics 和 trace 共用)
+// 没有 configUSE_TRACE_FACILITY 时返回空快照
+bool takeTaskSnapshot(TaskSnapshot &snapshot);
+void freeTaskSnapshot(TaskSnapshot &snapshot);
+
+#endif
@@ -0,0 +1,125 @@
+#include "tempo/tempo.h"
+#include <math.h>
+#include <string.h>
+
+// 样本间隔太大时最多补的帧数，再多就重新对齐 (数据已经中断)
+#define TEMPO_MAX_GAP_FRAMES 4
+
+// 初始化检测器
+void tempoInit(TempoTracker& tracker) {
+  memset(&tracker, 0, sizeof(tracker));
+  // 以120BPM为中心、一个八度为标准差的对数正态先验，抑制倍频和半频的峰
+  for (int i = 0; i < TEMPO_LAG_COUNT; i++) {
+    float bpm = (float)TEMPO_FRAMES_PER_MIN / (TEMPO_MIN_LAG + i);
+    float octaves = log2f(bpm / 120.0f);
+    tracker.prior[i] = expf(-0.5f * octaves * octaves);
+  }
+}
+
+// 在自相关峰值附近找速度
+static void estimate(TempoTracker& t) {
+  int best = -1;
+  float bestScore = 0;
+  for (int i = 0; i < TEMPO_LAG_COUNT; i++) {
+    float score = t.ac[i] * t.prior[i];
+    if (score > bestScore) {
+      bestScore = score;
+      best = i;
+    }
+  }
+  float confidence = (best < 0 || t.energy < TEMPO_MIN_ENERGY) ? 0 : t.ac[best] / t.energy;
+  t.confidence += TEMPO_CONFIDENCE_RATE * (confidence - t.confidence);
+  if (confidence < TEMPO_MIN_CONFIDENCE) {
+    return;
+  }
+
+  // 抛物线插值得到小于一帧的延迟
+  float lag = TEMPO_MIN_LAG + best;
+  if (best > 0 && best < TEMPO_LAG_COUNT - 1) {
+    float a = t.ac[best - 1];
+    float b = t.ac[best];
+    float c = t.ac[best + 1];
+    float denom = a - 2 * b + c;
+    if (denom < 0) {
+      lag += 0.5f * (a - c) / denom;
+    }
+  }
+
+  float bpm = TEMPO_FRAMES_PER_MIN / lag;
+  t.bpm = (t.bpm == 0) ? bpm : t.bpm + TEMPO_SMOOTH_RATE * (bpm - t.bpm);
+}
+
+// 处理一帧包络
+static void processFrame(TempoTracker& t, float envelope) {
+  // 去掉重力和缓慢的姿态变化，只保留包络上升的部分作为起拍强度
+  t.baseline += TEMPO_BASELINE_RATE * (envelope - t.baseline);
+  float e = envelope - t.baseline;
+  float rise = e - t.lastEnvelope;
+  t.lastEnvelope = e;
+  if (rise < 0) {
+    rise = 0;
+  }
+
+  // 去均值后再做自相关，否则所有延迟都有相同的直流分量
+  t.onsetMean += (1.0f - TEMPO_DECAY) * (rise - t.onsetMean);
+  float x = rise - t.onsetMean;
+  t.onset[t.head] = x;
+
+  // 滑动自相关: 每帧对每个延迟做一次乘加
+  t.energy = t.energy * TEMPO_DECAY + x * x;
+  for (int i = 0; i < TEMPO_LAG_COUNT; i++) {
+    float past = t.onset[(t.head - (TEMPO_MIN_LAG + i)) & (TEMPO_HISTORY - 1)];
+    t.ac[i] = t.ac[i] * TEMPO_DECAY + x * past;
+  }
+  t.head = (t.head + 1) & (TEMPO_HISTORY - 1);
+  t.frames++;
+
+  // 历史填满之后才估计
+  if (t.frames > TEMPO_MAX_LAG) {
+    estimate(t);
+  }
+}
+
+// 输入一个样本
+bool tempoUpdate(TempoTracker& tracker, const IMUSample& sample) {
+  const IMUData& d = sample.data;
+  float magnitude = sqrtf(d.accX * d.accX + d.accY * d.accY + d.accZ * d.accZ);
+  uint32_t ts = sample.timestamp;
+
+  if (!tracker.started) {
+    tracker.started = true;
+    tracker.frameStart = ts;
+    tracker.baseline = magnitude;
+    tracker.lastFrame = magnitude;
+  }
+
+  // 结束已经过去的帧，没有样本的帧沿用上一帧的包络
+  bool produced = false;
+  int gapFrames = 0;
+  while (ts - tracker.frameStart >= TEMPO_FRAME_US) {
+    if (gapFrames++ >= TEMPO_MAX_GAP_FRAMES) {
+      tracker.frameStart = ts;
+      break;
+    }
+    if (tracker.frameCount > 0) {
+      tracker.lastFrame = tracker.frameSum / tracker.frameCount;
+    }
+    processFrame(tracker, tracker.lastFrame);
+    tracker.frameStart += TEMPO_FRAME_US;
+    tracker.frameSum = 0;
+    tracker.frameCount = 0;
+    produced = true;
+  }
+
+  tracker.frameSum += magnitude;
+  tracker.frameCount++;
+  return produced;
+}
+
+// 当前速度
+uint16_t tempoBPM(const TempoTracker& tracker) {
+  if (tracker.bpm == 0 || tracker.confidence < TEMPO_MIN_CONFIDENCE) {
+    return 0;
+  }
+  return (uint16_t)(tracker.bpm + 0.5f);
+}
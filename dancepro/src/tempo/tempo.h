@@ -0,0 +1,74 @@
+#ifndef TEMPO_H
+#define TEMPO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "imu/imu_sampler.h"
+
+// 舞蹈速度检测 - 从加速度模长的周期性估计舞者的BPM
+// 样本先按时间戳合成固定帧率的包络，对包络的正向变化 (起拍强度) 做滑动自相关，
+// 在节拍周期范围内找峰值。每个样本的计算量固定，每帧的计算量也固定
+// 只依赖样本数据和时间戳，不依赖硬件，可以用录制的IMU数据回放
+
+// 包络帧长 (us)，100Hz
+#define TEMPO_FRAME_US       10000UL
+#define TEMPO_FRAMES_PER_MIN 6000
+
+// 检测范围 (BPM)
+#define TEMPO_MIN_BPM        60
+#define TEMPO_MAX_BPM        180
+
+// 对应的自相关延迟范围 (帧)
+#define TEMPO_MIN_LAG        (TEMPO_FRAMES_PER_MIN / TEMPO_MAX_BPM)
+#define TEMPO_MAX_LAG        (TEMPO_FRAMES_PER_MIN / TEMPO_MIN_BPM)
+#define TEMPO_LAG_COUNT      (TEMPO_MAX_LAG - TEMPO_MIN_LAG + 1)
+
+// 起拍强度的历史长度 (2的幂，大于最大延迟)
+#define TEMPO_HISTORY        128
+
+// 自相关的遗忘系数 (每帧)，时间常数约4秒
+#define TEMPO_DECAY          0.9975f
+// 去除重力和缓慢姿态变化的基线跟随系数 (每帧)
+#define TEMPO_BASELINE_RATE  0.05f
+// 速度输出的平滑系数 (每帧)
+#define TEMPO_SMOOTH_RATE    0.02f
+// 可信度的平滑系数 (每帧)
+#define TEMPO_CONFIDENCE_RATE 0.05f
+// 可信度门限 (峰值处的归一化自相关)
+#define TEMPO_MIN_CONFIDENCE 0.25f
+// 起拍强度能量下限，低于它认为没有在跳舞 (g^2)
+#define TEMPO_MIN_ENERGY     0.05f
+
+// 检测器状态
+struct TempoTracker {
+  bool started;
+  uint32_t frameStart;     // 当前帧的起始时间 (us)
+  float frameSum;          // 当前帧内加速度模长的和
+  uint16_t frameCount;
+  float lastFrame;         // 上一帧的平均模长
+
+  float baseline;          // 包络基线
+  float lastEnvelope;      // 上一帧的包络 (去基线后)
+  float onset[TEMPO_HISTORY];  // 起拍强度历史 (环形)
+  uint8_t head;            // 下一帧写入的位置
+  uint32_t frames;         // 已处理的帧数
+
+  float onsetMean;         // 起拍强度的均值
+  float energy;            // 延迟0的自相关
+  float ac[TEMPO_LAG_COUNT];     // 各延迟的自相关
+  float prior[TEMPO_LAG_COUNT];  // 速度先验权重，偏向常见的舞曲速度
+
+  float bpm;               // 平滑后的速度，0为还没有可信的估计
+  float confidence;        // 平滑后的可信度 (0-1)
+};
+
+// 初始化检测器
+void tempoInit(TempoTracker& tracker);
+
+// 输入一个样本，完成一帧时返回true
+bool tempoUpdate(TempoTracker& tracker, const IMUSample& sample);
+
+// 当前速度 (取整的BPM)，没有可信的估计时返回0
+uint16_t tempoBPM(const TempoTracker& tracker);
+
+#endif
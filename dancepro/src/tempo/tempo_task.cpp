@@ -0,0 +1,91 @@
+#include "tempo/tempo_task.h"
+#include <M5Unified.h>
+#include <atomic>
+#include "note/beat_clock.h"
+#include "tasks/task_plan.h"
+
+static TaskHandle_t tempoTaskHandle = NULL;
+
+// 检测结果，由检测任务写，其他任务读
+static std::atomic<uint16_t> danceTempo(0);
+static std::atomic<uint8_t> danceConfidence(0);
+// 默认跟随舞者，设置固定的BPM后关闭
+static std::atomic<bool> tempoFollow(true);
+
+// 速度检测任务，按固定周期批量处理新样本
+static void tempoTask(void *pvParameters)
+{
+  static IMUSample samples[32];
+  static TempoTracker tracker;
+  tempoInit(tracker);
+
+  uint32_t cursor = getIMUSampleCursor();
+  TickType_t lastWake = xTaskGetTickCount();
+  TickType_t lastFollow = lastWake;
+  for (;;)
+  {
+    size_t count;
+    while ((count = readIMUSamples(cursor, samples, 32)) > 0)
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        tempoUpdate(tracker, samples[i]);
+      }
+    }
+    uint16_t bpm = tempoBPM(tracker);
+    danceTempo = bpm;
+    danceConfidence = (uint8_t)(tracker.confidence * 100);
+
+    // 跟随舞者: 只在估计可信时更新，舞者停下时保持最后的速度
+    if (tempoFollow && bpm != 0 && xTaskGetTickCount() - lastFollow >= pdMS_TO_TICKS(TEMPO_FOLLOW_MS))
+    {
+      lastFollow = xTaskGetTickCount();
+      if (bpm != getBeatClockTempo())
+      {
+        setBeatClockTempo(bpm);
+        M5.Log.printf("[Tempo] 节拍速度跟随舞者: %u BPM\n", bpm);
+      }
+    }
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(TEMPO_POLL_MS));
+  }
+}
+
+// 启动速度检测任务
+bool startTempoTask()
+{
+  if (tempoTaskHandle != NULL)
+  {
+    return true;
+  }
+  if (!createPlannedTask(TASK_TEMPO, tempoTask, NULL, &tempoTaskHandle))
+  {
+    M5.Log.println("[Tempo] 检测任务创建失败");
+    tempoTaskHandle = NULL;
+    return false;
+  }
+  return true;
+}
+
+// 舞者当前的速度
+uint16_t getDanceTempo()
+{
+  return danceTempo;
+}
+
+// 当前估计的可信度
+uint8_t getDanceTempoConfidence()
+{
+  return danceConfidence;
+}
+
+// 设置是否跟随舞者
+void setTempoFollow(bool follow)
+{
+  tempoFollow = follow;
+}
+
+// 是否跟随舞者
+bool getTempoFollow()
+{
+  return tempoFollow;
+}
@@ -0,0 +1,29 @@
+#ifndef TEMPO_TASK_H
+#define TEMPO_TASK_H
+
+#include <Arduino.h>
+#include "tempo/tempo.h"
+
+// 检测任务的唤醒周期 (ms)
+#define TEMPO_POLL_MS   50
+// 跟随舞者时更新节拍时钟速度的间隔 (ms)
+#define TEMPO_FOLLOW_MS 1000
+
+// 启动速度检测任务，从IMU环形缓冲区读取样本
+bool startTempoTask();
+
+// 舞者当前的速度 (BPM)，没有可信的估计时返回0
+uint16_t getDanceTempo();
+
+// 当前估计的可信度 (0-100)
+uint8_t getDanceTempoConfidence();
+
+// 开启后节拍时钟的速度跟随舞者 (有可信的估计时每秒更新一次)
+// 默认开启: 没有可信的估计时节拍时钟保持当前速度，所以开机后先按默认速度作曲；
+// 控制命令设置数字BPM时关闭，{"bpm":"auto"} 重新开启
+void setTempoFollow(bool follow);
+
+// 节拍时钟是否在跟随舞者
+bool getTempoFollow();
+
+#endif
@@ -0,0 +1,255 @@
+#include "trace/trace.h"
+#include <M5Unified.h>
+#include <esp_timer.h>
+#include <esp_ipc.h>
+#include <xtensa/core-macros.h>
+#include "tasks/task_plan.h"
+
+// 每个核心一个环形缓冲区，写入位置用原子加法分配，同一核心上的中断和任务切换也不会写到同一个位置
+struct TraceRing
+{
+  std::atomic<uint32_t> head; // 已分配的事件总数
+  TraceEvent events[TRACE_RING_SIZE];
+};
+
+static TraceRing traceRings[2];
+static std::atomic<bool> traceRingEnabled(false);
+
+// 导出任务名称时的任务快照 (同时只有一个导出)
+static TaskSnapshot traceTasks = {NULL, 0, 0, false};
+
+static const char *const TRACE_NAMES[TRACE_EVENT_COUNT] = {
+    "imu_sample", "imu_gesture", "ui_frame", "beat_note", "note_compose",
+    "synth_block", "http_loop", "http_request", "http_chunk"};
+
+// 记录一个事件
+// 分配位置和读取周期计数在屏蔽中断的短窗口内完成: 否则高优先级任务可能在两者之间抢占，
+// 同一核心上位置靠前的事件得到更晚的周期计数，导出时往回累加的周期差会回绕
+void IRAM_ATTR traceEvent(TraceEventId id, uint8_t phase, uint32_t arg)
+{
+  if (!traceRingEnabled.load(std::memory_order_relaxed))
+  {
+    return;
+  }
+  UBaseType_t interrupts = portSET_INTERRUPT_MASK_FROM_ISR();
+  uint32_t core = xPortGetCoreID();
+  TraceRing &ring = traceRings[core];
+  uint32_t index = ring.head.fetch_add(1, std::memory_order_relaxed);
+  TraceEvent &event = ring.events[index & (TRACE_RING_SIZE - 1)];
+  event.cycles = XTHAL_GET_CCOUNT();
+  event.id = id;
+  event.phase = phase;
+  event.core = core;
+  event.task = (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle();
+  event.arg = arg;
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(interrupts);
+}
+
+// 初始化并开始记录
+void startTrace()
+{
+  for (int core = 0; core < 2; core++)
+  {
+    traceRings[core].head = 0;
+  }
+  traceRingEnabled = true;
+  // 测量每个事件的开销，之后清空测量时写入的事件
+  const int count = 256;
+  uint32_t start = XTHAL_GET_CCOUNT();
+  for (int i = 0; i < count; i++)
+  {
+    traceEvent(TRACE_HTTP_LOOP, TRACE_PHASE_INSTANT, i);
+  }
+  uint32_t cycles = (XTHAL_GET_CCOUNT() - start) / count;
+  traceRings[xPortGetCoreID()].head = 0;
+  M5.Log.printf("[Trace] 跟踪已启动，每个事件 %u 个周期 (%u ns)\n", (unsigned)cycles,
+                (unsigned)(cycles * 1000 / ESP.getCpuFreqMHz()));
+}
+
+// 暂停/继续记录
+void setTraceEnabled(bool enabled)
+{
+  traceRingEnabled = enabled;
+}
+
+bool isTraceEnabled()
+{
+  return traceRingEnabled;
+}
+
+// 在指定核心上取时间锚点 (esp_ipc在该核心上执行)
+struct TraceAnchor
+{
+  int64_t us;
+  uint32_t cycles;
+};
+
+static void takeAnchor(void *arg)
+{
+  TraceAnchor *anchor = (TraceAnchor *)arg;
+  anchor->cycles = XTHAL_GET_CCOUNT();
+  anchor->us = esp_timer_get_time();
+}
+
+// 开始导出
+void traceExportBegin(TraceExport &state)
+{
+  memset(&state, 0, sizeof(state));
+  freeTaskSnapshot(traceTasks);
+  state.wasEnabled = traceRingEnabled.exchange(false);
+  state.cyclesPerUs = ESP.getCpuFreqMHz();
+  state.first = true;
+  // 两个核心的周期计数不同步，各自取一个与esp_timer对应的锚点
+  for (int core = 0; core < 2; core++)
+  {
+    TraceAnchor anchor;
+    esp_ipc_call_blocking(core, takeAnchor, &anchor);
+    state.anchorUs[core] = anchor.us;
+    state.anchorCycles[core] = anchor.cycles;
+  }
+}
+
+// 结束导出
+void traceExportEnd(TraceExport &state)
+{
+  freeTaskSnapshot(traceTasks);
+  if (state.wasEnabled)
+  {
+    traceRingEnabled = true;
+  }
+}
+
+// 是否已经导出完
+bool traceExportDone(const TraceExport &state)
+{
+  return state.stage >= 4;
+}
+
+// 准备导出一个核心的事件: 从最新的事件往回导出
+static void beginCore(TraceExport &state)
+{
+  uint32_t head = traceRings[state.core].head.load(std::memory_order_relaxed);
+  state.index = head;
+  state.end = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+  state.lastCycles = state.anchorCycles[state.core];
+  state.elapsed = 0;
+}
+
+// 一条记录的最大长度: 开头约170字节，一对任务名称约180字节 (任务名最长 configMAX_TASK_NAME_LEN)，事件约150字节
+#define TRACE_RECORD_MAX 256
+
+// 格式化下一条记录并推进next，返回记录长度 (阶段切换时为0)
+// 时间从锚点往回累加周期差得到，相邻两个事件 (以及最新事件与导出时刻) 的间隔不能超过周期计数回绕时间的一半 (240MHz下约8.9秒)，更大的差按乱序处理
+static int formatRecord(TraceExport &next, char *record, size_t size)
+{
+  switch (next.stage)
+  {
+  case 0:
+    next.stage = 1;
+    next.core = 0;
+    beginCore(next);
+    return snprintf(record, size,
+                    "{\"displayTimeUnit\":\"ms\",\"traceEvents\":["
+                    "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"core 0\"}},"
+                    "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"core 1\"}}");
+  case 1:
+  {
+    if (next.index == next.end)
+    {
+      if (++next.core < 2)
+      {
+        beginCore(next);
+      }
+      else
+      {
+        next.stage = 2;
+      }
+      return 0;
+    }
+    next.index--;
+    const TraceEvent &event = traceRings[next.core].events[next.index & (TRACE_RING_SIZE - 1)];
+    // 导出开始时正在写入的事件可能晚于锚点，周期差为负时按0计算，不回绕
+    int32_t delta = (int32_t)(next.lastCycles - event.cycles);
+    if (delta > 0)
+    {
+      next.elapsed += (uint32_t)delta;
+      next.lastCycles = event.cycles;
+    }
+    int64_t us = next.anchorUs[next.core] - (int64_t)(next.elapsed / next.cyclesPerUs);
+    uint32_t fraction = (uint32_t)(next.elapsed % next.cyclesPerUs) * 1000 / next.cyclesPerUs;
+    // 往回计算的小数部分要从整数部分借位
+    if (fraction > 0)
+    {
+      us--;
+      fraction = 1000 - fraction;
+    }
+    const char *name = event.id < TRACE_EVENT_COUNT ? TRACE_NAMES[event.id] : "unknown";
+    int written = snprintf(record, size, ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld.%03u,\"pid\":%u,\"tid\":%u%s",
+                           name, event.phase, (long long)us, (unsigned)fraction, event.core, (unsigned)event.task,
+                           event.phase == TRACE_PHASE_INSTANT ? ",\"s\":\"t\"" : "");
+    if (written < 0 || (size_t)written >= size)
+    {
+      return written;
+    }
+    int args = snprintf(record + written, size - written, event.arg ? ",\"args\":{\"arg\":%u}}" : "}",
+                        (unsigned)event.arg);
+    return args < 0 ? args : written + args;
+  }
+  case 2:
+  {
+    // 任务名称: 任务可能在两个核心上运行，两个核心都输出
+#if configUSE_TRACE_FACILITY
+    if (next.taskIndex == 0 && traceTasks.tasks == NULL)
+    {
+      takeTaskSnapshot(traceTasks);
+    }
+    if (next.taskIndex < traceTasks.count)
+    {
+      const TaskStatus_t &task = traceTasks.tasks[next.taskIndex++];
+      return snprintf(record, size,
+                      ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}"
+                      ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                      (unsigned)(uintptr_t)task.xHandle, task.pcTaskName,
+                      (unsigned)(uintptr_t)task.xHandle, task.pcTaskName);
+    }
+#endif
+    next.stage = 3;
+    return 0;
+  }
+  default:
+    next.stage = 4;
+    return snprintf(record, size, "]}");
+  }
+}
+
+// 导出下一段JSON: 每条记录先写到临时缓冲区，放得下才复制并推进进度，放不下留到下一段
+size_t traceExportChunk(TraceExport &state, char *buf, size_t len)
+{
+  char record[TRACE_RECORD_MAX];
+  size_t used = 0;
+  while (state.stage < 4)
+  {
+    TraceExport next = state;
+    int written = formatRecord(next, record, sizeof(record));
+    if (written < 0 || (size_t)written >= sizeof(record))
+    {
+      // 超过最大长度的记录丢弃，不输出不完整的JSON
+      M5.Log.println("[Trace] 记录过长，已丢弃");
+      state = next;
+      continue;
+    }
+    if ((size_t)written > len - used)
+    {
+      break;
+    }
+    memcpy(buf + used, record, written);
+    used += written;
+    state = next;
+    // 任务名称输出完后释放快照
+    if (state.stage > 2)
+    {
+      freeTaskSnapshot(traceTasks);
+    }
+  }
+  return used;
+}
@@ -0,0 +1,111 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// 热路径跟踪 - 在关键代码段前后记录16字节的事件，导出为Chrome跟踪格式 (chrome://tracing 或 ui.perfetto.dev)
+// 每个核心一个环形缓冲区，只用一次原子加法分配位置，不加锁，每个事件不到1us，可以在正式固件中保留
+// 导出: GET /api/trace，导出期间暂停记录
+
+// 编译时完全去掉跟踪: build_flags 中加 -DTRACE_COMPILED=0
+#ifndef TRACE_COMPILED
+#define TRACE_COMPILED 1
+#endif
+
+// 每个核心的事件数 (2的幂)
+#define TRACE_RING_SIZE 512
+
+// 事件编号
+enum TraceEventId : uint16_t
+{
+  TRACE_IMU_SAMPLE,   // IMU采样任务读取传感器
+  TRACE_IMU_GESTURE,  // imu_task 处理手势事件
+  TRACE_UI_FRAME,     // ui_task 绘制一帧
+  TRACE_BEAT_NOTE,    // 节拍时钟唤醒音符任务 (瞬时事件)
+  TRACE_NOTE_COMPOSE, // 录制任务生成一个音符
+  TRACE_SYNTH_BLOCK,  // 合成任务渲染一块
+  TRACE_HTTP_LOOP,    // http_task 推送WebSocket数据
+  TRACE_HTTP_REQUEST, // AsyncTCP任务收到一个请求 (瞬时事件)
+  TRACE_HTTP_CHUNK,   // AsyncTCP任务填充一个下载分块
+  TRACE_EVENT_COUNT
+};
+
+// 事件类型，与Chrome跟踪格式的ph相同
+#define TRACE_PHASE_BEGIN   'B'
+#define TRACE_PHASE_END     'E'
+#define TRACE_PHASE_INSTANT 'i'
+
+// 一个事件，16字节
+struct TraceEvent
+{
+  uint32_t cycles; // CPU周期计数 (每个核心各自计数)
+  uint16_t id;     // TraceEventId
+  uint8_t phase;   // TRACE_PHASE_*
+  uint8_t core;
+  uint32_t task;   // 任务句柄
+  uint32_t arg;    // 附加参数 (如音符频率)
+};
+
+// 初始化并开始记录，测量并打印每个事件的开销
+void startTrace();
+
+// 暂停/继续记录
+void setTraceEnabled(bool enabled);
+bool isTraceEnabled();
+
+// 记录一个事件 (任务或中断中都可以调用)
+void traceEvent(TraceEventId id, uint8_t phase, uint32_t arg = 0);
+
+// 作用域事件: 构造时记录开始，析构时记录结束
+struct TraceScope
+{
+  TraceEventId id;
+  explicit TraceScope(TraceEventId id, uint32_t arg = 0) : id(id) { traceEvent(id, TRACE_PHASE_BEGIN, arg); }
+  ~TraceScope() { traceEvent(id, TRACE_PHASE_END); }
+};
+
+#if TRACE_COMPILED
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(id) TraceScope TRACE_CONCAT(traceScope, __LINE__)(id)
+#define TRACE_BEGIN(id) traceEvent(id, TRACE_PHASE_BEGIN)
+#define TRACE_END(id) traceEvent(id, TRACE_PHASE_END)
+#define TRACE_INSTANT(id, arg) traceEvent(id, TRACE_PHASE_INSTANT, arg)
+#else
+#define TRACE_SCOPE(id)
+#define TRACE_BEGIN(id)
+#define TRACE_END(id)
+#define TRACE_INSTANT(id, arg)
+#endif
+
+// 导出进度，导出期间暂停记录
+struct TraceExport
+{
+  uint8_t core;          // 正在导出的核心
+  uint8_t stage;         // 0: 开头 1: 事件 2: 任务名称 3: 结尾 4: 完成
+  bool first;            // 是否还没有输出过事件
+  bool wasEnabled;       // 导出前是否在记录
+  uint32_t index;        // 下一个要导出的事件 (从新到旧)
+  uint32_t end;          // 最旧的事件
+  uint32_t lastCycles;   // 上一个导出事件的周期计数
+  uint64_t elapsed;      // 从锚点往前累计的周期数
+  int64_t anchorUs[2];   // 每个核心的锚点: 同一时刻的esp_timer时间和周期计数
+  uint32_t anchorCycles[2];
+  uint32_t cyclesPerUs;
+  uint32_t taskIndex;    // 下一个要输出名称的任务
+};
+
+// 开始导出: 暂停记录，在每个核心上取时间锚点
+void traceExportBegin(TraceExport &state);
+
+// 导出下一段JSON，返回写入的字节数 (空间放不下一条记录时返回0)
+size_t traceExportChunk(TraceExport &state, char *buf, size_t len);
+
+// 是否已经导出完
+bool traceExportDone(const TraceExport &state);
+
+// 结束导出，恢复记录
+void traceExportEnd(TraceExport &state);
+
+#endif
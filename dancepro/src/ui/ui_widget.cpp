@@ -0,0 +1,89 @@
+#include "ui/ui_widget.h"
+#include <M5Unified.h>
+
+// 初始化控件
+void uiWidgetInit(UIWidget& widget, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t bg, UIDrawFn draw) {
+  widget.bounds = {x, y, w, h};
+  widget.drawn = widget.bounds;
+  widget.value = 0;
+  widget.bg = bg;
+  widget.dirty = true;
+  widget.shown = false;
+  widget.draw = draw;
+}
+
+// 修改状态值
+bool uiWidgetSet(UIWidget& widget, int32_t value) {
+  if (widget.shown && widget.value == value) {
+    return false;
+  }
+  widget.value = value;
+  widget.dirty = true;
+  return true;
+}
+
+// 修改区域
+void uiWidgetMove(UIWidget& widget, int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (widget.bounds.x == x && widget.bounds.y == y && widget.bounds.w == w && widget.bounds.h == h) {
+    return;
+  }
+  widget.bounds = {x, y, w, h};
+  widget.dirty = true;
+}
+
+// 整页重绘后调用
+void uiWidgetInvalidate(UIWidget* widgets, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    widgets[i].dirty = true;
+    widgets[i].shown = false;
+  }
+}
+
+// 清除旧区域中不被新区域覆盖的部分 (最多4个矩形)
+static void clearUncovered(const UIRect& old, const UIRect& cur, uint16_t bg) {
+  int oldRight = old.x + old.w;
+  int oldBottom = old.y + old.h;
+  int top = max((int)old.y, (int)cur.y);
+  int bottom = min(oldBottom, cur.y + cur.h);
+  int left = max((int)old.x, (int)cur.x);
+  int right = min(oldRight, cur.x + cur.w);
+
+  // 没有重叠，整个旧区域都要清除
+  if (top >= bottom || left >= right) {
+    M5.Display.fillRect(old.x, old.y, old.w, old.h, bg);
+    return;
+  }
+  if (top > old.y) M5.Display.fillRect(old.x, old.y, old.w, top - old.y, bg);
+  if (bottom < oldBottom) M5.Display.fillRect(old.x, bottom, old.w, oldBottom - bottom, bg);
+  if (left > old.x) M5.Display.fillRect(old.x, top, left - old.x, bottom - top, bg);
+  if (right < oldRight) M5.Display.fillRect(right, top, oldRight - right, bottom - top, bg);
+}
+
+// 刷新需要重绘的控件
+size_t uiFlush(UIWidget* widgets, size_t count) {
+  size_t redrawn = 0;
+  for (size_t i = 0; i < count; i++) {
+    UIWidget& widget = widgets[i];
+    if (!widget.dirty) {
+      continue;
+    }
+    // 第一个需要重绘的控件才开始SPI事务，没有变化时不占用总线
+    if (redrawn == 0) {
+      M5.Display.startWrite();
+    }
+    if (widget.shown) {
+      clearUncovered(widget.drawn, widget.bounds, widget.bg);
+    }
+    if (widget.draw != NULL && widget.bounds.w > 0 && widget.bounds.h > 0) {
+      widget.draw(widget);
+    }
+    widget.drawn = widget.bounds;
+    widget.dirty = false;
+    widget.shown = true;
+    redrawn++;
+  }
+  if (redrawn > 0) {
+    M5.Display.endWrite();
+  }
+  return redrawn;
+}
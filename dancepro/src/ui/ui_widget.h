@@ -0,0 +1,47 @@
+#ifndef UI_WIDGET_H
+#define UI_WIDGET_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 保留模式的界面控件 - 页面只更新控件的状态值，状态变化的控件才重绘
+// 所有重绘在一次 startWrite/endWrite 中完成，只刷新变化的区域
+
+// 矩形区域
+struct UIRect {
+  int16_t x, y, w, h;
+};
+
+struct UIWidget;
+
+// 绘制函数，必须在 widget.bounds 内覆盖上次绘制的内容 (用背景色画掉旧的部分)，
+// 这样不需要先清除整个区域再绘制，不会闪烁
+typedef void (*UIDrawFn)(const UIWidget& widget);
+
+// 控件
+struct UIWidget {
+  UIRect bounds;   // 当前区域
+  UIRect drawn;    // 上次绘制的区域
+  int32_t value;   // 状态值，由页面定义含义
+  uint16_t bg;     // 背景色，用于清除移动后留下的区域
+  bool dirty;      // 需要重绘
+  bool shown;      // 已经绘制到屏幕上
+  UIDrawFn draw;
+};
+
+// 初始化控件
+void uiWidgetInit(UIWidget& widget, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t bg, UIDrawFn draw);
+
+// 修改状态值，变化时标记重绘，返回是否变化
+bool uiWidgetSet(UIWidget& widget, int32_t value);
+
+// 修改区域，旧区域中不再覆盖的部分会在刷新时清除
+void uiWidgetMove(UIWidget& widget, int16_t x, int16_t y, int16_t w, int16_t h);
+
+// 整页重绘后调用，所有控件在下次刷新时重绘，不再清除旧区域
+void uiWidgetInvalidate(UIWidget* widgets, size_t count);
+
+// 刷新所有需要重绘的控件，返回重绘的控件数
+size_t uiFlush(UIWidget* widgets, size_t count);
+
+#endif
@@ -1,11 +1,12 @@
 #include "wifi/my_wifi.h"
 #include <M5Unified.h>
+#include "event/event_bus.h"
 
 // WiFi管理对象
 WiFiManager wifiManager;
 
-// 当前WiFi状态
-WiFiStatus wifiStatus = WIFI_INIT;
+// 当前WiFi状态 (WiFi任务和回调写入，UI任务读取)
+volatile WiFiStatus wifiStatus = WIFI_INIT;
 
 // AP模式配置 - 全局可见
 const char* AP_NAME = "ESP32_S3R"; // AP热点名称
@@ -22,6 +23,14 @@ WiFiStatus getWiFiStatus() {
     return wifiStatus;
 }
 
+// 修改WiFi状态，发生变化时发布事件
+static void setWiFiStatus(WiFiStatus status) {
+    if (wifiStatus != status) {
+        wifiStatus = status;
+        postEvent(EVENT_WIFI_CHANGED);
+    }
+}
+
 // 获取IP地址
 String getLocalIP() {
     if (WiFi.status() == WL_CONNECTED) {
@@ -35,18 +44,18 @@ String getLocalIP() {
 void startConfigPortal() {
     M5.Log.printf("[WiFi] 启动AP模式: %s\n", AP_NAME);
     
-    wifiStatus = WIFI_AP_MODE;
+    setWiFiStatus(WIFI_AP_MODE);
     
     // 启动配置门户，阻塞直到配置完成或超时
     if (wifiManager.startConfigPortal(AP_NAME, AP_PASSWORD)) {
         // 用户完成配置
         M5.Log.printf("[WiFi] 配网成功，已连接到: %s\n", WiFi.SSID().c_str());
         M5.Log.printf("[WiFi] IP地址: %s\n", WiFi.localIP().toString().c_str());
-        wifiStatus = WIFI_CONNECTED;
+        setWiFiStatus(WIFI_CONNECTED);
     } else {
         // 配置门户超时
         M5.Log.println("[WiFi] 配置门户超时，未能配网");
-        wifiStatus = WIFI_FAILED;
+        setWiFiStatus(WIFI_FAILED);
     }
 }
 
@@ -68,17 +77,24 @@ void setupWiFi() {
     // 注册WiFi保存回调
     wifiManager.setSaveConfigCallback([]() {
         M5.Log.println("[WiFi] 配网信息已保存到闪存，正在连接...");
-        wifiStatus = WIFI_CONNECTING;
+        setWiFiStatus(WIFI_CONNECTING);
     });
     
     // 开始尝试连接
     M5.Log.println("[WiFi] 尝试连接已保存的WiFi...");
-    wifiStatus = WIFI_CONNECTING;
+    setWiFiStatus(WIFI_CONNECTING);
     connectStartTime = millis();
     
     // 非阻塞方式开始连接
     WiFi.begin();
 
+    // 驱动层连接状态变化时唤醒WiFi任务，不必等到下一次检查
+    WiFi.onEvent([](WiFiEvent_t event, WiFiEventInfo_t info) {
+        if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP || event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+            postEvent(EVENT_WIFI_LINK);
+        }
+    });
+
     // 在setupWiFi()函数中添加以下代码
     wifiManager.setCaptivePortalEnable(true);
     wifiManager.setAPCallback([](WiFiManager* wifiManager) {
@@ -95,12 +111,12 @@ void monitorWiFi() {
             if (WiFi.status() == WL_CONNECTED) {
                 M5.Log.printf("[WiFi] 已连接到WiFi: %s\n", WiFi.SSID().c_str());
                 M5.Log.printf("[WiFi] IP地址: %s\n", WiFi.localIP().toString().c_str());
-                wifiStatus = WIFI_CONNECTED;
+                setWiFiStatus(WIFI_CONNECTED);
             }
             // 检查是否连接超时
             else if (millis() - connectStartTime > CONNECT_TIMEOUT) {
                 M5.Log.println("[WiFi] 连接超时");
-                wifiStatus = WIFI_FAILED;
+                setWiFiStatus(WIFI_FAILED);
             }
             break;
             
@@ -108,11 +124,11 @@ void monitorWiFi() {
             // 检查是否断开连接
             if (WiFi.status() != WL_CONNECTED) {
                 M5.Log.println("[WiFi] 连接已断开");
-                wifiStatus = WIFI_FAILED;
+                setWiFiStatus(WIFI_FAILED);
                 
                 // 尝试重新连接
                 M5.Log.println("[WiFi] 尝试重新连接...");
-                wifiStatus = WIFI_CONNECTING;
+                setWiFiStatus(WIFI_CONNECTING);
                 connectStartTime = millis();
                 WiFi.begin();
             }
@@ -124,7 +140,7 @@ void monitorWiFi() {
             if (millis() - lastRetryTime > 10000) { // 10秒后重试
                 lastRetryTime = millis();
                 M5.Log.println("[WiFi] 尝试重新连接...");
-                wifiStatus = WIFI_CONNECTING;
+                setWiFiStatus(WIFI_CONNECTING);
                 connectStartTime = millis();
                 WiFi.begin();
             }
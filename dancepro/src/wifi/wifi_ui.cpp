@@ -1,5 +1,6 @@
 #include "wifi/wifi_ui.h"
 #include "wifi/my_wifi.h"
+#include "ui/ui_widget.h"
 
 // Color definitions
 #define COLOR_BG        0x0000  // Black background
@@ -15,9 +16,28 @@
 static WiFiStatus lastDisplayedStatus = (WiFiStatus)-1; // Invalid initial value to force first draw
 static unsigned long lastUpdateTime = 0;
 
+// Progress bar layout
+#define PROGRESS_X      14
+#define PROGRESS_Y      70
+#define PROGRESS_WIDTH  100
+#define PROGRESS_HEIGHT 8
+
 // 全局判断变量，用于控制清屏和重绘
 bool wifiUIRedrawNeeded = true;
 
+// Progress bar fill, value = filled width | color << 16
+static UIWidget progressWidget;
+static bool progressReady = false;
+
+// Draw only the inside of the outline: filled part then the empty part
+static void drawProgress(const UIWidget& widget) {
+    const UIRect& r = widget.bounds;
+    int progress = widget.value & 0xFFFF;
+    uint16_t color = (uint16_t)(widget.value >> 16);
+    M5.Display.fillRect(r.x, r.y, progress, r.h, color);
+    M5.Display.fillRect(r.x + progress, r.y, r.w - progress, r.h, COLOR_BG);
+}
+
 // Display WiFi connection UI with built-in anti-flicker logic
 void displayWiFiUI(WiFiStatus status) {
     unsigned long currentTime = millis();
@@ -35,8 +55,14 @@ void displayWiFiUI(WiFiStatus status) {
         return;
     }
     
+    if (!progressReady) {
+        uiWidgetInit(progressWidget, PROGRESS_X + 1, PROGRESS_Y + 1, PROGRESS_WIDTH - 2, PROGRESS_HEIGHT - 2, COLOR_BG, drawProgress);
+        progressReady = true;
+    }
+    
     // FULL REDRAW
     if (wifiUIRedrawNeeded) {
+        M5.Display.startWrite();
         // Clear screen
         M5.Display.fillScreen(COLOR_BG);
         
@@ -162,12 +188,7 @@ void displayWiFiUI(WiFiStatus status) {
             M5.Display.print("Please wait");
             
             // Progress bar outline
-            int barWidth = 100;
-            int barHeight = 8;
-            int barX = 14;
-            int barY = 70;
-            
-            M5.Display.drawRect(barX, barY, barWidth, barHeight, COLOR_TEXT);
+            M5.Display.drawRect(PROGRESS_X, PROGRESS_Y, PROGRESS_WIDTH, PROGRESS_HEIGHT, COLOR_TEXT);
             
             // Draw bottom status bar
             M5.Display.fillRect(0, 112, 128, 16, COLOR_ACCENT);
@@ -219,12 +240,7 @@ void displayWiFiUI(WiFiStatus status) {
             M5.Display.print("Starting WiFi...");
             
             // Progress bar outline
-            int barWidth = 100;
-            int barHeight = 8;
-            int barX = 14;
-            int barY = 70;
-            
-            M5.Display.drawRect(barX, barY, barWidth, barHeight, COLOR_TEXT);
+            M5.Display.drawRect(PROGRESS_X, PROGRESS_Y, PROGRESS_WIDTH, PROGRESS_HEIGHT, COLOR_TEXT);
             
             // Draw bottom status bar
             M5.Display.fillRect(0, 112, 128, 16, COLOR_LIGHT_BG);
@@ -233,8 +249,11 @@ void displayWiFiUI(WiFiStatus status) {
             M5.Display.print("Please wait");
         }
         
+        M5.Display.endWrite();
+        
         // Mark full redraw as complete
         wifiUIRedrawNeeded = false;
+        uiWidgetInvalidate(&progressWidget, 1);
         lastDisplayedStatus = status;
     }
     
@@ -242,14 +261,8 @@ void displayWiFiUI(WiFiStatus status) {
     if (updateDynamicElements) {
         // Only update dynamic elements for states that need animation
         if (status == WIFI_CONNECTING || status == WIFI_INIT) {
-            // Progress bar parameters
-            int barWidth = 100;
-            int barHeight = 8;
-            int barX = 14;
-            int barY = 70;
-            
             // Calculate progress based on time
-            int maxProgress = barWidth - 2;
+            int maxProgress = PROGRESS_WIDTH - 2;
             int progress;
             
             // Different animation styles for different states
@@ -263,12 +276,10 @@ void displayWiFiUI(WiFiStatus status) {
                 progress = (currentTime / 100) % maxProgress;
             }
             
-            // Clear old progress
-            M5.Display.fillRect(barX + 1, barY + 1, barWidth - 2, barHeight - 2, COLOR_BG);
-            
-            // Draw new progress
+            // Redraw only when the fill changed, no clear-then-draw flicker
             uint16_t progressColor = (status == WIFI_CONNECTING) ? COLOR_ACCENT : COLOR_TITLE;
-            M5.Display.fillRect(barX + 1, barY + 1, progress, barHeight - 2, progressColor);
+            uiWidgetSet(progressWidget, progress | ((int32_t)progressColor << 16));
+            uiFlush(&progressWidget, 1);
         }
         
         // Update timestamp for dynamic elements
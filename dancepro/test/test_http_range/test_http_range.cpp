@@ -0,0 +1,75 @@
+#include <unity.h>
+#include "http/http_range.h"
+
+// Range头部解析测试 (pio test -e native)
+
+#define SIZE 1000
+
+static uint32_t first;
+static uint32_t last;
+
+void setUp() {
+    first = 0xFFFFFFFF;
+    last = 0xFFFFFFFF;
+}
+
+void tearDown() {
+}
+
+// bytes=a-b，结尾超出时截断
+static void test_closed_range() {
+    TEST_ASSERT_EQUAL(1, parseRange("bytes=0-99", SIZE, first, last));
+    TEST_ASSERT_EQUAL(0, first);
+    TEST_ASSERT_EQUAL(99, last);
+    TEST_ASSERT_EQUAL(1, parseRange("bytes=0-5000", SIZE, first, last));
+    TEST_ASSERT_EQUAL(0, first);
+    TEST_ASSERT_EQUAL(SIZE - 1, last);
+    TEST_ASSERT_EQUAL(1, parseRange("bytes=999-999", SIZE, first, last));
+    TEST_ASSERT_EQUAL(999, first);
+    TEST_ASSERT_EQUAL(999, last);
+}
+
+// bytes=a- 到文件末尾
+static void test_open_range() {
+    TEST_ASSERT_EQUAL(1, parseRange("bytes=100-", SIZE, first, last));
+    TEST_ASSERT_EQUAL(100, first);
+    TEST_ASSERT_EQUAL(SIZE - 1, last);
+}
+
+// bytes=-n 最后n个字节，超过文件大小时发送全部
+static void test_suffix_range() {
+    TEST_ASSERT_EQUAL(1, parseRange("bytes=-50", SIZE, first, last));
+    TEST_ASSERT_EQUAL(SIZE - 50, first);
+    TEST_ASSERT_EQUAL(SIZE - 1, last);
+    TEST_ASSERT_EQUAL(1, parseRange("bytes=-5000", SIZE, first, last));
+    TEST_ASSERT_EQUAL(0, first);
+    TEST_ASSERT_EQUAL(SIZE - 1, last);
+}
+
+// 超出范围返回-1 (416)
+static void test_unsatisfiable() {
+    TEST_ASSERT_EQUAL(-1, parseRange("bytes=1000-", SIZE, first, last));
+    TEST_ASSERT_EQUAL(-1, parseRange("bytes=1000-2000", SIZE, first, last));
+    TEST_ASSERT_EQUAL(-1, parseRange("bytes=-0", SIZE, first, last));
+}
+
+// 不支持的格式返回0 (忽略，发送全部)，不修改输出
+static void test_ignored() {
+    const char* const values[] = {"bytes=5-2", "bytes=0-1,5-6", "items=0-1", "bytes=abc", "bytes=-", "bytes=1-x",
+                                  "bytes=-5x", ""};
+    for (const char* value : values) {
+        TEST_ASSERT_EQUAL(0, parseRange(value, SIZE, first, last));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFF, first);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFF, last);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_closed_range);
+    RUN_TEST(test_open_range);
+    RUN_TEST(test_suffix_range);
+    RUN_TEST(test_unsatisfiable);
+    RUN_TEST(test_ignored);
+    return UNITY_END();
+}
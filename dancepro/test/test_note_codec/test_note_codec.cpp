@@ -0,0 +1,127 @@
+#include <unity.h>
+#include "note/note_codec.h"
+
+// 二进制音符格式的编码/解码测试 (pio test -e native)
+
+#define MAX_EVENTS 16
+
+static uint8_t buf[NOTE_CODEC_SIZE(MAX_EVENTS)];
+static NoteEvent decoded[MAX_EVENTS];
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// 编码后再解码，返回解码的音符数
+static int roundTrip(const NoteEvent* events, size_t count) {
+    size_t size = noteEncodeAll(events, count, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(NOTE_CODEC_SIZE(count), size);
+    return noteDecodeAll(buf, size, decoded, MAX_EVENTS);
+}
+
+// 表中的频率原样还原，时值在栅格上时不变
+static void test_round_trip_exact() {
+    const NoteEvent events[] = {{523, 300}, {659, 150}, {784, 75}, {262, 600}};
+    TEST_ASSERT_EQUAL(4, roundTrip(events, 4));
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(events[i].note, decoded[i].note);
+        TEST_ASSERT_EQUAL(events[i].duration, decoded[i].duration);
+    }
+}
+
+// 休止符编码为令牌0，不改变"上一个音符"
+static void test_rests() {
+    const NoteEvent events[] = {{0, 300}, {440, 300}, {0, 150}, {0, 25}, {466, 300}};
+    TEST_ASSERT_EQUAL(5, roundTrip(events, 5));
+    TEST_ASSERT_EQUAL(0, buf[NOTE_CODEC_HEADER_SIZE]);
+    TEST_ASSERT_EQUAL(0, decoded[0].note);
+    TEST_ASSERT_EQUAL(440, decoded[1].note);
+    TEST_ASSERT_EQUAL(0, decoded[2].note);
+    TEST_ASSERT_EQUAL(0, decoded[3].note);
+    TEST_ASSERT_EQUAL(25, decoded[3].duration);
+    // 休止符之后的音高差相对休止符之前的音符 (A4 -> A#4，+1半音，zigzag 2，令牌3)
+    TEST_ASSERT_EQUAL(3, buf[NOTE_CODEC_HEADER_SIZE + 4 * NOTE_CODEC_EVENT_SIZE]);
+    TEST_ASSERT_EQUAL(466, decoded[4].note);
+}
+
+// 最大音高差: C2 <-> B6 (±59半音)
+static void test_max_semitone_delta() {
+    const NoteEvent events[] = {{noteIndexToFreq(0), 100},
+                                {noteIndexToFreq(NOTE_INDEX_COUNT - 1), 100},
+                                {noteIndexToFreq(0), 100}};
+    TEST_ASSERT_EQUAL(3, roundTrip(events, 3));
+    // +59 -> zigzag 118 -> 令牌119，-59 -> zigzag 117 -> 令牌118
+    TEST_ASSERT_EQUAL(119, buf[NOTE_CODEC_HEADER_SIZE + 1 * NOTE_CODEC_EVENT_SIZE]);
+    TEST_ASSERT_EQUAL(118, buf[NOTE_CODEC_HEADER_SIZE + 2 * NOTE_CODEC_EVENT_SIZE]);
+    TEST_ASSERT_EQUAL(65, decoded[0].note);
+    TEST_ASSERT_EQUAL(1976, decoded[1].note);
+    TEST_ASSERT_EQUAL(65, decoded[2].note);
+}
+
+// 不在表中的频率取最接近的半音
+static void test_nearest_semitone() {
+    TEST_ASSERT_EQUAL(noteFreqToIndex(523), noteFreqToIndex(530));
+    TEST_ASSERT_EQUAL(0, noteFreqToIndex(1));
+    TEST_ASSERT_EQUAL(NOTE_INDEX_COUNT - 1, noteFreqToIndex(5000));
+}
+
+// 时值四舍五入到栅格，超过255格截断
+static void test_duration_quantisation_and_clamp() {
+    const NoteEvent events[] = {{523, 12}, {523, 13}, {523, 37}, {523, 38}, {523, 255 * NOTE_CODEC_GRID_MS},
+                                {523, 60000}};
+    TEST_ASSERT_EQUAL(6, roundTrip(events, 6));
+    TEST_ASSERT_EQUAL(0, decoded[0].duration);
+    TEST_ASSERT_EQUAL(NOTE_CODEC_GRID_MS, decoded[1].duration);
+    TEST_ASSERT_EQUAL(NOTE_CODEC_GRID_MS, decoded[2].duration);
+    TEST_ASSERT_EQUAL(2 * NOTE_CODEC_GRID_MS, decoded[3].duration);
+    TEST_ASSERT_EQUAL(255 * NOTE_CODEC_GRID_MS, decoded[4].duration);
+    TEST_ASSERT_EQUAL(255 * NOTE_CODEC_GRID_MS, decoded[5].duration);
+}
+
+// 头部错误、长度不符或音高越界时拒绝
+static void test_reject_invalid() {
+    const NoteEvent events[] = {{523, 300}, {659, 300}};
+    size_t size = noteEncodeAll(events, 2, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(2, noteDecodeAll(buf, size, decoded, MAX_EVENTS));
+
+    buf[0] = 'X';
+    TEST_ASSERT_EQUAL(-1, noteDecodeAll(buf, size, decoded, MAX_EVENTS));
+    buf[0] = 'D';
+    buf[2] = NOTE_CODEC_VERSION + 1;
+    TEST_ASSERT_EQUAL(-1, noteDecodeAll(buf, size, decoded, MAX_EVENTS));
+    buf[2] = NOTE_CODEC_VERSION;
+    buf[3] = 0;
+    TEST_ASSERT_EQUAL(-1, noteDecodeAll(buf, size, decoded, MAX_EVENTS));
+    buf[3] = NOTE_CODEC_GRID_MS;
+
+    TEST_ASSERT_EQUAL(-1, noteDecodeAll(buf, size - 1, decoded, MAX_EVENTS));
+    TEST_ASSERT_EQUAL(-1, noteDecodeAll(buf, NOTE_CODEC_HEADER_SIZE - 1, decoded, MAX_EVENTS));
+    TEST_ASSERT_EQUAL(-1, noteDecodeAll(buf, size, decoded, 1));
+
+    // 从C4向下超出C2
+    buf[NOTE_CODEC_HEADER_SIZE] = 2 * 30;
+    TEST_ASSERT_EQUAL(-1, noteDecodeAll(buf, size, decoded, MAX_EVENTS));
+}
+
+// 缓冲区不足时编码返回0
+static void test_encode_buffer_too_small() {
+    const NoteEvent events[] = {{523, 300}, {659, 300}};
+    TEST_ASSERT_EQUAL(0, noteEncodeAll(events, 2, buf, NOTE_CODEC_SIZE(2) - 1));
+    NoteEncoder encoder;
+    TEST_ASSERT_EQUAL(0, noteEncodeHeader(encoder, 2, buf, NOTE_CODEC_HEADER_SIZE - 1));
+    TEST_ASSERT_EQUAL(0, noteEncodeEvent(encoder, events[0], buf, NOTE_CODEC_EVENT_SIZE - 1));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_exact);
+    RUN_TEST(test_rests);
+    RUN_TEST(test_max_semitone_delta);
+    RUN_TEST(test_nearest_semitone);
+    RUN_TEST(test_duration_quantisation_and_clamp);
+    RUN_TEST(test_reject_invalid);
+    RUN_TEST(test_encode_buffer_too_small);
+    return UNITY_END();
+}
@@ -0,0 +1,182 @@
+#include <unity.h>
+#include <LittleFS.h>
+#include <unistd.h>
+#include "note/note_session_store.h"
+#include "note/note_codec.h"
+
+// 录制会话存储测试 (pio test -e native)，LittleFS替身把文件放在 .pio/test_fs 下
+// endSessionStore + initSessionStore 模拟重启
+
+static NoteSession sessions[RECORDER_SESSIONS];
+static uint8_t data[NOTE_CODEC_SIZE(NOTE_LOG_CAPACITY)];
+static NoteEvent decoded[NOTE_LOG_CAPACITY];
+
+void setUp() {
+    nativeSetFSRoot(".pio/test_fs");
+    endSessionStore();
+    LittleFS.begin(true);
+    LittleFS.mkdir(SESSION_DIR);
+    LittleFS.remove(SESSION_INDEX_PATH);
+    LittleFS.remove(SESSION_LOG_PATH);
+    TEST_ASSERT_TRUE(initSessionStore());
+}
+
+void tearDown() {
+}
+
+// 填充一个会话: 表中的音高和栅格上的时值，解码后不变
+static NoteSession& makeSession(int slot, uint32_t id, size_t count) {
+    NoteSession& session = sessions[slot];
+    noteLogReset(session.log);
+    for (size_t i = 0; i < count; i++) {
+        NoteEvent event = {noteIndexToFreq((id * 7 + i) % NOTE_INDEX_COUNT), (uint16_t)((1 + i % 8) * NOTE_CODEC_GRID_MS)};
+        if (i % 5 == 4) {
+            event.note = 0;
+        }
+        noteLogAppend(session.log, event);
+    }
+    session.id = id;
+    session.seed = id * 1000;
+    session.startTime = 1700000000 + id;
+    session.duration = count * 100;
+    session.tempo = 120;
+    return session;
+}
+
+// 按编号读取一个会话的全部数据并与录制的音符比较
+static void checkSession(const NoteSession& session) {
+    SessionInfo info;
+    uint32_t generation;
+    TEST_ASSERT_EQUAL(SESSION_FOUND, findSession(session.id, info, generation, 0));
+    TEST_ASSERT_EQUAL(session.log.count, info.count);
+    TEST_ASSERT_EQUAL(session.seed, info.seed);
+    TEST_ASSERT_EQUAL(session.duration, info.duration);
+    TEST_ASSERT_EQUAL(session.tempo, info.tempo);
+    TEST_ASSERT_EQUAL(NOTE_CODEC_SIZE(session.log.count), info.length);
+    // 分多次读取，与分块下载相同
+    uint32_t offset = 0;
+    int len;
+    while ((len = readSessionData(info, generation, offset, data + offset, 100, 0)) > 0) {
+        offset += len;
+    }
+    TEST_ASSERT_EQUAL(info.length, offset);
+    TEST_ASSERT_EQUAL((int)session.log.count, noteDecodeAll(data, offset, decoded, NOTE_LOG_CAPACITY));
+    for (size_t i = 0; i < session.log.count; i++) {
+        TEST_ASSERT_EQUAL(session.log.events[i].note, decoded[i].note);
+        TEST_ASSERT_EQUAL(session.log.events[i].duration, decoded[i].duration);
+    }
+}
+
+// 保存两个会话
+static void appendTwo() {
+    const NoteSession* batch[2] = {&makeSession(0, 1, 300), &makeSession(1, 2, 500)};
+    TEST_ASSERT_TRUE(appendSessions(batch, 2));
+}
+
+// 追加后可以读取，重启后索引相同
+static void test_append_and_reload() {
+    appendTwo();
+    TEST_ASSERT_EQUAL(2, getSessionCount());
+    TEST_ASSERT_EQUAL(3, getNextSessionId());
+    uint32_t used = getSessionStoreUsed();
+    TEST_ASSERT_EQUAL(NOTE_CODEC_SIZE(300) + NOTE_CODEC_SIZE(500), used);
+    checkSession(sessions[0]);
+    checkSession(sessions[1]);
+
+    endSessionStore();
+    TEST_ASSERT_TRUE(initSessionStore());
+    TEST_ASSERT_EQUAL(2, getSessionCount());
+    TEST_ASSERT_EQUAL(3, getNextSessionId());
+    TEST_ASSERT_EQUAL(used, getSessionStoreUsed());
+    SessionInfo info;
+    TEST_ASSERT_EQUAL(SESSION_FOUND, getSessionAt(1, info, 0));
+    TEST_ASSERT_EQUAL(2, info.id);
+    TEST_ASSERT_EQUAL(SESSION_MISSING, getSessionAt(2, info, 0));
+    checkSession(sessions[0]);
+    checkSession(sessions[1]);
+}
+
+// 日志写到一半断电: 超出日志的会话丢弃，索引被修复，之后的会话从文件末尾追加
+static void test_torn_log() {
+    appendTwo();
+    TEST_ASSERT_EQUAL(0, truncate(nativeFSPath(SESSION_LOG_PATH).c_str(), NOTE_CODEC_SIZE(300) + 10));
+    endSessionStore();
+    TEST_ASSERT_TRUE(initSessionStore());
+    TEST_ASSERT_EQUAL(1, getSessionCount());
+    TEST_ASSERT_EQUAL(2, getNextSessionId());
+    checkSession(sessions[0]);
+    File index = LittleFS.open(SESSION_INDEX_PATH, FILE_READ);
+    TEST_ASSERT_EQUAL(4 + sizeof(SessionInfo), index.size());
+    index.close();
+
+    const NoteSession* batch[1] = {&makeSession(1, 2, 200)};
+    TEST_ASSERT_TRUE(appendSessions(batch, 1));
+    endSessionStore();
+    TEST_ASSERT_TRUE(initSessionStore());
+    TEST_ASSERT_EQUAL(2, getSessionCount());
+    checkSession(sessions[0]);
+    checkSession(sessions[1]);
+}
+
+// 索引写到一半断电: 不完整的记录丢弃，日志中多出的数据不再使用
+static void test_torn_index() {
+    appendTwo();
+    TEST_ASSERT_EQUAL(0, truncate(nativeFSPath(SESSION_INDEX_PATH).c_str(), 4 + sizeof(SessionInfo) + 10));
+    endSessionStore();
+    TEST_ASSERT_TRUE(initSessionStore());
+    TEST_ASSERT_EQUAL(1, getSessionCount());
+    SessionInfo info;
+    uint32_t generation;
+    TEST_ASSERT_EQUAL(SESSION_MISSING, findSession(2, info, generation, 0));
+
+    const NoteSession* batch[1] = {&makeSession(1, 2, 250)};
+    TEST_ASSERT_TRUE(appendSessions(batch, 1));
+    TEST_ASSERT_EQUAL(2, getSessionCount());
+    checkSession(sessions[0]);
+    checkSession(sessions[1]);
+    endSessionStore();
+    TEST_ASSERT_TRUE(initSessionStore());
+    TEST_ASSERT_EQUAL(2, getSessionCount());
+    checkSession(sessions[1]);
+}
+
+// 索引头部错误时不加载
+static void test_bad_index_header() {
+    appendTwo();
+    File index = LittleFS.open(SESSION_INDEX_PATH, FILE_WRITE);
+    const uint8_t header[4] = {'D', 'S', SESSION_INDEX_VERSION + 1, 0};
+    index.write(header, sizeof(header));
+    index.close();
+    endSessionStore();
+    TEST_ASSERT_FALSE(initSessionStore());
+    TEST_ASSERT_EQUAL(0, getSessionCount());
+}
+
+// 清空后下载中的会话读取失败，编号继续递增
+static void test_clear() {
+    appendTwo();
+    SessionInfo info;
+    uint32_t generation;
+    TEST_ASSERT_EQUAL(SESSION_FOUND, findSession(1, info, generation, 0));
+    TEST_ASSERT_TRUE(clearSessions());
+    TEST_ASSERT_EQUAL(0, getSessionCount());
+    TEST_ASSERT_EQUAL(0, getSessionStoreUsed());
+    TEST_ASSERT_FALSE(LittleFS.exists(SESSION_LOG_PATH));
+    TEST_ASSERT_FALSE(LittleFS.exists(SESSION_INDEX_PATH));
+    TEST_ASSERT_EQUAL(-1, readSessionData(info, generation, 0, data, 100, 0));
+    TEST_ASSERT_EQUAL(3, getNextSessionId());
+
+    const NoteSession* batch[1] = {&makeSession(0, 3, 100)};
+    TEST_ASSERT_TRUE(appendSessions(batch, 1));
+    checkSession(sessions[0]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_append_and_reload);
+    RUN_TEST(test_torn_log);
+    RUN_TEST(test_torn_index);
+    RUN_TEST(test_bad_index_header);
+    RUN_TEST(test_clear);
+    return UNITY_END();
+}